@@ -0,0 +1,258 @@
+/**
+ * a tiny google-benchmark style harness.
+ * every benchmark runs its timed loop until it has taken at least the minimum time,
+ * then one result row is reported per benchmark, as csv or json.
+ * a row may carry named counters besides the timing, such as the depth of a tree.
+ */
+#ifndef SJTU_BENCHMARK_HPP
+#define SJTU_BENCHMARK_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+typedef std::chrono::steady_clock Clock;
+typedef std::vector<std::pair<std::string, double>> Counters;
+
+// keeps the compiler from optimizing a computed value away.
+template<class T>
+inline void do_not_optimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+class State {
+public:
+  State(size_t n, double min_seconds): n(n), iterations_(0), elapsed_(0),
+    min_elapsed_(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(min_seconds))),
+    items_(0), running_(false) {}
+
+  // usage: while(state.keep_running()) { ... one iteration ... }
+  bool keep_running() {
+    if(running_) {
+      elapsed_ += Clock::now() - start_;
+      running_ = false;
+      ++iterations_;
+    }
+    if(iterations_ != 0 && elapsed_ >= min_elapsed_) return false;
+    running_ = true;
+    start_ = Clock::now();
+    return true;
+  }
+  // excludes setup work inside an iteration from the timing.
+  void pause_timing() {
+    elapsed_ += Clock::now() - start_;
+  }
+  void resume_timing() {
+    start_ = Clock::now();
+  }
+  // the number of operations done per iteration, used for ns_per_op.
+  void set_items_per_iteration(size_t items) {
+    items_ = items;
+  }
+  // reports a value measured by the benchmark along with its timing.
+  void set_counter(const std::string &name, double value) {
+    for(auto &counter : counters_) {
+      if(counter.first == name) {
+        counter.second = value;
+        return;
+      }
+    }
+    counters_.emplace_back(name, value);
+  }
+  const Counters& counters() const {
+    return counters_;
+  }
+  size_t iterations() const {
+    return iterations_;
+  }
+  double ns_per_op() const {
+    size_t ops = iterations_ * (items_ == 0 ? 1 : items_);
+    return std::chrono::duration<double, std::nano>(elapsed_).count() / ops;
+  }
+
+  const size_t n;
+
+private:
+  size_t iterations_;
+  Clock::duration elapsed_, min_elapsed_;
+  Clock::time_point start_;
+  size_t items_;
+  bool running_;
+  Counters counters_;
+};
+
+/**
+ * the durations of single operations in nanoseconds, for their percentiles.
+ * below 16ns every nanosecond has its own bucket; above, every power of two is split into 16,
+ * so a percentile is reported at most 1/16 above the true one.
+ */
+class LatencyHistogram {
+public:
+  LatencyHistogram(): counts_(kBuckets, 0), total_(0), max_(0) {}
+
+  void add(double ns) {
+    unsigned long long value = ns < 0 ? 0 : static_cast<unsigned long long>(ns);
+    ++counts_[bucket(value)];
+    ++total_;
+    if(ns > max_) max_ = ns;
+  }
+  // the upper bound of the bucket holding the given fraction of the samples, e.g. 0.99.
+  double percentile(double fraction) const {
+    size_t rank = static_cast<size_t>(fraction * total_), seen = 0;
+    for(size_t i = 0; i < kBuckets; ++i) {
+      seen += counts_[i];
+      if(seen > rank) return static_cast<double>(upper_bound(i));
+    }
+    return max_;
+  }
+  double max() const {
+    return max_;
+  }
+  // sets the counters p50_ns, p99_ns, p99.9_ns, p99.99_ns and max_ns.
+  template<class State>
+  void report(State &state) const {
+    state.set_counter("p50_ns", percentile(0.5));
+    state.set_counter("p99_ns", percentile(0.99));
+    state.set_counter("p99.9_ns", percentile(0.999));
+    state.set_counter("p99.99_ns", percentile(0.9999));
+    state.set_counter("max_ns", max_);
+  }
+
+private:
+  static constexpr size_t kSubBuckets = 16, kBuckets = kSubBuckets * 61;
+
+  static size_t floor_log2(unsigned long long x) {
+    size_t res = 0;
+    while(x >>= 1) ++res;
+    return res;
+  }
+  static size_t bucket(unsigned long long value) {
+    if(value < kSubBuckets) return value;
+    size_t shift = floor_log2(value) - 4;
+    return kSubBuckets * (shift + 1) + ((value >> shift) - kSubBuckets);
+  }
+  static unsigned long long upper_bound(size_t index) {
+    if(index < kSubBuckets) return index;
+    size_t shift = index / kSubBuckets - 1;
+    return ((index % kSubBuckets + kSubBuckets + 1) << shift) - 1;
+  }
+
+  std::vector<size_t> counts_;
+  size_t total_;
+  double max_;
+};
+
+struct Benchmark {
+  std::string container, operation, type, impl;
+  size_t n;
+  void (*function)(State &);
+
+  std::string name() const {
+    return container + "/" + operation + "/" + type + "/" + impl + "/" + std::to_string(n);
+  }
+};
+
+inline std::vector<Benchmark>& registry() {
+  static std::vector<Benchmark> benchmarks;
+  return benchmarks;
+}
+
+// container/operation/type/impl/n identifies one result row.
+inline void add(const char *container, const char *operation, const char *type,
+  const char *impl, size_t n, void (*function)(State &)) {
+  registry().push_back(Benchmark{container, operation, type, impl, n, function});
+}
+
+struct Result {
+  const Benchmark *benchmark;
+  size_t iterations;
+  double ns_per_op;
+  Counters counters;
+};
+
+// the counters as name=value pairs joined by sep.
+inline std::string format_counters(const Counters &counters, const char *sep) {
+  std::string res;
+  char value[64];
+  for(const auto &counter : counters) {
+    std::snprintf(value, sizeof(value), "%.3f", counter.second);
+    if(!res.empty()) res += sep;
+    res += counter.first + "=" + value;
+  }
+  return res;
+}
+
+inline void print_csv(const std::vector<Result> &results) {
+  std::printf("name,container,operation,type,impl,n,iterations,ns_per_op,counters\n");
+  for(const Result &result : results) {
+    const Benchmark &b = *result.benchmark;
+    std::printf("%s,%s,%s,%s,%s,%zu,%zu,%.3f,%s\n", b.name().c_str(), b.container.c_str(),
+      b.operation.c_str(), b.type.c_str(), b.impl.c_str(), b.n, result.iterations, result.ns_per_op,
+      format_counters(result.counters, ";").c_str());
+  }
+}
+
+inline void print_json(const std::vector<Result> &results) {
+  std::printf("{\n  \"benchmarks\": [\n");
+  for(size_t i = 0; i < results.size(); ++i) {
+    const Benchmark &b = *results[i].benchmark;
+    std::printf("    {\"name\": \"%s\", \"container\": \"%s\", \"operation\": \"%s\", "
+      "\"type\": \"%s\", \"impl\": \"%s\", \"n\": %zu, \"iterations\": %zu, \"ns_per_op\": %.3f",
+      b.name().c_str(), b.container.c_str(), b.operation.c_str(), b.type.c_str(), b.impl.c_str(),
+      b.n, results[i].iterations, results[i].ns_per_op);
+    for(const auto &counter : results[i].counters)
+      std::printf(", \"%s\": %.3f", counter.first.c_str(), counter.second);
+    std::printf("}%s\n", (i + 1 == results.size()) ? "" : ",");
+  }
+  std::printf("  ]\n}\n");
+}
+
+// options: --filter=<substring of name> --min-time=<seconds> --format=csv|json --list
+inline int run(int argc, char *argv[]) {
+  std::string filter, format = "csv";
+  double min_seconds = 0.1;
+  bool list_only = false;
+  for(int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    if(std::strncmp(arg, "--filter=", 9) == 0) filter = arg + 9;
+    else if(std::strncmp(arg, "--min-time=", 11) == 0) min_seconds = std::atof(arg + 11);
+    else if(std::strncmp(arg, "--format=", 9) == 0) format = arg + 9;
+    else if(std::strcmp(arg, "--list") == 0) list_only = true;
+    else {
+      std::fprintf(stderr, "usage: %s [--filter=substr] [--min-time=seconds] [--format=csv|json] [--list]\n", argv[0]);
+      return 1;
+    }
+  }
+  if(format != "csv" && format != "json") {
+    std::fprintf(stderr, "unknown format: %s\n", format.c_str());
+    return 1;
+  }
+  std::vector<Result> results;
+  for(const Benchmark &b : registry()) {
+    if(!filter.empty() && b.name().find(filter) == std::string::npos) continue;
+    if(list_only) {
+      std::printf("%s\n", b.name().c_str());
+      continue;
+    }
+    State state(b.n, min_seconds);
+    b.function(state);
+    results.push_back(Result{&b, state.iterations(), state.ns_per_op(), state.counters()});
+    std::fprintf(stderr, "%-56s %12.3f ns/op  %s\n", b.name().c_str(), state.ns_per_op(),
+      format_counters(state.counters(), " ").c_str());
+  }
+  if(list_only) return 0;
+  if(format == "json") print_json(results);
+  else print_csv(results);
+  return 0;
+}
+
+}
+
+#endif
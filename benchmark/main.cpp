@@ -0,0 +1,13 @@
+#include "benchmark.hpp"
+#include "vector_bench.hpp"
+#include "map_bench.hpp"
+#include "priority_queue_bench.hpp"
+#include "parallel_bench.hpp"
+
+int main(int argc, char *argv[]) {
+  bench::register_vector_benchmarks();
+  bench::register_map_benchmarks();
+  bench::register_priority_queue_benchmarks();
+  bench::register_parallel_benchmarks();
+  return bench::run(argc, argv);
+}
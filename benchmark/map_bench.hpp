@@ -0,0 +1,339 @@
+#ifndef SJTU_MAP_BENCH_HPP
+#define SJTU_MAP_BENCH_HPP
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "map/src/map.hpp"
+#include "map/src/flat_map.hpp"
+#include "benchmark.hpp"
+#include "types.hpp"
+
+namespace bench {
+
+// keys are int, the element type is the mapped value.
+template<class T> using sjtu_map = sjtu::map<int, T>;
+template<class T> using std_map = std::map<int, T>;
+template<class T> using sjtu_flat_map = sjtu::flat_map<int, T>;
+// the same order as std::less, but it keeps flat_map on the scalar search.
+struct ScalarLess {
+  bool operator()(int lhs, int rhs) const {
+    return lhs < rhs;
+  }
+};
+template<class T> using sjtu_flat_map_scalar = sjtu::flat_map<int, T, ScalarLess>;
+
+template<class T>
+void map_insert(sjtu_map<T> &m, int key) {
+  m.insert(typename sjtu_map<T>::value_type(key, Element<T>::make(key)));
+}
+template<class T>
+void map_insert(std_map<T> &m, int key) {
+  m.insert(typename std_map<T>::value_type(key, Element<T>::make(key)));
+}
+template<class T>
+void map_insert(sjtu_flat_map<T> &m, int key) {
+  m.insert(typename sjtu_flat_map<T>::value_type(key, Element<T>::make(key)));
+}
+template<class T>
+void map_insert(sjtu_flat_map_scalar<T> &m, int key) {
+  m.insert(typename sjtu_flat_map_scalar<T>::value_type(key, Element<T>::make(key)));
+}
+template<class T>
+void map_erase(sjtu_map<T> &m, int key) {
+  m.erase(m.find(key));
+}
+template<class T>
+void map_erase(std_map<T> &m, int key) {
+  m.erase(m.find(key));
+}
+template<class T>
+void map_erase(sjtu_flat_map<T> &m, int key) {
+  m.erase(m.find(key));
+}
+
+template<class Map>
+void fill_map(Map &m, const std::vector<int> &keys) {
+  for(int key : keys) map_insert(m, key);
+}
+
+template<template<class> class Map, class T>
+void map_insert_random(State &state) {
+  std::vector<int> keys = permutation(state.n);
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    Map<T> m;
+    fill_map(m, keys);
+    do_not_optimize(m.size());
+  }
+}
+
+template<template<class> class Map, class T>
+void map_erase_random(State &state) {
+  std::vector<int> keys = permutation(state.n), order = permutation(state.n, 1);
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    state.pause_timing();
+    Map<T> m;
+    fill_map(m, keys);
+    state.resume_timing();
+    for(int key : order) map_erase(m, key);
+    do_not_optimize(m.size());
+  }
+}
+
+template<template<class> class Map, class T>
+void map_find(State &state) {
+  std::vector<int> keys = permutation(state.n), order = permutation(state.n, 1);
+  Map<T> m;
+  fill_map(m, keys);
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    for(int key : order) do_not_optimize(m.find(key));
+  }
+}
+
+template<template<class> class Map, class T>
+void map_iterate(State &state) {
+  Map<T> m;
+  fill_map(m, permutation(state.n));
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    for(typename Map<T>::iterator it = m.begin(); it != m.end(); ++it)
+      do_not_optimize(it->first);
+  }
+}
+
+template<template<class> class Map, class T>
+void map_copy(State &state) {
+  Map<T> m;
+  fill_map(m, permutation(state.n));
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    Map<T> copy(m);
+    do_not_optimize(copy.size());
+  }
+}
+
+template<class T>
+void register_map_type() {
+  size_t n = Element<T>::size();
+  const char *type = Element<T>::name();
+  add("map", "insert_random", type, "sjtu", n, map_insert_random<sjtu_map, T>);
+  add("map", "insert_random", type, "std", n, map_insert_random<std_map, T>);
+  add("map", "erase_random", type, "sjtu", n, map_erase_random<sjtu_map, T>);
+  add("map", "erase_random", type, "std", n, map_erase_random<std_map, T>);
+  add("map", "find", type, "sjtu", n, map_find<sjtu_map, T>);
+  add("map", "find", type, "std", n, map_find<std_map, T>);
+  add("map", "iterate", type, "sjtu", n, map_iterate<sjtu_map, T>);
+  add("map", "iterate", type, "std", n, map_iterate<std_map, T>);
+  add("map", "copy", type, "sjtu", n, map_copy<sjtu_map, T>);
+  add("map", "copy", type, "std", n, map_copy<std_map, T>);
+}
+
+// flat_map pays O(n) per random insertion, so it is compared at the sizes it is meant for.
+inline void register_flat_map_benchmarks() {
+  const size_t sizes[] = {64, 1024, 8192, 65536};
+  for(size_t n : sizes) {
+    add("flat_map", "insert_random", "int", "sjtu_flat", n, map_insert_random<sjtu_flat_map, int>);
+    add("flat_map", "insert_random", "int", "sjtu", n, map_insert_random<sjtu_map, int>);
+    add("flat_map", "insert_random", "int", "std", n, map_insert_random<std_map, int>);
+    add("flat_map", "erase_random", "int", "sjtu_flat", n, map_erase_random<sjtu_flat_map, int>);
+    add("flat_map", "erase_random", "int", "sjtu", n, map_erase_random<sjtu_map, int>);
+    add("flat_map", "find", "int", "sjtu_flat", n, map_find<sjtu_flat_map, int>);
+    add("flat_map", "find", "int", "sjtu_flat_scalar", n, map_find<sjtu_flat_map_scalar, int>);
+    add("flat_map", "find", "int", "sjtu", n, map_find<sjtu_map, int>);
+    add("flat_map", "find", "int", "std", n, map_find<std_map, int>);
+    add("flat_map", "iterate", "int", "sjtu_flat", n, map_iterate<sjtu_flat_map, int>);
+    add("flat_map", "iterate", "int", "sjtu", n, map_iterate<sjtu_map, int>);
+  }
+}
+
+// keys that are expensive to compare, so the comparisons per lookup dominate.
+// they share a long prefix, as big numbers of similar size or hierarchical names do.
+template<class K> struct HeavyKey;
+template<> struct HeavyKey<Util::Bint> {
+  static const char* name() { return "Bint"; }
+  static Util::Bint make(int x) {
+    char digits[64];
+    std::snprintf(digits, sizeof(digits), "31415926535897932384626433832795%08d", x);
+    return Util::Bint(std::string(digits));
+  }
+};
+template<> struct HeavyKey<std::string> {
+  static const char* name() { return "string"; }
+  static std::string make(int x) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "/home/user/projects/stlite/build/%08d", x);
+    return std::string(name);
+  }
+};
+// the same order as std::less<std::string>, without the three-way comparison it is given.
+struct StringLess {
+  bool operator()(const std::string &lhs, const std::string &rhs) const {
+    return lhs < rhs;
+  }
+};
+
+template<class Map, class K>
+void map_key_insert(State &state) {
+  std::vector<int> order = permutation(state.n);
+  std::vector<K> keys;
+  for(int x : order) keys.push_back(HeavyKey<K>::make(x));
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    Map m;
+    for(const K &key : keys) m[key] = 0;
+    do_not_optimize(m.size());
+  }
+}
+
+template<class Map, class K>
+void map_key_find(State &state) {
+  std::vector<int> order = permutation(state.n), lookups = permutation(state.n, 1);
+  std::vector<K> keys;
+  for(int x : order) keys.push_back(HeavyKey<K>::make(x));
+  Map m;
+  for(const K &key : keys) m[key] = 0;
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    for(int i : lookups) do_not_optimize(m.find(keys[i]));
+  }
+}
+
+template<class K, class Map>
+void register_map_key(const char *impl) {
+  const size_t n = 1 << 14;
+  add("map_key", "insert_random", HeavyKey<K>::name(), impl, n, map_key_insert<Map, K>);
+  add("map_key", "find", HeavyKey<K>::name(), impl, n, map_key_find<Map, K>);
+}
+
+inline void register_map_key_benchmarks() {
+  register_map_key<Util::Bint, sjtu::map<Util::Bint, int>>("sjtu");
+  register_map_key<Util::Bint, std::map<Util::Bint, int>>("std");
+  register_map_key<std::string, sjtu::map<std::string, int>>("sjtu");
+  register_map_key<std::string, sjtu::map<std::string, int, StringLess>>("sjtu_two_way");
+  register_map_key<std::string, std::map<std::string, int>>("std");
+}
+
+// the keys are looked up in batches of 256, as a request handler would.
+// find calls find() on each key; batch hands the batch to find_batch().
+template<bool kBatch>
+void map_find_batch(State &state) {
+  const size_t kBatchSize = 256;
+  std::vector<int> keys = permutation(state.n), order = permutation(state.n, 1);
+  sjtu_map<int> m;
+  fill_map(m, keys);
+  std::vector<sjtu_map<int>::iterator> found(kBatchSize);
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    for(size_t i = 0; i + kBatchSize <= order.size(); i += kBatchSize) {
+      if(kBatch) {
+        m.find_batch(order.begin() + i, order.begin() + i + kBatchSize, found.begin());
+      } else {
+        for(size_t j = 0; j < kBatchSize; ++j) found[j] = m.find(order[i + j]);
+      }
+      do_not_optimize(found[0]);
+    }
+  }
+}
+
+inline void register_map_batch_benchmarks() {
+  // the larger map doesn't fit in the last level cache.
+  for(size_t n : {size_t(1) << 16, size_t(1) << 23}) {
+    add("map_batch", "find", "int", "sjtu_find", n, map_find_batch<false>);
+    add("map_batch", "find", "int", "sjtu_batch", n, map_find_batch<true>);
+    add("map_batch", "find", "int", "std", n, map_find<std_map, int>);
+  }
+}
+
+// the balance policies side by side. the keys are inserted in random or ascending order,
+// as ascending keys make the tallest red-black trees.
+template<class Balance> using balanced_map = sjtu::map<int, int, std::less<int>, Balance>;
+
+template<class Balance>
+void fill_balanced_map(balanced_map<Balance> &m, size_t n, bool ascending) {
+  if(ascending) {
+    for(size_t i = 0; i < n; ++i) m[static_cast<int>(i)] = 0;
+  } else {
+    for(int key : permutation(n)) m[key] = 0;
+  }
+}
+
+// every lookup hits; the shape of the tree is reported as counters.
+template<class Balance, bool kAscending>
+void map_balance_find(State &state) {
+  std::vector<int> order = permutation(state.n, 1);
+  balanced_map<Balance> m;
+  fill_balanced_map(m, state.n, kAscending);
+  sjtu::map_shape shape = m.shape();
+  state.set_counter("average_depth", shape.average_depth);
+  state.set_counter("height", shape.height);
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    for(int key : order) do_not_optimize(m.find(key));
+  }
+}
+
+template<class Balance, bool kAscending>
+void map_balance_insert(State &state) {
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    balanced_map<Balance> m;
+    fill_balanced_map(m, state.n, kAscending);
+    do_not_optimize(m.size());
+  }
+}
+
+template<class Balance>
+void map_balance_erase(State &state) {
+  std::vector<int> order = permutation(state.n, 1);
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    state.pause_timing();
+    balanced_map<Balance> m;
+    fill_balanced_map(m, state.n, false);
+    state.resume_timing();
+    for(int key : order) m.erase(m.find(key));
+    do_not_optimize(m.size());
+  }
+}
+
+template<class Balance>
+void register_map_balance(const char *impl) {
+  for(size_t n : {size_t(1) << 10, size_t(1) << 16, size_t(1) << 20}) {
+    add("map_balance", "find_random_keys", "int", impl, n, map_balance_find<Balance, false>);
+    add("map_balance", "find_ascending_keys", "int", impl, n, map_balance_find<Balance, true>);
+    add("map_balance", "insert_random", "int", impl, n, map_balance_insert<Balance, false>);
+    add("map_balance", "insert_ascending", "int", impl, n, map_balance_insert<Balance, true>);
+    add("map_balance", "erase_random", "int", impl, n, map_balance_erase<Balance>);
+  }
+}
+
+inline void register_map_balance_benchmarks() {
+  register_map_balance<sjtu::red_black_balance>("red_black");
+  register_map_balance<sjtu::avl_balance>("avl");
+}
+
+inline void register_map_benchmarks() {
+  register_map_type<int>();
+  // 10^7 random keys, far beyond the cache, where rebalancing walks cold nodes.
+  const size_t kLarge = 10000000;
+  add("map", "insert_random", "int", "sjtu", kLarge, map_insert_random<sjtu_map, int>);
+  add("map", "insert_random", "int", "std", kLarge, map_insert_random<std_map, int>);
+  add("map", "erase_random", "int", "sjtu", kLarge, map_erase_random<sjtu_map, int>);
+  add("map", "erase_random", "int", "std", kLarge, map_erase_random<std_map, int>);
+  register_map_type<Integer>();
+  register_map_type<Util::Bint>();
+  register_map_type<Matrix>();
+  register_flat_map_benchmarks();
+  register_map_key_benchmarks();
+  register_map_batch_benchmarks();
+  register_map_balance_benchmarks();
+}
+
+}
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef SJTU_PARALLEL_BENCH_HPP
+#define SJTU_PARALLEL_BENCH_HPP
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "vector/src/parallel.hpp"
+#include "benchmark.hpp"
+#include "types.hpp"
+
+namespace bench {
+
+// serial: the plain loops or std::sort on one thread.
+// pool_0: the parallel versions on a pool without workers, which shows their overhead.
+// pool_all: the parallel versions on the shared pool, one thread per core.
+enum class Runner { serial, pool_0, pool_all };
+
+template<Runner kRunner>
+sjtu::thread_pool& runner_pool() {
+  static sjtu::thread_pool no_workers(0);
+  return kRunner == Runner::pool_all ? sjtu::thread_pool::instance() : no_workers;
+}
+
+inline sjtu::vector<int> shuffled_vector(size_t n) {
+  std::vector<int> positions = permutation(n);
+  sjtu::vector<int> v;
+  v.reserve(n);
+  for(size_t i = 0; i < n; ++i) v.push_back(positions[i]);
+  return v;
+}
+
+template<Runner kRunner>
+void parallel_sort_bench(State &state) {
+  sjtu::vector<int> source = shuffled_vector(state.n);
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    state.pause_timing();
+    sjtu::vector<int> v(source);
+    state.resume_timing();
+    if(kRunner == Runner::serial) std::sort(v.data(), v.data() + v.size());
+    else sjtu::parallel_sort(v, std::less<int>(), runner_pool<kRunner>());
+    do_not_optimize(v.data()[0]);
+  }
+}
+
+// a few dozen flops per element, so that the loop isn't bound by memory bandwidth alone.
+inline double heavy(double x) {
+  for(int i = 0; i < 16; ++i) x = x * 0.999 + 1.0 / (x + 1.0);
+  return x;
+}
+
+template<Runner kRunner>
+void parallel_for_each_bench(State &state) {
+  sjtu::vector<double> v;
+  for(size_t i = 0; i < state.n; ++i) v.push_back(static_cast<double>(i));
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    if(kRunner == Runner::serial) {
+      double *data = v.data();
+      for(size_t i = 0; i < v.size(); ++i) data[i] = heavy(data[i]);
+    } else {
+      sjtu::parallel_for_each(v, [](double &x) { x = heavy(x); }, runner_pool<kRunner>());
+    }
+    do_not_optimize(v.data()[0]);
+  }
+}
+
+template<Runner kRunner>
+void parallel_transform_bench(State &state) {
+  sjtu::vector<int> in = shuffled_vector(state.n);
+  sjtu::vector<double> out;
+  for(size_t i = 0; i < state.n; ++i) out.push_back(0);
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    if(kRunner == Runner::serial) {
+      const int *src = in.data();
+      double *dst = out.data();
+      for(size_t i = 0; i < in.size(); ++i) dst[i] = heavy(src[i]);
+    } else {
+      sjtu::transform(in, out, [](int x) { return heavy(x); }, runner_pool<kRunner>());
+    }
+    do_not_optimize(out.data()[0]);
+  }
+}
+
+template<Runner kRunner>
+void parallel_reduce_bench(State &state) {
+  sjtu::vector<int> v = shuffled_vector(state.n);
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    long long sum = 0;
+    if(kRunner == Runner::serial) {
+      const int *data = v.data();
+      for(size_t i = 0; i < v.size(); ++i) sum += data[i];
+    } else {
+      sum = sjtu::reduce(v, 0LL, std::plus<long long>(), runner_pool<kRunner>());
+    }
+    do_not_optimize(sum);
+  }
+}
+
+template<Runner kRunner>
+void register_parallel_runner(const char *impl) {
+  add("parallel", "sort", "int", impl, 1 << 22, parallel_sort_bench<kRunner>);
+  add("parallel", "for_each", "double", impl, 1 << 22, parallel_for_each_bench<kRunner>);
+  add("parallel", "transform", "int", impl, 1 << 22, parallel_transform_bench<kRunner>);
+  add("parallel", "reduce", "int", impl, 1 << 24, parallel_reduce_bench<kRunner>);
+}
+
+inline void register_parallel_benchmarks() {
+  register_parallel_runner<Runner::serial>("serial");
+  register_parallel_runner<Runner::pool_0>("pool_0");
+  register_parallel_runner<Runner::pool_all>("pool_all");
+}
+
+}
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef SJTU_PRIORITY_QUEUE_BENCH_HPP
+#define SJTU_PRIORITY_QUEUE_BENCH_HPP
+
+#include <functional>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "priority_queue/src/priority_queue.hpp"
+#include "priority_queue/src/radix_heap.hpp"
+#include "benchmark.hpp"
+#include "types.hpp"
+
+namespace bench {
+
+template<class T> using sjtu_pq = sjtu::priority_queue<Keyed<T>, KeyedLess>;
+template<class T> using std_pq = std::priority_queue<Keyed<T>, std::vector<Keyed<T>>, KeyedLess>;
+
+template<class T>
+void pq_merge(sjtu_pq<T> &lhs, sjtu_pq<T> &rhs) {
+  lhs.merge(rhs);
+}
+// std::priority_queue has no merge, so the other queue is pushed element by element.
+template<class T>
+void pq_merge(std_pq<T> &lhs, std_pq<T> &rhs) {
+  while(!rhs.empty()) {
+    lhs.push(rhs.top());
+    rhs.pop();
+  }
+}
+
+template<class T, class Queue>
+void fill_pq(Queue &q, const std::vector<int> &keys, size_t from, size_t to) {
+  for(size_t i = from; i < to; ++i) q.push(Keyed<T>(keys[i]));
+}
+
+template<template<class> class Queue, class T>
+void pq_push(State &state) {
+  std::vector<int> keys = permutation(state.n);
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    Queue<T> q;
+    fill_pq<T>(q, keys, 0, keys.size());
+    do_not_optimize(q.size());
+  }
+}
+
+template<template<class> class Queue, class T>
+void pq_pop(State &state) {
+  std::vector<int> keys = permutation(state.n);
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    state.pause_timing();
+    Queue<T> q;
+    fill_pq<T>(q, keys, 0, keys.size());
+    state.resume_timing();
+    while(!q.empty()) q.pop();
+    do_not_optimize(q.size());
+  }
+}
+
+template<template<class> class Queue, class T>
+void pq_merge(State &state) {
+  std::vector<int> keys = permutation(state.n);
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    state.pause_timing();
+    Queue<T> lhs, rhs;
+    fill_pq<T>(lhs, keys, 0, keys.size() / 2);
+    fill_pq<T>(rhs, keys, keys.size() / 2, keys.size());
+    state.resume_timing();
+    pq_merge(lhs, rhs);
+    do_not_optimize(lhs.size());
+  }
+}
+
+template<template<class> class Queue, class T>
+void pq_copy(State &state) {
+  Queue<T> q;
+  std::vector<int> keys = permutation(state.n);
+  fill_pq<T>(q, keys, 0, keys.size());
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    Queue<T> copy(q);
+    do_not_optimize(copy.size());
+  }
+}
+
+// monotone event trace: keep n events pending,
+// pop the earliest one and schedule a new one after it.
+template<class Queue>
+void pq_monotone(State &state) {
+  std::mt19937_64 rng(1);
+  std::uniform_int_distribution<unsigned long long> delay(1, 1000);
+  Queue q;
+  for(size_t i = 0; i < state.n; ++i) q.push(delay(rng));
+  const size_t steps = 1 << 16;
+  state.set_items_per_iteration(steps);
+  while(state.keep_running()) {
+    for(size_t i = 0; i < steps; ++i) {
+      unsigned long long now = q.top();
+      q.pop();
+      q.push(now + delay(rng));
+    }
+  }
+}
+
+template<class T>
+void register_pq_type() {
+  size_t n = Element<T>::size();
+  const char *type = Element<T>::name();
+  add("priority_queue", "push", type, "sjtu", n, pq_push<sjtu_pq, T>);
+  add("priority_queue", "push", type, "std", n, pq_push<std_pq, T>);
+  add("priority_queue", "pop", type, "sjtu", n, pq_pop<sjtu_pq, T>);
+  add("priority_queue", "pop", type, "std", n, pq_pop<std_pq, T>);
+  add("priority_queue", "merge", type, "sjtu", n, pq_merge<sjtu_pq, T>);
+  add("priority_queue", "merge", type, "std", n, pq_merge<std_pq, T>);
+  add("priority_queue", "copy", type, "sjtu", n, pq_copy<sjtu_pq, T>);
+  add("priority_queue", "copy", type, "std", n, pq_copy<std_pq, T>);
+}
+
+inline void register_priority_queue_benchmarks() {
+  register_pq_type<int>();
+  register_pq_type<Integer>();
+  register_pq_type<Util::Bint>();
+  register_pq_type<Matrix>();
+  typedef unsigned long long Time;
+  const size_t pendings[] = {1 << 4, 1 << 10, 1 << 16, 1 << 20};
+  for(size_t pending : pendings) {
+    add("priority_queue", "monotone", "uint64", "sjtu_radix_heap", pending,
+      pq_monotone<sjtu::radix_heap<Time>>);
+    add("priority_queue", "monotone", "uint64", "sjtu", pending,
+      pq_monotone<sjtu::priority_queue<Time, std::greater<Time>>>);
+    add("priority_queue", "monotone", "uint64", "std", pending,
+      pq_monotone<std::priority_queue<Time, std::vector<Time>, std::greater<Time>>>);
+  }
+}
+
+}
+
+#endif
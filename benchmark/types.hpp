@@ -0,0 +1,80 @@
+/**
+ * element types shared by the benchmarks: int and the classes used by the tests.
+ * class-bint.hpp defines its functions out of line, so this header
+ * (as well as the suites including it) belongs to a single translation unit.
+ */
+#ifndef SJTU_BENCHMARK_TYPES_HPP
+#define SJTU_BENCHMARK_TYPES_HPP
+
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include "vector/data/class-integer.hpp"
+#include "vector/data/class-matrix.hpp"
+#include "vector/data/class-bint.hpp"
+
+namespace bench {
+
+typedef Diamond::Matrix<double> Matrix;
+
+// name: how the type shows up in the results.
+// size: the default number of elements, so that every type runs in similar time.
+// make: builds the element standing for x.
+template<class T> struct Element;
+
+template<> struct Element<int> {
+  static const char* name() { return "int"; }
+  static size_t size() { return 1 << 16; }
+  static int make(int x) { return x; }
+};
+
+template<> struct Element<Integer> {
+  static const char* name() { return "Integer"; }
+  static size_t size() { return 1 << 16; }
+  static Integer make(int x) { return Integer(x); }
+};
+
+template<> struct Element<Util::Bint> {
+  static const char* name() { return "Bint"; }
+  static size_t size() { return 1 << 9; }
+  static Util::Bint make(int x) { return Util::Bint(x); }
+};
+
+template<> struct Element<Matrix> {
+  static const char* name() { return "Matrix"; }
+  static size_t size() { return 1 << 12; }
+  static Matrix make(int x) { return Matrix(4, 4, static_cast<double>(x)); }
+};
+
+// gives every element type an order, since Integer and Matrix have none.
+template<class T>
+struct Keyed {
+  int key;
+  T value;
+
+  explicit Keyed(int key_): key(key_), value(Element<T>::make(key_)) {}
+};
+
+struct KeyedLess {
+  template<class T>
+  bool operator()(const Keyed<T> &lhs, const Keyed<T> &rhs) const {
+    return lhs.key < rhs.key;
+  }
+};
+
+// a fixed pseudo-random permutation of [0, n).
+inline std::vector<int> permutation(size_t n, unsigned seed = 2024) {
+  std::vector<int> res(n);
+  for(size_t i = 0; i < n; ++i) res[i] = static_cast<int>(i);
+  std::mt19937 rng(seed);
+  for(size_t i = n; i > 1; --i) {
+    size_t j = rng() % i;
+    int tmp = res[i - 1]; res[i - 1] = res[j]; res[j] = tmp;
+  }
+  return res;
+}
+
+}
+
+#endif
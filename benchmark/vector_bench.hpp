@@ -0,0 +1,321 @@
+#ifndef SJTU_VECTOR_BENCH_HPP
+#define SJTU_VECTOR_BENCH_HPP
+
+#include <chrono>
+#include <vector>
+
+#include "vector/src/vector.hpp"
+#include "vector/src/small_vector.hpp"
+#include "vector/src/segmented_vector.hpp"
+#include "vector/src/gap_buffer.hpp"
+#include "vector/src/deamortized_vector.hpp"
+#include "vector/src/huge_page_storage.hpp"
+#include "benchmark.hpp"
+#include "types.hpp"
+
+namespace bench {
+
+template<class T> using sjtu_vector = sjtu::vector<T>;
+template<class T> using std_vector = std::vector<T>;
+template<class T> using sjtu_small_vector = sjtu::small_vector<T, 8>;
+template<class T> using sjtu_segmented_vector = sjtu::segmented_vector<T>;
+template<class T> using sjtu_gap_buffer = sjtu::gap_buffer<T>;
+template<class T> using sjtu_deamortized_vector = sjtu::deamortized_vector<T>;
+template<class T> using sjtu_aligned_vector = sjtu::vector<T, sjtu::aligned_heap_storage<64>>;
+template<class T> using sjtu_thp_vector = sjtu::vector<T, sjtu::transparent_huge_page_storage>;
+template<class T> using sjtu_hugetlb_vector = sjtu::vector<T, sjtu::explicit_huge_page_storage>;
+
+template<class T, class Vector>
+void fill_vector(Vector &v, size_t n) {
+  for(size_t i = 0; i < n; ++i) v.push_back(Element<T>::make(static_cast<int>(i)));
+}
+
+template<template<class> class Vector, class T>
+void vector_push_back(State &state) {
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    Vector<T> v;
+    fill_vector<T>(v, state.n);
+    do_not_optimize(v.size());
+  }
+}
+
+// middle insertion is O(n), so these two run on n / 8 elements.
+template<template<class> class Vector, class T>
+void vector_insert_random(State &state) {
+  size_t n = state.n / 8;
+  std::vector<int> positions = permutation(n);
+  state.set_items_per_iteration(n);
+  while(state.keep_running()) {
+    Vector<T> v;
+    for(size_t i = 0; i < n; ++i)
+      v.insert(v.begin() + positions[i] % (v.size() + 1), Element<T>::make(positions[i]));
+    do_not_optimize(v.size());
+  }
+}
+
+template<template<class> class Vector, class T>
+void vector_erase_random(State &state) {
+  size_t n = state.n / 8;
+  std::vector<int> positions = permutation(n);
+  state.set_items_per_iteration(n);
+  while(state.keep_running()) {
+    state.pause_timing();
+    Vector<T> v;
+    fill_vector<T>(v, n);
+    state.resume_timing();
+    for(size_t i = 0; i < n; ++i)
+      v.erase(v.begin() + positions[i] % v.size());
+    do_not_optimize(v.size());
+  }
+}
+
+template<template<class> class Vector, class T>
+void vector_iterate(State &state) {
+  Vector<T> v;
+  fill_vector<T>(v, state.n);
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    for(typename Vector<T>::iterator it = v.begin(); it != v.end(); ++it)
+      do_not_optimize(*it);
+  }
+}
+
+template<template<class> class Vector, class T>
+void vector_copy(State &state) {
+  Vector<T> v;
+  fill_vector<T>(v, state.n);
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    Vector<T> copy(v);
+    do_not_optimize(copy.size());
+  }
+}
+
+// one scratch vector assigned from sources of sizes between n / 2 and n in turn,
+// as when a buffer is recycled in a loop.
+template<template<class> class Vector, class T>
+void vector_assign_recycled(State &state) {
+  const size_t kSources = 8;
+  std::vector<Vector<T>> sources(kSources);
+  for(size_t i = 0; i < kSources; ++i)
+    fill_vector<T>(sources[i], state.n / 2 + state.n / 2 * i / (kSources - 1));
+  Vector<T> scratch;
+  state.set_items_per_iteration(kSources);
+  while(state.keep_running()) {
+    for(size_t i = 0; i < kSources; ++i) {
+      scratch = sources[i * 5 % kSources];
+      do_not_optimize(scratch.size());
+    }
+  }
+}
+
+// many short-lived vectors of n elements each, as in per-node adjacency lists.
+// with n up to 8 the small_vector never allocates.
+template<template<class> class Vector>
+void vector_tiny(State &state) {
+  const size_t kVectors = 1024;
+  state.set_items_per_iteration(kVectors);
+  while(state.keep_running()) {
+    size_t sum = 0;
+    for(size_t i = 0; i < kVectors; ++i) {
+      Vector<int> v;
+      fill_vector<int>(v, state.n);
+      sum += v.size();
+    }
+    do_not_optimize(sum);
+  }
+}
+
+// insertions and erasures in turn around a cursor that wanders up to 8 slots per edit,
+// as typing in an editor does. the size stays n, and the cursor walks back to the middle
+// by the end of every iteration.
+template<template<class> class Vector>
+void vector_edit_near_cursor(State &state) {
+  const size_t kEdits = 1024;
+  std::vector<int> steps = permutation(kEdits / 2), moves;
+  for(int step : steps) moves.push_back(step % 17 - 8);
+  for(size_t i = kEdits / 2; i > 0; --i) moves.push_back(-moves[i - 1]);
+  Vector<int> v;
+  fill_vector<int>(v, state.n);
+  size_t cursor = state.n / 2;
+  state.set_items_per_iteration(kEdits);
+  while(state.keep_running()) {
+    for(size_t i = 0; i < kEdits; ++i) {
+      cursor = (cursor + v.size() + moves[i]) % v.size();
+      if(i % 2 == 0) v.insert(v.begin() + cursor, moves[i]);
+      else v.erase(v.begin() + cursor);
+    }
+    do_not_optimize(v.size());
+  }
+}
+
+// one vector grown to n ints with every push_back timed on its own, which adds the cost
+// of reading the clock to ns_per_op. the percentiles of the latencies are reported;
+// the tail of a contiguous vector is its reallocations.
+template<template<class> class Vector>
+void vector_growth(State &state) {
+  LatencyHistogram latencies;
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    Vector<int> v;
+    for(size_t i = 0; i < state.n; ++i) {
+      Clock::time_point start = Clock::now();
+      v.push_back(static_cast<int>(i));
+      latencies.add(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+    }
+    do_not_optimize(v.size());
+  }
+  latencies.report(state);
+}
+
+// n ints copied out of a plain array into a new vector: one at a time, as a single append,
+// or written in place after a resize_uninitialized.
+template<template<class> class Vector>
+void vector_ingest_push_back(State &state) {
+  std::vector<int> src = permutation(state.n);
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    Vector<int> v;
+    for(size_t i = 0; i < state.n; ++i) v.push_back(src[i]);
+    do_not_optimize(v.size());
+  }
+}
+
+inline void vector_ingest_append(State &state) {
+  std::vector<int> src = permutation(state.n);
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    sjtu::vector<int> v;
+    v.append(src.data(), state.n);
+    do_not_optimize(v.size());
+  }
+}
+
+inline void vector_ingest_in_place(State &state) {
+  std::vector<int> src = permutation(state.n);
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    sjtu::vector<int> v;
+    v.resize_uninitialized(state.n);
+    int *data = v.data();
+    for(size_t i = 0; i < state.n; ++i) data[i] = src[i];
+    do_not_optimize(v.size());
+  }
+}
+
+inline void vector_ingest_std_insert(State &state) {
+  std::vector<int> src = permutation(state.n);
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    std::vector<int> v;
+    v.insert(v.end(), src.begin(), src.end());
+    do_not_optimize(v.size());
+  }
+}
+
+// a vector of n integers, far larger than what the TLB covers with small pages.
+template<class Vector>
+void fill_scan_vector(Vector &v, size_t n) {
+  v.resize_uninitialized(n);
+  long long *data = v.data();
+  for(size_t i = 0; i < n; ++i) data[i] = static_cast<long long>(i);
+}
+
+template<template<class> class Vector>
+void vector_scan_sequential(State &state) {
+  Vector<long long> v;
+  fill_scan_vector(v, state.n);
+  state.set_items_per_iteration(state.n);
+  while(state.keep_running()) {
+    const long long *data = v.data();
+    long long sum = 0;
+    for(size_t i = 0; i < state.n; ++i) sum += data[i];
+    do_not_optimize(sum);
+  }
+}
+
+// reads at indices from a linear congruential generator, so the index stream itself
+// takes no memory. n should be a power of 2.
+template<template<class> class Vector>
+void vector_scan_random(State &state) {
+  const size_t kReads = 1 << 20;
+  Vector<long long> v;
+  fill_scan_vector(v, state.n);
+  state.set_items_per_iteration(kReads);
+  size_t index = 1;
+  while(state.keep_running()) {
+    const long long *data = v.data();
+    long long sum = 0;
+    for(size_t i = 0; i < kReads; ++i) {
+      index = (index * 6364136223846793005ULL + 1442695040888963407ULL) & (state.n - 1);
+      sum += data[index];
+    }
+    do_not_optimize(sum);
+  }
+}
+
+template<class T>
+void register_vector_type() {
+  size_t n = Element<T>::size();
+  const char *type = Element<T>::name();
+  add("vector", "push_back", type, "sjtu", n, vector_push_back<sjtu_vector, T>);
+  add("vector", "push_back", type, "std", n, vector_push_back<std_vector, T>);
+  add("vector", "push_back", type, "sjtu_segmented", n, vector_push_back<sjtu_segmented_vector, T>);
+  add("vector", "insert_random", type, "sjtu", n, vector_insert_random<sjtu_vector, T>);
+  add("vector", "insert_random", type, "std", n, vector_insert_random<std_vector, T>);
+  add("vector", "erase_random", type, "sjtu", n, vector_erase_random<sjtu_vector, T>);
+  add("vector", "erase_random", type, "std", n, vector_erase_random<std_vector, T>);
+  add("vector", "insert_random", type, "sjtu_gap", n, vector_insert_random<sjtu_gap_buffer, T>);
+  add("vector", "erase_random", type, "sjtu_gap", n, vector_erase_random<sjtu_gap_buffer, T>);
+  add("vector", "iterate", type, "sjtu", n, vector_iterate<sjtu_vector, T>);
+  add("vector", "iterate", type, "std", n, vector_iterate<std_vector, T>);
+  add("vector", "iterate", type, "sjtu_segmented", n, vector_iterate<sjtu_segmented_vector, T>);
+  add("vector", "iterate", type, "sjtu_gap", n, vector_iterate<sjtu_gap_buffer, T>);
+  add("vector", "copy", type, "sjtu", n, vector_copy<sjtu_vector, T>);
+  add("vector", "copy", type, "std", n, vector_copy<std_vector, T>);
+  add("vector", "assign_recycled", type, "sjtu", n, vector_assign_recycled<sjtu_vector, T>);
+  add("vector", "assign_recycled", type, "std", n, vector_assign_recycled<std_vector, T>);
+}
+
+inline void register_vector_benchmarks() {
+  register_vector_type<int>();
+  register_vector_type<Integer>();
+  register_vector_type<Util::Bint>();
+  register_vector_type<Matrix>();
+  for(size_t n : {2, 8, 32}) {
+    add("vector", "tiny", "int", "sjtu", n, vector_tiny<sjtu_vector>);
+    add("vector", "tiny", "int", "sjtu_small", n, vector_tiny<sjtu_small_vector>);
+    add("vector", "tiny", "int", "std", n, vector_tiny<std_vector>);
+  }
+  for(size_t n : {size_t(1) << 12, size_t(1) << 16, size_t(1) << 20}) {
+    add("vector", "edit_near_cursor", "int", "sjtu", n, vector_edit_near_cursor<sjtu_vector>);
+    add("vector", "edit_near_cursor", "int", "sjtu_gap", n, vector_edit_near_cursor<sjtu_gap_buffer>);
+    add("vector", "edit_near_cursor", "int", "std", n, vector_edit_near_cursor<std_vector>);
+  }
+  const size_t kIngest = size_t(1) << 20;
+  add("vector", "ingest", "int", "sjtu", kIngest, vector_ingest_push_back<sjtu_vector>);
+  add("vector", "ingest", "int", "sjtu_append", kIngest, vector_ingest_append);
+  add("vector", "ingest", "int", "sjtu_resize_uninitialized", kIngest, vector_ingest_in_place);
+  add("vector", "ingest", "int", "std", kIngest, vector_ingest_push_back<std_vector>);
+  add("vector", "ingest", "int", "std_insert", kIngest, vector_ingest_std_insert);
+  // 256 MB of data.
+  const size_t kScan = size_t(1) << 25;
+  add("vector", "scan_sequential", "int64", "sjtu", kScan, vector_scan_sequential<sjtu_vector>);
+  add("vector", "scan_sequential", "int64", "sjtu_aligned", kScan, vector_scan_sequential<sjtu_aligned_vector>);
+  add("vector", "scan_sequential", "int64", "sjtu_thp", kScan, vector_scan_sequential<sjtu_thp_vector>);
+  add("vector", "scan_sequential", "int64", "sjtu_hugetlb", kScan, vector_scan_sequential<sjtu_hugetlb_vector>);
+  add("vector", "scan_random", "int64", "sjtu", kScan, vector_scan_random<sjtu_vector>);
+  add("vector", "scan_random", "int64", "sjtu_aligned", kScan, vector_scan_random<sjtu_aligned_vector>);
+  add("vector", "scan_random", "int64", "sjtu_thp", kScan, vector_scan_random<sjtu_thp_vector>);
+  add("vector", "scan_random", "int64", "sjtu_hugetlb", kScan, vector_scan_random<sjtu_hugetlb_vector>);
+  const size_t kLarge = 10000000;
+  add("vector", "growth", "int", "sjtu", kLarge, vector_growth<sjtu_vector>);
+  add("vector", "growth", "int", "sjtu_segmented", kLarge, vector_growth<sjtu_segmented_vector>);
+  add("vector", "growth", "int", "sjtu_deamortized", kLarge, vector_growth<sjtu_deamortized_vector>);
+  add("vector", "growth", "int", "std", kLarge, vector_growth<std_vector>);
+}
+
+}
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef SJTU_COW_HPP
+#define SJTU_COW_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace sjtu {
+
+/**
+ * a copy-on-write handle over any container.
+ * copies share one reference-counted container, so copying is O(1);
+ * the deep copy happens only on the first write() through a shared handle.
+ * handles sharing a container may live in different threads,
+ * but one handle itself should not be used by two threads at once.
+ */
+template<class Container>
+class cow {
+private:
+  struct Block {
+    Container value;
+    std::atomic<size_t> count;
+
+    Block(): value(), count(1) {}
+    Block(const Container &value_): value(value_), count(1) {}
+    Block(Container &&value_): value(std::move(value_)), count(1) {}
+  };
+  Block *block_; // nullptr stands for an empty container.
+
+  void release() {
+    if(block_ != nullptr && block_->count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      delete block_;
+    block_ = nullptr;
+  }
+  static const Container& empty_container() {
+    static const Container empty;
+    return empty;
+  }
+
+public:
+  cow(): block_(nullptr) {}
+  cow(const Container &value): block_(new Block(value)) {}
+  cow(Container &&value): block_(new Block(std::move(value))) {}
+  cow(const cow &other): block_(other.block_) {
+    if(block_ != nullptr) block_->count.fetch_add(1, std::memory_order_relaxed);
+  }
+  cow(cow &&other) noexcept: block_(other.block_) {
+    other.block_ = nullptr;
+  }
+  ~cow() {
+    release();
+  }
+  cow &operator=(const cow &other) {
+    if(block_ == other.block_) return *this;
+    if(other.block_ != nullptr) other.block_->count.fetch_add(1, std::memory_order_relaxed);
+    release();
+    block_ = other.block_;
+    return *this;
+  }
+  cow &operator=(cow &&other) noexcept {
+    if(this == &other) return *this;
+    release();
+    block_ = other.block_;
+    other.block_ = nullptr;
+    return *this;
+  }
+  // read-only access never copies.
+  const Container& read() const {
+    return (block_ == nullptr) ? empty_container() : block_->value;
+  }
+  const Container& operator*() const {
+    return read();
+  }
+  const Container* operator->() const {
+    return &read();
+  }
+  // writable access. deep copies the container if it is shared.
+  // don't keep the reference after copying this handle, or the copy sees the writes.
+  Container& write() {
+    if(block_ == nullptr) block_ = new Block();
+    else if(block_->count.load(std::memory_order_acquire) != 1) {
+      Block *copy = new Block(block_->value);
+      release();
+      block_ = copy;
+    }
+    return block_->value;
+  }
+  // number of handles sharing this container, 0 if nothing is held.
+  size_t use_count() const {
+    return (block_ == nullptr) ? 0 : block_->count.load(std::memory_order_relaxed);
+  }
+  bool unique() const {
+    return use_count() <= 1;
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,88 @@
+#include "map.hpp"
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+void PrintShape(const sjtu::map_shape &shape)
+{
+	std::cout << shape.nodes << " " << shape.height << " " << shape.black_height << " "
+		<< std::fixed << std::setprecision(3) << shape.average_depth << " "
+		<< (shape.violation == nullptr ? "valid" : shape.violation) << std::endl;
+	for (size_t i = 0; i < sjtu::map_shape::kHistogramSize; ++i) {
+		if (shape.depth_histogram[i] != 0) {
+			std::cout << i << ":" << shape.depth_histogram[i] << " ";
+		}
+	}
+	std::cout << std::endl;
+}
+
+void TestEmpty()
+{
+	std::cout << "Testing empty map..." << std::endl;
+	sjtu::map<int, int> m;
+	PrintShape(m.shape());
+	m.self_check();
+}
+
+void TestAscending()
+{
+	std::cout << "Testing ascending insertion..." << std::endl;
+	sjtu::map<int, int> m;
+	for (int i = 0; i < 1000; ++i) {
+		m[i] = i;
+	}
+	sjtu::map_shape shape = m.shape();
+	PrintShape(shape);
+	std::cout << (shape.height <= 2 * std::log2(1000.0 + 1)) << std::endl;
+	m.self_check();
+}
+
+void TestErase()
+{
+	std::cout << "Testing erasure..." << std::endl;
+	sjtu::map<int, int> m;
+	unsigned seed = 12345;
+	for (int i = 0; i < 5000; ++i) {
+		seed = seed * 1103515245 + 12345;
+		m[(seed >> 8) % 3000] = i;
+	}
+	bool valid = true;
+	for (int i = 0; i < 5000; ++i) {
+		seed = seed * 1103515245 + 12345;
+		sjtu::map<int, int>::iterator it = m.find((seed >> 8) % 3000);
+		if (it != m.end()) {
+			m.erase(it);
+			valid = valid && m.shape().violation == nullptr;
+		}
+	}
+	std::cout << valid << std::endl;
+	PrintShape(m.shape());
+	while (!m.empty()) {
+		m.erase(m.begin());
+		valid = valid && m.shape().violation == nullptr;
+	}
+	std::cout << valid << std::endl;
+	PrintShape(m.shape());
+}
+
+void TestCopy()
+{
+	std::cout << "Testing copies..." << std::endl;
+	sjtu::map<int, int> m;
+	for (int i = 0; i < 100; ++i) {
+		m[i * 37 % 100] = i;
+	}
+	sjtu::map<int, int> copy(m);
+	PrintShape(m.shape());
+	PrintShape(copy.shape());
+}
+
+int main()
+{
+	TestEmpty();
+	TestAscending();
+	TestErase();
+	TestCopy();
+	return 0;
+}
@@ -0,0 +1,87 @@
+#include "simd_search.hpp"
+#include "flat_map.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+unsigned seed = 31;
+
+unsigned NextRandom()
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 4;
+}
+
+// compares every instruction set the cpu has against std::lower_bound.
+template <class T>
+bool TestType(T scale, T offset)
+{
+	bool same = true;
+	for (size_t n = 0; n < 300; n += 1 + n / 8) {
+		std::vector<T> keys;
+		for (size_t i = 0; i < n; ++i) {
+			keys.push_back(static_cast<T>(NextRandom() % 1000) * scale + offset);
+		}
+		std::sort(keys.begin(), keys.end());
+		for (int j = 0; j < 200; ++j) {
+			T key = static_cast<T>(NextRandom() % 1002) * scale + offset - scale;
+			size_t expected = std::lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+			for (int set = 0; set <= static_cast<int>(sjtu::simd::best_isa()); ++set) {
+				same = same && sjtu::simd::lower_bound(keys.data(), n, key, static_cast<sjtu::simd::isa>(set)) == expected;
+			}
+		}
+	}
+	return same;
+}
+
+void TestKernels()
+{
+	std::cout << "Testing kernels..." << std::endl;
+	std::cout << TestType<int>(1, -500) << " ";
+	std::cout << TestType<unsigned>(4000000u, 7u) << " ";
+	std::cout << TestType<long long>(10000000000000LL, -5000000000000000LL) << " ";
+	std::cout << TestType<unsigned long>(10000000000000000UL, 3UL) << " ";
+	// long and long long are distinct types of the same width.
+	std::cout << TestType<long>(10000000000000L, -5000000000000000L) << " ";
+	std::cout << TestType<unsigned long long>(10000000000000000ULL, 3ULL) << " ";
+	std::cout << TestType<float>(0.5f, -100.25f) << " ";
+	std::cout << TestType<double>(1e-3, -0.25) << std::endl;
+}
+
+void TestEnabled()
+{
+	std::cout << "Testing which maps use the kernels..." << std::endl;
+	std::cout << sjtu::simd::enabled<int, std::less<int>>::value << " "
+		<< sjtu::simd::enabled<double, std::less<double>>::value << " "
+		<< sjtu::simd::enabled<int, std::greater<int>>::value << " "
+		<< sjtu::simd::enabled<short, std::less<short>>::value << " "
+		<< sjtu::simd::enabled<bool, std::less<bool>>::value << std::endl;
+}
+
+void TestFlatMap()
+{
+	std::cout << "Testing flat_map with the kernels..." << std::endl;
+	sjtu::flat_map<unsigned, int> m;
+	sjtu::flat_map<unsigned, int, std::greater<unsigned>> r;
+	for (int i = 0; i < 5000; ++i) {
+		unsigned key = NextRandom();
+		m[key] = i;
+		r[key] = i;
+	}
+	bool same = m.size() == r.size();
+	sjtu::flat_map<unsigned, int>::const_iterator it = m.cend();
+	for (sjtu::flat_map<unsigned, int, std::greater<unsigned>>::const_iterator jt = r.cbegin(); jt != r.cend(); ++jt) {
+		--it;
+		same = same && it->first == jt->first && it->second == jt->second && m.at(jt->first) == jt->second;
+	}
+	std::cout << same << " " << m.count(0x7fffffffu) << std::endl;
+}
+
+int main()
+{
+	TestKernels();
+	TestEnabled();
+	TestFlatMap();
+	return 0;
+}
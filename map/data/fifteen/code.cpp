@@ -0,0 +1,85 @@
+#include "map.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+template <class Map, class Key>
+bool SameAsFind(Map &m, const std::vector<Key> &keys)
+{
+	std::vector<typename Map::iterator> found(keys.size());
+	typename std::vector<typename Map::iterator>::iterator end = m.find_batch(keys.begin(), keys.end(), found.begin());
+	if (end != found.end()) {
+		return false;
+	}
+	for (size_t i = 0; i < keys.size(); ++i) {
+		if (!(found[i] == m.find(keys[i]))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void TestIntKeys()
+{
+	std::cout << "Testing int keys..." << std::endl;
+	sjtu::map<int, int> m;
+	std::vector<int> keys;
+	std::cout << SameAsFind(m, keys) << std::endl;
+	keys.push_back(1);
+	std::cout << SameAsFind(m, keys) << std::endl;
+	srand(20240512);
+	for (int i = 0; i < 50000; ++i) {
+		m[rand() % 100000] = i;
+	}
+	for (size_t n : {1, 15, 16, 17, 100, 1000}) {
+		keys.clear();
+		for (size_t i = 0; i < n; ++i) {
+			keys.push_back(rand() % 100000);
+		}
+		std::cout << n << " " << SameAsFind(m, keys) << std::endl;
+	}
+	int raw[] = {-1, 0, 99999, 100000, 42, 42};
+	sjtu::map<int, int>::iterator out[6];
+	std::cout << (m.find_batch(raw, raw + 6, out) - out) << " " << (out[3] == m.end()) << " " << (out[4] == out[5]) << std::endl;
+	const sjtu::map<int, int> &cm = m;
+	std::vector<sjtu::map<int, int>::const_iterator> found(keys.size());
+	cm.find_batch(keys.begin(), keys.end(), found.begin());
+	bool ok = true;
+	for (size_t i = 0; i < keys.size(); ++i) {
+		ok = ok && found[i] == cm.find(keys[i]);
+		if (found[i] != cm.cend()) {
+			ok = ok && found[i]->first == keys[i];
+		}
+	}
+	std::cout << ok << std::endl;
+}
+
+void TestStringKeys()
+{
+	std::cout << "Testing string keys..." << std::endl;
+	sjtu::map<std::string, int> m;
+	std::vector<std::string> keys;
+	for (int i = 0; i < 3000; ++i) {
+		m[std::to_string(i * 3)] = i;
+	}
+	for (int i = 0; i < 500; ++i) {
+		keys.push_back(std::to_string(i * 5));
+	}
+	std::cout << SameAsFind(m, keys) << std::endl;
+	std::vector<sjtu::map<std::string, int>::iterator> found(keys.size());
+	m.find_batch(keys.begin(), keys.end(), found.begin());
+	int hits = 0;
+	for (size_t i = 0; i < found.size(); ++i) {
+		hits += (found[i] != m.end());
+	}
+	std::cout << hits << std::endl;
+}
+
+int main()
+{
+	TestIntKeys();
+	TestStringKeys();
+	return 0;
+}
@@ -0,0 +1,95 @@
+#include "map.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+
+// a three-way comparator, picked up through its compare member.
+struct Reverse {
+	bool operator()(int lhs, int rhs) const { return rhs < lhs; }
+	int compare(int lhs, int rhs) const { return (rhs < lhs) ? -1 : (lhs < rhs ? 1 : 0); }
+};
+
+// the same order as std::less<std::string>, but without a three-way comparison.
+struct StringLess {
+	bool operator()(const std::string &lhs, const std::string &rhs) const { return lhs < rhs; }
+};
+
+static_assert(sjtu::three_way_compare<Reverse, int>::value, "Reverse has compare");
+static_assert(sjtu::three_way_compare<std::less<std::string>, std::string>::value, "std::string has compare");
+static_assert(!sjtu::three_way_compare<std::less<int>, int>::value, "std::less<int> has none");
+static_assert(!sjtu::three_way_compare<StringLess, std::string>::value, "StringLess has none");
+
+typedef sjtu::map<int, int, std::less<int>, sjtu::red_black_balance, sjtu::atomic_stats> TwoWay;
+typedef sjtu::map<int, int, Reverse, sjtu::red_black_balance, sjtu::atomic_stats> ThreeWay;
+
+template <class Map>
+void CountLookups(Map &m, int hit, int miss)
+{
+	m.reset_stats();
+	m.find(hit);
+	std::cout << m.stats().comparisons << " ";
+	m.reset_stats();
+	m.find(miss);
+	std::cout << m.stats().comparisons << std::endl;
+}
+
+void TestComparisons()
+{
+	std::cout << "Testing comparisons per lookup..." << std::endl;
+	TwoWay two_way;
+	ThreeWay three_way;
+	for (int i = 0; i < 1023; ++i) {
+		two_way[i * 2] = i;
+		three_way[i * 2] = i;
+	}
+	std::cout << two_way.shape().height << " " << three_way.shape().height << std::endl;
+	CountLookups(two_way, 1022, 1023);
+	CountLookups(three_way, 1022, 1023);
+	TwoWay::iterator it = two_way.find(1022);
+	ThreeWay::iterator rit = three_way.find(1022);
+	std::cout << it->second << " " << rit->second << " " << (--rit)->first << " " << (two_way.find(1023) == two_way.end())
+		<< " " << (three_way.find(-1) == three_way.end()) << std::endl;
+}
+
+template <class Compare>
+void CheckStrings(const char *name)
+{
+	sjtu::map<std::string, int, Compare> m;
+	std::map<std::string, int> ref;
+	srand(20240414);
+	bool ok = true;
+	for (int i = 0; i < 20000; ++i) {
+		std::string key = "key" + std::to_string(rand() % 5000);
+		int op = rand() % 4;
+		if (op == 0) {
+			m[key] += i;
+			ref[key] += i;
+		} else if (op == 1) {
+			bool inserted = m.insert(sjtu::pair<const std::string, int>(key, i)).second;
+			ok = ok && inserted == ref.insert(std::make_pair(key, i)).second;
+		} else if (op == 2) {
+			ok = ok && m.count(key) == ref.count(key);
+		} else if (ref.count(key) != 0) {
+			m.erase(m.find(key));
+			ref.erase(key);
+		}
+	}
+	ok = ok && m.size() == ref.size();
+	std::map<std::string, int>::iterator it = ref.begin();
+	for (typename sjtu::map<std::string, int, Compare>::const_iterator mit = m.cbegin(); mit != m.cend(); ++mit, ++it) {
+		ok = ok && mit->first == it->first && mit->second == it->second;
+	}
+	m.self_check();
+	std::cout << name << " " << m.size() << " " << ok << std::endl;
+}
+
+int main()
+{
+	TestComparisons();
+	std::cout << "Testing string keys..." << std::endl;
+	CheckStrings<std::less<std::string>>("three-way");
+	CheckStrings<StringLess>("two-way");
+	return 0;
+}
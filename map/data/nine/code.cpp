@@ -0,0 +1,110 @@
+#include "map.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+
+const char *kPath = "map_nine.bin";
+
+void PrintShape(const sjtu::map_shape &shape)
+{
+	std::cout << shape.nodes << " " << shape.height << " " << shape.black_height << " "
+		<< (shape.violation == nullptr ? "valid" : shape.violation) << std::endl;
+}
+
+void TestRoundTrip()
+{
+	std::cout << "Testing save and load..." << std::endl;
+	sjtu::map<int, double> m;
+	for (int i = 0; i < 1000; ++i) {
+		m[i * 7919 % 1000] = i / 4.0;
+	}
+	for (int i = 0; i < 1000; i += 3) {
+		m.erase(m.find(i));
+	}
+	m.save(kPath);
+	sjtu::map<int, double> loaded;
+	loaded[-1] = -1;
+	loaded.load(kPath);
+	PrintShape(m.shape());
+	PrintShape(loaded.shape());
+	bool same = m.size() == loaded.size();
+	sjtu::map<int, double>::const_iterator it = m.cbegin(), jt = loaded.cbegin();
+	for (; it != m.cend() && jt != loaded.cend(); ++it, ++jt) {
+		same = same && it->first == jt->first && it->second == jt->second;
+	}
+	std::cout << same << " " << loaded.count(-1) << " " << loaded.at(998) << std::endl;
+	loaded[5000] = 1;
+	loaded.erase(loaded.begin());
+	std::cout << loaded.size() << " " << (--loaded.end())->first << " " << loaded.begin()->first << std::endl;
+	loaded.self_check();
+}
+
+void TestEmpty()
+{
+	std::cout << "Testing empty map..." << std::endl;
+	sjtu::map<int, double> m, loaded;
+	m.save(kPath);
+	loaded[1] = 1;
+	loaded.load(kPath);
+	std::cout << loaded.size() << " " << (loaded.cbegin() == loaded.cend()) << std::endl;
+}
+
+void TestBrokenFiles()
+{
+	std::cout << "Testing broken files..." << std::endl;
+	sjtu::map<int, double> m;
+	for (int i = 0; i < 100; ++i) {
+		m[i] = i;
+	}
+	m.save(kPath);
+	sjtu::map<long long, double> other;
+	try {
+		other.load(kPath);
+		std::cout << "loaded" << std::endl;
+	} catch (sjtu::runtime_error) {
+		std::cout << "wrong types" << std::endl;
+	}
+	// the keys are no longer in order.
+	std::FILE *file = std::fopen(kPath, "r+b");
+	int key = 1000;
+	std::fseek(file, sizeof(sjtu::map_file_header), SEEK_SET);
+	std::fwrite(&key, sizeof(key), 1, file);
+	std::fclose(file);
+	sjtu::map<int, double> loaded;
+	loaded[1] = 1;
+	try {
+		loaded.load(kPath);
+		std::cout << "loaded" << std::endl;
+	} catch (sjtu::runtime_error) {
+		std::cout << "out of order " << loaded.size() << std::endl;
+	}
+	// a count that would take the shape far past the end of the file.
+	file = std::fopen(kPath, "r+b");
+	std::uint64_t count = std::uint64_t(1) << 60;
+	std::fseek(file, offsetof(sjtu::map_file_header, count), SEEK_SET);
+	std::fwrite(&count, sizeof(count), 1, file);
+	std::fclose(file);
+	try {
+		loaded.load(kPath);
+		std::cout << "loaded" << std::endl;
+	} catch (sjtu::runtime_error) {
+		std::cout << "huge count " << loaded.size() << std::endl;
+	}
+	try {
+		loaded.load("map_nine.missing");
+		std::cout << "loaded" << std::endl;
+	} catch (sjtu::runtime_error) {
+		std::cout << "missing " << loaded.size() << std::endl;
+	}
+}
+
+int main()
+{
+	TestRoundTrip();
+	TestEmpty();
+	TestBrokenFiles();
+	std::remove(kPath);
+	return 0;
+}
@@ -0,0 +1,65 @@
+#include "map.hpp"
+
+#include <iostream>
+
+// every map adds its counts to the global ones too.
+typedef sjtu::map<int, int, std::less<int>, sjtu::red_black_balance, sjtu::global_atomic_stats> Map;
+
+void PrintStats(const sjtu::container_stats &stats)
+{
+	std::cout << stats.allocations << " " << stats.deallocations << " " << stats.comparisons << " "
+		<< stats.rotations << " " << stats.recolorings << std::endl;
+}
+
+void TestAscendingInsert()
+{
+	std::cout << "Testing ascending insertion..." << std::endl;
+	Map m;
+	for (int i = 0; i < 100; ++i) {
+		m[i] = i;
+	}
+	PrintStats(m.stats());
+	m.reset_stats();
+	for (int i = 0; i < 100; ++i) {
+		m.find(i);
+	}
+	PrintStats(m.stats());
+}
+
+void TestErase()
+{
+	std::cout << "Testing erasure..." << std::endl;
+	Map m;
+	for (int i = 0; i < 100; ++i) {
+		m[i * 37 % 100] = i;
+	}
+	m.reset_stats();
+	for (int i = 0; i < 100; i += 2) {
+		m.erase(m.find(i));
+	}
+	PrintStats(m.stats());
+	std::cout << m.size() << std::endl;
+}
+
+void TestGlobal()
+{
+	std::cout << "Testing global stats..." << std::endl;
+	sjtu::reset_global_stats();
+	Map a, b;
+	for (int i = 0; i < 10; ++i) {
+		a[i] = i;
+		b[-i] = i;
+	}
+	sjtu::container_stats sum = a.stats();
+	sum += b.stats();
+	PrintStats(sum);
+	PrintStats(sjtu::global_stats());
+}
+
+int main()
+{
+	TestAscendingInsert();
+	TestErase();
+	TestGlobal();
+	return 0;
+}
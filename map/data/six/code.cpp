@@ -0,0 +1,208 @@
+#include "persistent_map.hpp"
+#include <iostream>
+#include <map>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <stdexcept>
+#include <type_traits>
+
+typedef sjtu::persistent_map<int, std::string> pmap;
+
+bool same(const pmap &lhs, const std::map<int, std::string> &rhs)
+{
+	if (lhs.size() != rhs.size()) return false;
+	auto it = rhs.begin();
+	for (pmap::const_iterator jt = lhs.cbegin(); jt != lhs.cend(); ++jt, ++it) {
+		if (jt->first != it->first || jt->second != it->second) return false;
+	}
+	return true;
+}
+
+void TestVersions()
+{
+	std::cout << "Testing versions..." << std::endl;
+	std::vector<pmap> versions(1);
+	std::vector<std::map<int, std::string>> refs(1);
+	srand(20240414);
+	for (int i = 0; i < 3000; ++i) {
+		int key = rand() % 1000;
+		std::string value = std::to_string(rand() % 100);
+		int op = rand() % 3;
+		pmap next;
+		std::map<int, std::string> ref = refs.back();
+		if (op == 0) {
+			next = versions.back().insert(sjtu::pair<const int, std::string>(key, value));
+			ref.insert(std::make_pair(key, value));
+		} else if (op == 1) {
+			next = versions.back().insert_or_assign(sjtu::pair<const int, std::string>(key, value));
+			ref[key] = value;
+		} else {
+			next = versions.back().erase(key);
+			ref.erase(key);
+		}
+		versions.push_back(next);
+		refs.push_back(ref);
+	}
+	bool ok = true;
+	for (size_t i = 0; i < versions.size(); ++i) {
+		if (!same(versions[i], refs[i])) ok = false;
+	}
+	std::cout << (ok ? "OK" : "WRONG") << " " << versions.back().size() << std::endl;
+}
+
+void TestLookup()
+{
+	std::cout << "Testing lookup..." << std::endl;
+	pmap a;
+	for (int i = 0; i < 20; i += 2) {
+		a = a.insert(sjtu::pair<const int, std::string>(i, std::to_string(i * i)));
+	}
+	pmap b = a.erase(4).insert(sjtu::pair<const int, std::string>(5, "five"));
+	std::cout << a.count(4) << " " << b.count(4) << " " << a.count(5) << " " << b.at(5) << std::endl;
+	std::cout << a[6] << " " << (a.find(7) == a.cend()) << " " << b.find(8)->second << std::endl;
+	pmap::const_iterator it = b.find(5);
+	--it;
+	std::cout << it->first << " ";
+	++it;
+	++it;
+	std::cout << it->first << std::endl;
+	try {
+		b.at(4);
+	} catch (sjtu::index_out_of_bound &) {
+		std::cout << "Throw correctly." << std::endl;
+	}
+	try {
+		b.cend()++;
+	} catch (sjtu::invalid_iterator &) {
+		std::cout << "Throw correctly." << std::endl;
+	}
+	try {
+		--b.cbegin();
+	} catch (sjtu::invalid_iterator &) {
+		std::cout << "Throw correctly." << std::endl;
+	}
+	pmap c(std::move(b));
+	std::cout << b.size() << " " << c.size() << " " << a.size() << std::endl;
+}
+
+void TestSequential()
+{
+	std::cout << "Testing sequential inserts and erases..." << std::endl;
+	pmap a;
+	for (int i = 0; i < 100000; ++i) {
+		a = a.insert(sjtu::pair<const int, std::string>(i, ""));
+	}
+	pmap snapshot = a;
+	for (int i = 0; i < 100000; i += 3) {
+		a = a.erase(i);
+	}
+	std::cout << snapshot.size() << " " << a.size() << " " << a.cbegin()->first << std::endl;
+	// the paths here are deeper than an iterator keeps inline, and every step copies one.
+	size_t count = 0;
+	long long sum = 0;
+	for (pmap::const_iterator it = snapshot.cbegin(); it != snapshot.cend(); ++count) {
+		pmap::const_iterator copy = it++;
+		pmap::const_iterator found = snapshot.find(copy->first);
+		sum += found->first;
+	}
+	std::cout << count << " " << sum << std::endl;
+}
+
+// a value whose copies throw once the budget runs out.
+int copy_budget = -1;
+
+struct Fragile
+{
+	int x;
+	Fragile(int x_) : x(x_) {}
+	Fragile(const Fragile &other) : x(other.x)
+	{
+		if (copy_budget == 0) throw std::runtime_error("out of budget");
+		if (copy_budget > 0) --copy_budget;
+	}
+};
+
+typedef sjtu::persistent_map<int, Fragile> fmap;
+
+void TestThrowingCopies()
+{
+	std::cout << "Testing throwing copies..." << std::endl;
+	fmap a;
+	for (int i = 0; i < 2000; ++i) {
+		a = a.insert(sjtu::pair<const int, Fragile>(rand() % 4000, Fragile(i)));
+	}
+	size_t thrown = 0;
+	bool ok = true;
+	for (int i = 0; i < 2000; ++i) {
+		int key = rand() % 4000;
+		copy_budget = rand() % 8;
+		try {
+			if (i % 2 == 0) a = a.insert_or_assign(sjtu::pair<const int, Fragile>(key, Fragile(-i)));
+			else a = a.erase(key);
+		} catch (std::runtime_error &) {
+			++thrown;
+		}
+		copy_budget = -1;
+	}
+	size_t count = 0;
+	int last = -1;
+	for (fmap::const_iterator it = a.cbegin(); it != a.cend(); ++it, ++count) {
+		if (it->first <= last) ok = false;
+		last = it->first;
+	}
+	for (fmap::const_iterator it = a.cend(); it != a.cbegin(); --count) {
+		--it;
+		if (it->first > last) ok = false;
+		last = it->first;
+	}
+	std::cout << (ok && count == 0 && thrown > 0 ? "OK" : "WRONG") << std::endl;
+}
+
+// orders ascending or descending, so a map that kept the wrong comparator shows up.
+struct Order
+{
+	bool descending;
+	Order(bool descending_ = false) : descending(descending_) {}
+	bool operator()(int lhs, int rhs) const { return descending ? rhs < lhs : lhs < rhs; }
+};
+
+typedef sjtu::persistent_map<int, int, Order> omap;
+
+// a comparator whose copies may throw, so moving a map that copies it may throw too.
+struct HeavyOrder
+{
+	std::vector<int> weights;
+	bool operator()(int lhs, int rhs) const { return lhs < rhs; }
+};
+
+static_assert(std::is_nothrow_move_constructible<omap>::value, "Order copies without throwing");
+static_assert(!std::is_nothrow_move_constructible<sjtu::persistent_map<int, int, HeavyOrder>>::value,
+	"copying HeavyOrder may throw");
+static_assert(!std::is_nothrow_move_assignable<sjtu::persistent_map<int, int, HeavyOrder>>::value,
+	"assigning HeavyOrder may throw");
+
+void TestComparator()
+{
+	std::cout << "Testing comparators..." << std::endl;
+	omap ascending, descending(Order(true));
+	// both are empty, so they share the same null root.
+	ascending = descending;
+	for (int i = 0; i < 5; ++i) {
+		ascending = ascending.insert(sjtu::pair<const int, int>(i, i));
+	}
+	for (omap::const_iterator it = ascending.cbegin(); it != ascending.cend(); ++it) {
+		std::cout << it->first << " ";
+	}
+	std::cout << std::endl;
+}
+
+int main()
+{
+	TestVersions();
+	TestLookup();
+	TestSequential();
+	TestThrowingCopies();
+	TestComparator();
+	return 0;
+}
@@ -0,0 +1,131 @@
+#include "map.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+
+typedef sjtu::map<int, int, std::less<int>, sjtu::avl_balance, sjtu::atomic_stats> AvlMap;
+
+template <class Map>
+void PrintShape(const Map &m)
+{
+	sjtu::map_shape shape = m.shape();
+	std::cout << shape.nodes << " " << shape.height << " " << shape.black_height << " "
+		<< (shape.violation == nullptr ? "ok" : shape.violation) << std::endl;
+}
+
+bool SameAs(const AvlMap &m, const std::map<int, int> &ref)
+{
+	if (m.size() != ref.size()) return false;
+	AvlMap::const_iterator it = m.cbegin();
+	for (std::map<int, int>::const_iterator rit = ref.begin(); rit != ref.end(); ++rit, ++it) {
+		if (it == m.cend() || it->first != rit->first || it->second != rit->second) return false;
+	}
+	return it == m.cend();
+}
+
+void TestHeight()
+{
+	std::cout << "Testing height..." << std::endl;
+	// ascending keys make the tallest red-black tree, while an AVL tree stays perfect.
+	sjtu::map<int, int> red_black;
+	AvlMap avl;
+	for (int i = 0; i < 65535; ++i) {
+		red_black[i] = i;
+		avl[i] = i;
+	}
+	PrintShape(red_black);
+	PrintShape(avl);
+	avl.reset_stats();
+	avl.find(0);
+	std::cout << avl.stats().comparisons << std::endl;
+}
+
+void TestRandom()
+{
+	std::cout << "Testing random operations..." << std::endl;
+	AvlMap m;
+	std::map<int, int> ref;
+	srand(20240511);
+	bool ok = true;
+	for (int round = 0; round < 200000; ++round) {
+		int key = rand() % 5000, op = rand() % 3;
+		if (op == 0) {
+			AvlMap::iterator it = m.find(key);
+			if (it != m.end()) {
+				m.erase(it);
+				ref.erase(key);
+			}
+		} else {
+			m[key] = round;
+			ref[key] = round;
+		}
+		if (round % 10000 == 0 && m.shape().violation != nullptr) ok = false;
+	}
+	PrintShape(m);
+	std::cout << ok << " " << SameAs(m, ref) << std::endl;
+	// erasing everything in order keeps rotating at the left edge.
+	while (!m.empty()) m.erase(m.begin());
+	PrintShape(m);
+}
+
+void TestIterators()
+{
+	std::cout << "Testing iterators across rotations..." << std::endl;
+	AvlMap m;
+	for (int i = 0; i < 100; ++i) m[i] = i * i;
+	AvlMap::iterator kept = m.find(50);
+	for (int i = 0; i < 100; i += 3) {
+		if (i != 50) m.erase(m.find(i));
+	}
+	std::cout << kept->first << " " << kept->second << " " << (++kept)->first << " " << m.size() << std::endl;
+	try {
+		m.erase(m.end());
+	} catch (sjtu::invalid_iterator) {
+		std::cout << "invalid_iterator" << std::endl;
+	}
+	PrintShape(m);
+}
+
+void TestCopyAndFile()
+{
+	std::cout << "Testing copies and files..." << std::endl;
+	AvlMap m;
+	std::map<int, int> ref;
+	for (int i = 0; i < 1000; ++i) {
+		m[i * 7 % 1000] = i;
+		ref[i * 7 % 1000] = i;
+	}
+	AvlMap copy(m), moved(std::move(copy));
+	copy = moved;
+	PrintShape(copy);
+	std::cout << SameAs(copy, ref) << " " << SameAs(moved, ref) << std::endl;
+	m.save("avl.bin");
+	AvlMap loaded;
+	loaded.load("avl.bin");
+	PrintShape(loaded);
+	std::cout << SameAs(loaded, ref) << std::endl;
+	// a red-black tree of ascending keys is too lopsided to be an AVL tree.
+	sjtu::map<int, int> red_black;
+	for (int i = 0; i < 1000; ++i) red_black[i] = i;
+	red_black.save("red-black.bin");
+	try {
+		loaded.load("red-black.bin");
+	} catch (sjtu::runtime_error) {
+		std::cout << "runtime_error" << std::endl;
+	}
+	std::cout << SameAs(loaded, ref) << std::endl;
+	std::remove("avl.bin");
+	std::remove("red-black.bin");
+}
+
+int main()
+{
+	TestHeight();
+	TestRandom();
+	TestIterators();
+	TestCopyAndFile();
+	return 0;
+}
@@ -0,0 +1,90 @@
+#include "flat_map.hpp"
+
+#include <iostream>
+#include <map>
+#include <string>
+
+void TestBasic()
+{
+	std::cout << "Testing basic operations..." << std::endl;
+	sjtu::flat_map<int, std::string> m;
+	std::cout << m.size() << " " << m.empty() << " " << (m.begin() == m.end()) << std::endl;
+	m[3] = "three";
+	m[1] = "one";
+	m[2] = "two";
+	sjtu::pair<sjtu::flat_map<int, std::string>::iterator, bool> res = m.insert(sjtu::pair<const int, std::string>(2, "TWO"));
+	std::cout << res.second << " " << res.first->second << std::endl;
+	sjtu::pair<sjtu::flat_map<int, std::string>::iterator, bool> res0 = m.insert(sjtu::pair<const int, std::string>(0, "zero"));
+	std::cout << res0.second << " " << (*res0.first).first << std::endl;
+	for (sjtu::flat_map<int, std::string>::iterator it = m.begin(); it != m.end(); ++it) {
+		it->second += "!";
+		std::cout << it->first << ":" << it->second << " ";
+	}
+	std::cout << std::endl;
+	std::cout << m.count(2) << " " << m.count(5) << " " << m.at(3) << std::endl;
+	m.erase(m.find(0));
+	const sjtu::flat_map<int, std::string> c(m);
+	for (sjtu::flat_map<int, std::string>::const_iterator it = c.cend(); it != c.cbegin();) {
+		--it;
+		std::cout << it->first << ":" << (*it).second << " ";
+	}
+	std::cout << std::endl;
+	std::cout << c[1] << " " << c.size() << std::endl;
+}
+
+void TestExceptions()
+{
+	std::cout << "Testing exceptions..." << std::endl;
+	sjtu::flat_map<int, int> m, other;
+	m[1] = 1;
+	const sjtu::flat_map<int, int> &c = m;
+	try { m.at(2); std::cout << "no throw" << std::endl; } catch (...) { std::cout << "at" << std::endl; }
+	try { c[2]; std::cout << "no throw" << std::endl; } catch (...) { std::cout << "const []" << std::endl; }
+	try { m.erase(m.end()); std::cout << "no throw" << std::endl; } catch (...) { std::cout << "erase end" << std::endl; }
+	try { m.erase(other.begin()); std::cout << "no throw" << std::endl; } catch (...) { std::cout << "erase other" << std::endl; }
+	try { ++m.end(); std::cout << "no throw" << std::endl; } catch (...) { std::cout << "++end" << std::endl; }
+	try { --m.begin(); std::cout << "no throw" << std::endl; } catch (...) { std::cout << "--begin" << std::endl; }
+	std::cout << m.size() << std::endl;
+}
+
+void TestAgainstStd()
+{
+	std::cout << "Testing against std::map..." << std::endl;
+	sjtu::flat_map<int, int> m;
+	std::map<int, int> ref;
+	unsigned seed = 2024;
+	bool same = true;
+	for (int i = 0; i < 20000; ++i) {
+		seed = seed * 1103515245 + 12345;
+		int key = (seed >> 8) % 1000;
+		switch ((seed >> 20) % 3) {
+		case 0:
+			m[key] = i;
+			ref[key] = i;
+			break;
+		case 1:
+			if (m.count(key)) {
+				m.erase(m.find(key));
+				ref.erase(key);
+			}
+			break;
+		default:
+			same = same && m.count(key) == ref.count(key) && (ref.count(key) == 0 || m.at(key) == ref[key]);
+		}
+	}
+	std::map<int, int>::iterator jt = ref.begin();
+	for (sjtu::flat_map<int, int>::const_iterator it = m.cbegin(); it != m.cend(); ++it, ++jt) {
+		same = same && it->first == jt->first && it->second == jt->second;
+	}
+	std::cout << same << " " << m.size() << " " << ref.size() << std::endl;
+	m.clear();
+	std::cout << m.size() << " " << (m.cbegin() == m.cend()) << std::endl;
+}
+
+int main()
+{
+	TestBasic();
+	TestExceptions();
+	TestAgainstStd();
+	return 0;
+}
@@ -0,0 +1,88 @@
+#include "map.hpp"
+
+#include <iostream>
+#include <string>
+#include <utility>
+
+// orders ascending or descending, so a map that lost its comparator shows up.
+struct Order {
+	bool descending;
+	Order(bool descending = false) : descending(descending) {}
+	bool operator()(int lhs, int rhs) const { return descending ? rhs < lhs : lhs < rhs; }
+};
+
+typedef sjtu::map<int, std::string, Order> Map;
+
+void Print(const Map &m)
+{
+	for (Map::const_iterator it = m.cbegin(); it != m.cend(); ++it) {
+		std::cout << it->first << ":" << it->second << " ";
+	}
+	std::cout << "| " << m.size() << std::endl;
+}
+
+Map Build(int n)
+{
+	Map m(Order(true));
+	for (int i = 0; i < n; ++i) {
+		m[i] = std::to_string(i * i);
+	}
+	return m;
+}
+
+void TestMoveConstruct()
+{
+	std::cout << "Testing move construction..." << std::endl;
+	Map a = Build(5);
+	Map b(std::move(a));
+	Print(a);
+	Print(b);
+	b[7] = "49";
+	a[1] = "one";
+	a[2] = "two";
+	Print(a);
+	Print(b);
+	b.self_check();
+}
+
+void TestMoveAssign()
+{
+	std::cout << "Testing move assignment..." << std::endl;
+	Map a = Build(4), b;
+	b[10] = "ten";
+	b = std::move(a);
+	Print(b);
+	Print(a);
+	b = std::move(b);
+	Print(b);
+	a = Build(0);
+	Print(a);
+	b = Map();
+	b[3] = "three";
+	b[4] = "four";
+	Print(b);
+}
+
+void TestCopyComparator()
+{
+	std::cout << "Testing copies..." << std::endl;
+	Map a = Build(3);
+	Map b(a), c, d(Build(0));
+	c = a;
+	b[5] = "25";
+	c[-1] = "1";
+	Print(b);
+	Print(c);
+	Map e(d);
+	e[1] = "1";
+	e[2] = "4";
+	Print(e);
+}
+
+int main()
+{
+	TestMoveConstruct();
+	TestMoveAssign();
+	TestCopyComparator();
+	return 0;
+}
@@ -0,0 +1,70 @@
+#define SJTU_MAP_COMPACT_NODES
+#include "map.hpp"
+
+#include <iostream>
+#include <map>
+
+typedef sjtu::map<int, long long, std::less<int>, sjtu::red_black_balance, sjtu::atomic_stats> Map;
+
+const char *kPath = "map_twelve.bin";
+
+void TestAgainstStd()
+{
+	std::cout << "Testing compact nodes against std::map..." << std::endl;
+	Map m;
+	std::map<int, long long> ref;
+	unsigned seed = 99;
+	bool same = true;
+	for (int i = 0; i < 100000; ++i) {
+		seed = seed * 1103515245 + 12345;
+		int key = (seed >> 8) % 5000;
+		if ((seed >> 24) % 3 != 0) {
+			m[key] = i;
+			ref[key] = i;
+		} else if (m.count(key)) {
+			m.erase(m.find(key));
+			ref.erase(key);
+		}
+		if (i % 1000 == 0) {
+			same = same && m.shape().violation == nullptr;
+		}
+	}
+	std::map<int, long long>::iterator jt = ref.begin();
+	for (Map::const_iterator it = m.cbegin(); it != m.cend(); ++it, ++jt) {
+		same = same && it->first == jt->first && it->second == jt->second;
+	}
+	std::cout << same << " " << m.size() << " " << ref.size() << std::endl;
+	std::cout << m.stats().allocations - m.stats().deallocations << std::endl;
+}
+
+void TestCopyAndLoad()
+{
+	std::cout << "Testing copies and snapshots..." << std::endl;
+	sjtu::map<int, long long> m;
+	for (int i = 0; i < 3000; ++i) {
+		m[i * 7 % 3000] = i;
+	}
+	sjtu::map<int, long long> copy(m), assigned;
+	assigned[-1] = -1;
+	assigned = m;
+	m.clear();
+	m[5] = 5;
+	std::cout << copy.size() << " " << assigned.size() << " " << copy.at(2999) << " " << m.size() << std::endl;
+	copy.save(kPath);
+	m.load(kPath);
+	copy.clear();
+	std::cout << m.size() << " " << m.at(7) << " " << (m.shape().violation == nullptr) << std::endl;
+	while (!m.empty()) {
+		m.erase(m.begin());
+	}
+	m[1] = 1;
+	std::cout << m.size() << " " << m.begin()->second << std::endl;
+	std::remove(kPath);
+}
+
+int main()
+{
+	TestAgainstStd();
+	TestCopyAndLoad();
+	return 0;
+}
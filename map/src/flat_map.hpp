@@ -0,0 +1,283 @@
+/**
+ * implement a container like std::map on sorted arrays.
+ */
+#ifndef SJTU_FLAT_MAP_HPP
+#define SJTU_FLAT_MAP_HPP
+
+#include <functional>
+#include <cstddef>
+#include <type_traits>
+
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "simd_search.hpp"
+#include "../../vector/src/vector.hpp"
+
+namespace sjtu {
+
+/**
+ * keys and values are kept in two sorted sjtu::vectors.
+ * lookups are a branchless binary search over the contiguous keys,
+ * which finishes with SIMD comparisons for arithmetic keys under std::less,
+ * and an insertion or erasure shifts the shorter side of the vectors, so it's O(n)
+ * in the middle but O(1) near both ends.
+ * it beats map on memory and lookups for small or read-mostly maps.
+ * unlike map, every insertion or erasure invalidates the iterators after that point.
+ */
+template<class Key, class Tp, class Compare = std::less<Key>>
+class flat_map {
+public:
+  typedef pair<const Key, Tp> value_type;
+  // keys and values are stored apart, so an iterator refers to a pair of references.
+  struct reference {
+    const Key &first;
+    Tp &second;
+  };
+  struct const_reference {
+    const Key &first;
+    const Tp &second;
+  };
+private:
+  template<class Ref>
+  struct arrow_proxy {
+    Ref ref;
+    const Ref* operator->() const {
+      return &ref;
+    }
+  };
+
+  vector<Key> keys_;
+  vector<Tp> values_;
+  Compare lesser_comparer_;
+
+  // the index of the first key not less than key.
+  size_t lower_bound_index(const Key &key) const {
+    return lower_bound_index(key, simd::enabled<Key, Compare>());
+  }
+  size_t lower_bound_index(const Key &key, std::true_type) const {
+    return simd::lower_bound(keys_.data(), keys_.size(), key);
+  }
+  size_t lower_bound_index(const Key &key, std::false_type) const {
+    size_t len = keys_.size();
+    if(len == 0) return 0;
+    const Key *keys = keys_.data(), *first = keys;
+    // the answer is always in [first, first + len].
+    while(len > 1) {
+      size_t half = len / 2;
+      first = lesser_comparer_(first[half], key) ? first + half : first;
+      len -= half;
+    }
+    return (first - keys) + lesser_comparer_(*first, key);
+  }
+  // the index of key, or size() if it doesn't exist.
+  size_t find_index(const Key &key) const {
+    size_t index = lower_bound_index(key);
+    if(index == keys_.size() || lesser_comparer_(key, keys_.data()[index])) return keys_.size();
+    return index;
+  }
+  // inserts at the index given by lower_bound_index.
+  void insert_at(size_t index, const Key &key, const Tp &value) {
+    keys_.insert(index, key);
+    try {
+      values_.insert(index, value);
+    } catch(...) {
+      keys_.erase(index);
+      throw;
+    }
+  }
+
+public:
+  class const_iterator;
+  class iterator {
+    friend flat_map;
+    friend const_iterator;
+  private:
+    flat_map *container;
+    size_t index;
+
+  public:
+    iterator(): container(nullptr), index(0) {}
+    iterator(flat_map *the_map, size_t the_index): container(the_map), index(the_index) {}
+    iterator(const iterator &other) = default;
+    iterator& operator=(const iterator &other) = default;
+    iterator operator++(int) {
+      iterator res = *this;
+      ++(*this);
+      return res;
+    }
+    iterator& operator++() {
+      if(container == nullptr || index == container->size()) // end()
+        throw invalid_iterator();
+      ++index;
+      return *this;
+    }
+    iterator operator--(int) {
+      iterator res = *this;
+      --(*this);
+      return res;
+    }
+    iterator& operator--() {
+      if(container == nullptr || index == 0) // begin()
+        throw invalid_iterator();
+      --index;
+      return *this;
+    }
+    bool operator==(const iterator &other) const {
+      return container == other.container && index == other.index;
+    }
+    bool operator==(const const_iterator &other) const {
+      return container == other.container && index == other.index;
+    }
+    bool operator!=(const iterator &other) const {
+      return !(*this == other);
+    }
+    bool operator!=(const const_iterator &other) const {
+      return !(*this == other);
+    }
+    reference operator*() const {
+      return reference{container->keys_.data()[index], container->values_.data()[index]};
+    }
+    arrow_proxy<reference> operator->() const {
+      return arrow_proxy<reference>{*(*this)};
+    }
+  };
+  class const_iterator {
+    friend flat_map;
+    friend iterator;
+  private:
+    const flat_map *container;
+    size_t index;
+
+  public:
+    const_iterator(): container(nullptr), index(0) {}
+    const_iterator(const flat_map *the_map, size_t the_index): container(the_map), index(the_index) {}
+    const_iterator(const const_iterator &other) = default;
+    const_iterator(const iterator &other): container(other.container), index(other.index) {}
+    const_iterator& operator=(const const_iterator &other) = default;
+    const_iterator operator++(int) {
+      const_iterator res = *this;
+      ++(*this);
+      return res;
+    }
+    const_iterator& operator++() {
+      if(container == nullptr || index == container->size()) // cend()
+        throw invalid_iterator();
+      ++index;
+      return *this;
+    }
+    const_iterator operator--(int) {
+      const_iterator res = *this;
+      --(*this);
+      return res;
+    }
+    const_iterator& operator--() {
+      if(container == nullptr || index == 0) // cbegin()
+        throw invalid_iterator();
+      --index;
+      return *this;
+    }
+    bool operator==(const iterator &other) const {
+      return container == other.container && index == other.index;
+    }
+    bool operator==(const const_iterator &other) const {
+      return container == other.container && index == other.index;
+    }
+    bool operator!=(const iterator &other) const {
+      return !(*this == other);
+    }
+    bool operator!=(const const_iterator &other) const {
+      return !(*this == other);
+    }
+    const_reference operator*() const {
+      return const_reference{container->keys_.data()[index], container->values_.data()[index]};
+    }
+    arrow_proxy<const_reference> operator->() const {
+      return arrow_proxy<const_reference>{*(*this)};
+    }
+  };
+
+  flat_map() {}
+  flat_map(const flat_map &other) = default;
+  flat_map(flat_map &&other) = default;
+  flat_map& operator=(const flat_map &other) = default;
+  flat_map& operator=(flat_map &&other) = default;
+  // when empty(), begin() == end().
+  iterator begin() {
+    return iterator(this, 0);
+  }
+  iterator end() {
+    return iterator(this, size());
+  }
+  // when empty(), cbegin() == cend().
+  const_iterator cbegin() const {
+    return const_iterator(this, 0);
+  }
+  const_iterator cend() const {
+    return const_iterator(this, size());
+  }
+  void clear() {
+    keys_.clear();
+    values_.clear();
+  }
+  size_t size() const {
+    return keys_.size();
+  }
+  bool empty() const {
+    return keys_.empty();
+  }
+  // reserves capacity for n entries in both vectors.
+  void reserve(size_t n) {
+    keys_.reserve(n);
+    values_.reserve(n);
+  }
+  // returns end iterator if search fails.
+  iterator find(const Key &key) {
+    return iterator(this, find_index(key));
+  }
+  const_iterator find(const Key &key) const {
+    return const_iterator(this, find_index(key));
+  }
+  size_t count(const Key &key) const {
+    return (find_index(key) == size()) ? 0 : 1;
+  }
+  Tp& at(const Key &key) {
+    size_t index = find_index(key);
+    if(index == size()) throw index_out_of_bound();
+    return values_.data()[index];
+  }
+  const Tp& at(const Key &key) const {
+    size_t index = find_index(key);
+    if(index == size()) throw index_out_of_bound();
+    return values_.data()[index];
+  }
+  // insert an empty Tp value into the map.
+  Tp& operator[](const Key &key) {
+    static_assert(std::is_default_constructible<Tp>::value,
+      "The type of value (Tp) should be default constructible if you want to use non-const operator[]");
+    size_t index = lower_bound_index(key);
+    if(index == size() || lesser_comparer_(key, keys_.data()[index]))
+      insert_at(index, key, Tp());
+    return values_.data()[index];
+  }
+  // throws index_out_of_bound if key doesn't exist.
+  const Tp& operator[](const Key &key) const {
+    return at(key);
+  }
+  pair<iterator, bool> insert(const value_type &value) {
+    size_t index = lower_bound_index(value.first);
+    if(index != size() && !lesser_comparer_(value.first, keys_.data()[index]))
+      return pair<iterator, bool>(iterator(this, index), false);
+    insert_at(index, value.first, value.second);
+    return pair<iterator, bool>(iterator(this, index), true);
+  }
+  // throws invalid_iterator if pos is end() or from another map.
+  void erase(iterator pos) {
+    if(pos.container != this || pos.index >= size()) throw invalid_iterator();
+    keys_.erase(pos.index);
+    values_.erase(pos.index);
+  }
+};
+
+}
+
+#endif
@@ -6,44 +6,288 @@
 
 // only for std::less<T>
 #include <functional>
+#include <climits>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
 
 #include "utility.hpp"
 #include "exceptions.hpp"
+#include "stats.hpp"
 
 namespace sjtu {
 
-template<class Key, class Tp, class Compare = std::less<Key>>
-class map {
+/**
+ * the shape of a map, reported by map::shape().
+ * the depth of the root is 0, so a lookup of a node of depth d visits d + 1 nodes.
+ */
+struct map_shape {
+  static constexpr size_t kHistogramSize = 128;
+
+  size_t nodes = 0;
+  // the longest root-to-leaf path in nodes, 0 for an empty map.
+  size_t height = 0;
+  // black nodes on every root-to-nil path, the nil excluded. 0 for an AVL map.
+  size_t black_height = 0;
+  double average_depth = 0;
+  // depth_histogram[d] is the number of nodes of depth d.
+  // the last bucket also counts all deeper nodes.
+  size_t depth_histogram[kHistogramSize] = {};
+  // the first broken invariant found, or nullptr if the tree is valid under its balance policy.
+  const char *violation = nullptr;
+};
+
+/**
+ * the header of a file written by map::save. it is followed by
+ * - count records of a key and a value, in the order of the keys;
+ * - the shape bitmap: three bits for each node in preorder, being
+ *   has left child, has right child, and is black. the last bit is 0 in an AVL map,
+ *   whose balance factors are recomputed from the shape.
+ * the file is in native byte order.
+ */
+struct map_file_header {
+  static constexpr std::uint32_t kVersion = 1;
+
+  char magic[8];
+  std::uint32_t version, key_size, value_size, reserved;
+  std::uint64_t count;
+
+  static map_file_header make(size_t key_size, size_t value_size, size_t count) {
+    map_file_header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "SJTUMAP", 8);
+    header.version = kVersion;
+    header.key_size = key_size;
+    header.value_size = value_size;
+    header.count = count;
+    return header;
+  }
+  bool matches(size_t key_size_, size_t value_size_) const {
+    return std::memcmp(magic, "SJTUMAP", 8) == 0 && version == kVersion
+      && key_size == key_size_ && value_size == value_size_;
+  }
+};
+
+/**
+ * whether Compare orders Key with one three-way comparison: compare(comp, lhs, rhs)
+ * is negative, zero or positive as lhs is less than, equivalent to or greater than rhs.
+ * it is detected for a comparator with a member int compare(const Key&, const Key&) const,
+ * and given for std::less<std::string>. specialize it for more.
+ * map uses it to stop a lookup at the matching node; without it, a lookup compares
+ * once per level and checks the equivalence once at the end.
+ */
+template<class Compare, class Key, class = void>
+struct three_way_compare : std::false_type {};
+
+template<class Compare, class Key>
+struct three_way_compare<Compare, Key, decltype(static_cast<void>(
+  std::declval<const Compare&>().compare(std::declval<const Key&>(), std::declval<const Key&>())))>
+  : std::true_type {
+  static int compare(const Compare &comp, const Key &lhs, const Key &rhs) {
+    return comp.compare(lhs, rhs);
+  }
+};
+
+template<>
+struct three_way_compare<std::less<std::string>, std::string> : std::true_type {
+  static int compare(const std::less<std::string> &, const std::string &lhs, const std::string &rhs) {
+    return lhs.compare(rhs);
+  }
+};
+
+/**
+ * the balance policies of map, chosen by its last template parameter.
+ * a red-black tree is at most 2log(n) high and rebalances with O(1) rotations per update.
+ * an AVL tree is at most 1.44log(n) high, so lookups visit fewer nodes,
+ * but an erasure may rotate all the way up. it suits maps read far more than written.
+ */
+struct red_black_balance {};
+struct avl_balance {};
+
+template<class Key, class Tp, class Compare = std::less<Key>, class Balance = red_black_balance, class Stats = no_stats>
+class map : private Stats {
+  // the Stats policy is a dependent base, so its calls are brought in by name.
+  using Stats::count_allocation;
+  using Stats::count_deallocation;
+  using Stats::count_comparison;
+  using Stats::count_rotation;
+  using Stats::count_recoloring;
+  using Stats::snapshot_stats;
+  using Stats::clear_stats;
 public:
   typedef pair<const Key, Tp> value_type;
 private:
+  // the balance factor of a node of an AVL map.
+  enum Slope : unsigned { kEven = 0, kLeftHigh = 1, kRightHigh = 2 };
   struct Node {
     enum class Color { Red, Black };
 
-    Node *parent {}, *left {}, *right {};
+    // the mark is the color in a red-black map and the Slope in an AVL map.
+    // a new node is a red or an even leaf.
+#ifdef SJTU_MAP_COMPACT_NODES
+    // the mark is the lowest 2 bits of the parent pointer, which are always 0 as Node is aligned.
+    // it saves the padded mark field, e.g. 8 of 40 bytes for map<int, int>.
+    std::uintptr_t parent_and_mark = 0;
+    Node *left {}, *right {};
+    value_type value;
+
+    Node(const value_type &value_): value(value_) {}
+    Node* parent() const {
+      return reinterpret_cast<Node*>(parent_and_mark & ~std::uintptr_t(3));
+    }
+    void set_parent(Node *parent) {
+      parent_and_mark = reinterpret_cast<std::uintptr_t>(parent) | (parent_and_mark & 3);
+    }
+    unsigned mark() const {
+      return parent_and_mark & 3;
+    }
+    void set_mark(unsigned mark) {
+      parent_and_mark = (parent_and_mark & ~std::uintptr_t(3)) | mark;
+    }
+#else
+    Node *parent_ {}, *left {}, *right {};
     value_type value;
-    Color color;
+    unsigned char mark_;
 
-    Node(const value_type &value_): value(value_), color(Color::Red) {}
+    Node(const value_type &value_): value(value_), mark_(0) {}
+    Node* parent() const {
+      return parent_;
+    }
+    void set_parent(Node *parent) {
+      parent_ = parent;
+    }
+    unsigned mark() const {
+      return mark_;
+    }
+    void set_mark(unsigned mark) {
+      mark_ = mark;
+    }
+#endif
+    Color color() const {
+      return static_cast<Color>(mark());
+    }
+    void set_color(Color color) {
+      set_mark(static_cast<unsigned>(color));
+    }
+    Slope slope() const {
+      return static_cast<Slope>(mark());
+    }
     Node(const Node &other) = delete;
     Node(Node &&other) = delete;
   };
+#ifdef SJTU_MAP_COMPACT_NODES
+  // nodes are carved from blocks owned by the map, so they pay no allocator header or rounding.
+  // erased nodes are reused through a free list, and the blocks are released by clear().
+  struct NodePool {
+    static constexpr size_t kBlockNodes = 256;
+    union Slot {
+      Slot *next;
+      alignas(Node) unsigned char storage[sizeof(Node)];
+    };
+    struct Block {
+      Block *next;
+      Slot slots[kBlockNodes];
+    };
+
+    Block *blocks = nullptr;
+    Slot *free_slots = nullptr;
+    size_t block_used = kBlockNodes;
+
+    NodePool() = default;
+    NodePool(const NodePool &other) = delete;
+    ~NodePool() {
+      release();
+    }
+    void* allocate() {
+      if(free_slots != nullptr) {
+        Slot *slot = free_slots;
+        free_slots = slot->next;
+        return slot;
+      }
+      if(block_used == kBlockNodes) {
+        Block *block = new Block;
+        block->next = blocks;
+        blocks = block;
+        block_used = 0;
+      }
+      return &blocks->slots[block_used++];
+    }
+    void deallocate(void *ptr) {
+      Slot *slot = static_cast<Slot*>(ptr);
+      slot->next = free_slots;
+      free_slots = slot;
+    }
+    // every node should have been destroyed.
+    void release() {
+      while(blocks != nullptr) {
+        Block *block = blocks;
+        blocks = block->next;
+        delete block;
+      }
+      free_slots = nullptr;
+      block_used = kBlockNodes;
+    }
+    void swap(NodePool &other) {
+      std::swap(blocks, other.blocks);
+      std::swap(free_slots, other.free_slots);
+      std::swap(block_used, other.block_used);
+    }
+  };
+  NodePool pool_;
+#endif
 
   Node *root_, *left_most_, *right_most_;
   size_t size_;
   Compare lesser_comparer_;
 
-  void self_check(Node *node) {
-    if(node == nullptr) return;
-    if(node->left != nullptr) {
-      assert(node->left->parent == node);
-      self_check(node->left);
-    }
-    if(node->right != nullptr) {
-      assert(node->right->parent == node);
-      self_check(node->right);
-    }
+  // walks the subtree and returns its rank: the black height in a red-black map, the height in an AVL map.
+  // the keys of the subtree should be in (lower, upper), where nullptr stands for no bound.
+  // the comparator is called directly, so that auditing doesn't show up in stats().
+  size_t audit(const Node *node, size_t depth, const Key *lower, const Key *upper,
+    map_shape &shape, size_t &depth_sum) const {
+    if(node == nullptr) return 0;
+    ++shape.nodes;
+    depth_sum += depth;
+    if(depth + 1 > shape.height) shape.height = depth + 1;
+    ++shape.depth_histogram[depth < map_shape::kHistogramSize ? depth : map_shape::kHistogramSize - 1];
+    // after the first violation, the walk only counts.
+    if(shape.violation != nullptr) ;
+    else if((lower != nullptr && !lesser_comparer_(*lower, node->value.first))
+      || (upper != nullptr && !lesser_comparer_(node->value.first, *upper)))
+      shape.violation = "keys out of order";
+    else if((node->left != nullptr && node->left->parent() != node)
+      || (node->right != nullptr && node->right->parent() != node))
+      shape.violation = "broken parent link";
+    size_t left_rank = audit(node->left, depth + 1, lower, &node->value.first, shape, depth_sum);
+    size_t right_rank = audit(node->right, depth + 1, &node->value.first, upper, shape, depth_sum);
+    if(shape.violation == nullptr) shape.violation = balance_violation(node, left_rank, right_rank, Balance());
+    return rank(node, left_rank, right_rank, Balance());
+  }
+  static const char* balance_violation(const Node *node, size_t left_rank, size_t right_rank, red_black_balance) {
+    if(node->mark() > 1) return "bad color";
+    if(is_red(node) && (is_red(node->left) || is_red(node->right))) return "red node with a red child";
+    if(left_rank != right_rank) return "unequal black heights";
+    return nullptr;
+  }
+  static const char* balance_violation(const Node *node, size_t left_rank, size_t right_rank, avl_balance) {
+    if(left_rank > right_rank + 1 || right_rank > left_rank + 1) return "unbalanced node";
+    if(node->slope() != slope_of(left_rank, right_rank)) return "wrong balance factor";
+    return nullptr;
+  }
+  static size_t rank(const Node *node, size_t left_rank, size_t, red_black_balance) {
+    return left_rank + (node->color() == Node::Color::Black);
+  }
+  static size_t rank(const Node *, size_t left_rank, size_t right_rank, avl_balance) {
+    return (left_rank > right_rank ? left_rank : right_rank) + 1;
+  }
+  static Slope slope_of(size_t left_height, size_t right_height) {
+    if(left_height == right_height) return kEven;
+    return left_height > right_height ? kLeftHigh : kRightHigh;
   }
 
   void clear_tree(Node *node) {
@@ -51,47 +295,374 @@ private:
     // if(node == nullptr) return; // for the deconstruction of rvalue-moved map.
     if(node->left != nullptr) clear_tree(node->left);
     if(node->right != nullptr) clear_tree(node->right);
-    delete node;
+    delete_node(node);
+  }
+  static constexpr size_t kFileBufferSize = 1 << 16;
+  // files are buffered here, so that a record doesn't cost a call into stdio.
+  struct FileWriter {
+    unsigned char *buffer;
+    std::FILE *file;
+    size_t used = 0;
+    // the bits of the shape bitmap, packed from the lowest bit of each byte.
+    unsigned char bits = 0;
+    int bit_count = 0;
+    bool ok = true;
+
+    explicit FileWriter(const char *path)
+      : buffer(new unsigned char[kFileBufferSize]), file(std::fopen(path, "wb")) {}
+    FileWriter(const FileWriter &other) = delete;
+    ~FileWriter() {
+      if(file != nullptr) std::fclose(file);
+      delete[] buffer;
+    }
+    void drain() {
+      ok = ok && (used == 0 || std::fwrite(buffer, 1, used, file) == used);
+      used = 0;
+    }
+    void write(const void *data, size_t n) {
+      if(used + n > kFileBufferSize) drain();
+      if(n > kFileBufferSize) ok = ok && std::fwrite(data, 1, n, file) == n;
+      else {
+        std::memcpy(buffer + used, data, n);
+        used += n;
+      }
+    }
+    void put(bool bit) {
+      bits |= static_cast<unsigned char>(bit) << bit_count;
+      if(++bit_count == 8) {
+        write(&bits, 1);
+        bits = 0;
+        bit_count = 0;
+      }
+    }
+    // returns whether everything has been written.
+    bool close() {
+      if(bit_count != 0) write(&bits, 1);
+      drain();
+      ok = (std::fclose(file) == 0) && ok;
+      file = nullptr;
+      return ok;
+    }
+  };
+  struct FileInput {
+    unsigned char *buffer;
+    std::FILE *file;
+    size_t pos = 0, end = 0;
+
+    explicit FileInput(const char *path)
+      : buffer(new unsigned char[kFileBufferSize]), file(std::fopen(path, "rb")) {}
+    FileInput(const FileInput &other) = delete;
+    ~FileInput() {
+      if(file != nullptr) std::fclose(file);
+      delete[] buffer;
+    }
+    // throws runtime_error if the file ends first.
+    void read(void *data, size_t n) {
+      unsigned char *out = static_cast<unsigned char*>(data);
+      while(n != 0) {
+        if(pos == end) {
+          pos = 0;
+          end = (file == nullptr) ? 0 : std::fread(buffer, 1, kFileBufferSize, file);
+          if(end == 0) throw runtime_error();
+        }
+        size_t chunk = (n < end - pos) ? n : end - pos;
+        std::memcpy(out, buffer + pos, chunk);
+        pos += chunk;
+        out += chunk;
+        n -= chunk;
+      }
+    }
+    // the size of the file in bytes. the position is lost, so seek before reading on.
+    std::uint64_t size() {
+      long bytes = -1;
+      if(file != nullptr && std::fseek(file, 0, SEEK_END) == 0) bytes = std::ftell(file);
+      if(bytes < 0) throw runtime_error();
+      pos = end = 0;
+      return static_cast<std::uint64_t>(bytes);
+    }
+    // std::fseek takes a long, so an offset beyond LONG_MAX is refused.
+    void seek(std::uint64_t offset) {
+      if(file == nullptr || offset > static_cast<std::uint64_t>(LONG_MAX)
+        || std::fseek(file, static_cast<long>(offset), SEEK_SET) != 0) throw runtime_error();
+      pos = end = 0;
+    }
+  };
+  // reads the records and the shape bitmap of a file at the same time, through two handles.
+  struct FileReader {
+    FileInput records, shape;
+    size_t remaining = 0;
+    unsigned char bits = 0;
+    int bit_count = 0;
+
+    explicit FileReader(const char *path): records(path), shape(path) {}
+    bool get() {
+      if(bit_count == 0) {
+        shape.read(&bits, 1);
+        bit_count = 8;
+      }
+      --bit_count;
+      bool bit = bits & 1;
+      bits >>= 1;
+      return bit;
+    }
+    value_type record() {
+      if(remaining == 0) throw runtime_error();
+      --remaining;
+      typename std::aligned_storage<sizeof(Key), alignof(Key)>::type key;
+      typename std::aligned_storage<sizeof(Tp), alignof(Tp)>::type value;
+      records.read(&key, sizeof(Key));
+      records.read(&value, sizeof(Tp));
+      return value_type(*reinterpret_cast<const Key*>(&key), *reinterpret_cast<const Tp*>(&value));
+    }
+  };
+  void save_shape(const Node *node, FileWriter &writer) const {
+    writer.put(node->left != nullptr);
+    writer.put(node->right != nullptr);
+    writer.put(std::is_same<Balance, red_black_balance>::value && node->color() == Node::Color::Black);
+    if(node->left != nullptr) save_shape(node->left, writer);
+    if(node->right != nullptr) save_shape(node->right, writer);
+  }
+  // rebuilds the subtree whose bits come next in preorder, taking its records in order,
+  // and sets height to its height. frees what it has built if the file is broken.
+  Node* load_tree(FileReader &reader, size_t depth, size_t &height) {
+    // no valid balanced tree of at most 2^64 nodes is that deep.
+    if(depth >= map_shape::kHistogramSize) throw runtime_error();
+    bool has_left = reader.get(), has_right = reader.get(), is_black = reader.get();
+    size_t left_height = 0, right_height = 0;
+    Node *left = has_left ? load_tree(reader, depth + 1, left_height) : nullptr, *node;
+    try {
+      node = new_node(reader.record());
+    } catch(...) {
+      if(left != nullptr) clear_tree(left);
+      throw;
+    }
+    node->left = left;
+    if(left != nullptr) left->set_parent(node);
+    if(has_right) {
+      try {
+        node->right = load_tree(reader, depth + 1, right_height);
+      } catch(...) {
+        clear_tree(node);
+        throw;
+      }
+      node->right->set_parent(node);
+    }
+    if(std::is_same<Balance, red_black_balance>::value)
+      node->set_color(is_black ? Node::Color::Black : Node::Color::Red);
+    else
+      node->set_mark(slope_of(left_height, right_height));
+    height = (left_height > right_height ? left_height : right_height) + 1;
+    return node;
   }
+
   void copy_tree(Node *des, Node *src, const map &other) {
     // src already copied to des
     if(src->left != nullptr) {
-      des->left = new Node(src->left->value);
-      des->left->parent = des;
-      des->left->color = src->left->color;
+      des->left = new_node(src->left->value);
+      des->left->set_parent(des);
+      des->left->set_mark(src->left->mark());
       if(other.left_most_ == src->left) left_most_ = des->left;
       copy_tree(des->left, src->left, other);
     }
     if(src->right != nullptr) {
-      des->right = new Node(src->right->value);
-      des->right->parent = des;
-      des->right->color = src->right->color;
+      des->right = new_node(src->right->value);
+      des->right->set_parent(des);
+      des->right->set_mark(src->right->mark());
       if(other.right_most_ == src->right) right_most_ = des->right;
       copy_tree(des->right, src->right, other);
     }
   }
 
+#ifdef SJTU_MAP_COMPACT_NODES
+  Node* new_node(const value_type &value) {
+    void *ptr = pool_.allocate();
+    try {
+      new(ptr) Node(value);
+    } catch(...) {
+      pool_.deallocate(ptr);
+      throw;
+    }
+    count_allocation(sizeof(Node));
+    return static_cast<Node*>(ptr);
+  }
+  void delete_node(Node *node) {
+    count_deallocation();
+    node->~Node();
+    pool_.deallocate(node);
+  }
+#else
+  Node* new_node(const value_type &value) {
+    count_allocation(sizeof(Node));
+    return new Node(value);
+  }
+  void delete_node(Node *node) {
+    count_deallocation();
+    delete node;
+  }
+#endif
+  // takes the whole tree of other, which is left empty. this map should be empty.
+  void steal_tree(map &other) {
+    root_ = other.root_;
+    left_most_ = other.left_most_;
+    right_most_ = other.right_most_;
+    size_ = other.size_;
+    other.root_ = other.left_most_ = other.right_most_ = nullptr;
+    other.size_ = 0;
+#ifdef SJTU_MAP_COMPACT_NODES
+    pool_.swap(other.pool_);
+#endif
+  }
+  bool less(const Key &lhs, const Key &rhs) const {
+    count_comparison();
+    return lesser_comparer_(lhs, rhs);
+  }
+  int compare(const Key &lhs, const Key &rhs) const {
+    count_comparison();
+    return three_way_compare<Compare, Key>::compare(lesser_comparer_, lhs, rhs);
+  }
+  // the node holding key, or nullptr. then key belongs under parent, on the left if is_left.
+  // parent is nullptr if the map is empty.
+  Node* descend(const Key &key, Node *&parent, bool &is_left) const {
+    return descend(key, parent, is_left, three_way_compare<Compare, Key>());
+  }
+  Node* descend(const Key &key, Node *&parent, bool &is_left, std::true_type) const {
+    parent = nullptr;
+    is_left = true;
+    for(Node *node = root_; node != nullptr; ) {
+      int order = compare(key, node->value.first);
+      if(order == 0) return node;
+      parent = node;
+      is_left = order < 0;
+      node = is_left ? node->left : node->right;
+    }
+    return nullptr;
+  }
+  // one less() per level: the last node not less than key is the only one that can hold it.
+  Node* descend(const Key &key, Node *&parent, bool &is_left, std::false_type) const {
+    parent = nullptr;
+    is_left = true;
+    Node *candidate = nullptr;
+    for(Node *node = root_; node != nullptr; ) {
+      parent = node;
+      is_left = !less(node->value.first, key);
+      if(is_left) {
+        candidate = node;
+        node = node->left;
+      } else {
+        node = node->right;
+      }
+    }
+    if(candidate != nullptr && !less(key, candidate->value.first)) return candidate;
+    return nullptr;
+  }
+  // find_batch runs this many lookups side by side.
+  static constexpr size_t kBatchLanes = 16;
+  // one lookup of find_batch, advanced one level at a time.
+  struct BatchLane {
+    const Key *key;
+    Node *node, *candidate;
+  };
+  static void prefetch(const Node *node) {
+#if defined(__GNUC__)
+    __builtin_prefetch(&node->value);
+#endif
+  }
+  // descends one level like descend(); true once the lookup is over, with the result in candidate.
+  bool batch_step(BatchLane &lane, std::true_type) const {
+    int order = compare(*lane.key, lane.node->value.first);
+    if(order == 0) {
+      lane.candidate = lane.node;
+      return true;
+    }
+    lane.node = order < 0 ? lane.node->left : lane.node->right;
+    return lane.node == nullptr;
+  }
+  bool batch_step(BatchLane &lane, std::false_type) const {
+    if(!less(lane.node->value.first, *lane.key)) {
+      lane.candidate = lane.node;
+      lane.node = lane.node->left;
+    } else {
+      lane.node = lane.node->right;
+    }
+    if(lane.node != nullptr) return false;
+    if(lane.candidate != nullptr && less(*lane.key, lane.candidate->value.first)) lane.candidate = nullptr;
+    return true;
+  }
+  // calls emit(node) with the node of every key in [first, last) in order, nullptr if it's missing.
+  // the lookups of up to kBatchLanes keys take turns, each prefetching its next node,
+  // so that their cache misses overlap instead of following one another.
+  template<class KeyIt, class Emit>
+  void batch_descend(KeyIt first, KeyIt last, Emit emit) const {
+    BatchLane lanes[kBatchLanes];
+    bool done[kBatchLanes];
+    while(first != last) {
+      size_t count = 0;
+      for(; count < kBatchLanes && first != last; ++count, ++first) {
+        lanes[count] = BatchLane{&*first, root_, nullptr};
+        done[count] = (root_ == nullptr);
+      }
+      size_t active = (root_ == nullptr) ? 0 : count;
+      while(active != 0) {
+        for(size_t i = 0; i < count; ++i) {
+          if(done[i]) continue;
+          if(batch_step(lanes[i], three_way_compare<Compare, Key>())) {
+            done[i] = true;
+            --active;
+          } else {
+            prefetch(lanes[i].node);
+          }
+        }
+      }
+      for(size_t i = 0; i < count; ++i) emit(lanes[i].candidate);
+    }
+  }
+  // links a new node holding value under parent, as given by descend().
+  Node* attach(const value_type &value, Node *parent, bool is_left) {
+    Node *res = new_node(value);
+    ++size_;
+    if(parent == nullptr) {
+      root_ = left_most_ = right_most_ = res;
+      return res;
+    }
+    res->set_parent(parent);
+    if(is_left) {
+      parent->left = res;
+      if(parent == left_most_) left_most_ = res;
+    } else {
+      parent->right = res;
+      if(parent == right_most_) right_most_ = res;
+    }
+    insertion_maintain(res, Balance());
+    return res;
+  }
+  void paint(Node *node, typename Node::Color color) {
+    count_recoloring();
+    node->set_color(color);
+  }
+
   void left_rotate(Node *node) {
+    count_rotation();
     Node *child = node->right;
-    child->parent = node->parent;
-    if(child->parent == nullptr) root_ = child;
-    else if(child->parent->left == node) child->parent->left = child;
-    else child->parent->right = child;
+    child->set_parent(node->parent());
+    if(child->parent() == nullptr) root_ = child;
+    else if(child->parent()->left == node) child->parent()->left = child;
+    else child->parent()->right = child;
     node->right = child->left;
-    if(node->right != nullptr) node->right->parent = node;
+    if(node->right != nullptr) node->right->set_parent(node);
     child->left = node;
-    node->parent = child;
+    node->set_parent(child);
   }
   void right_rotate(Node *node) {
+    count_rotation();
     Node *child = node->left;
-    child->parent = node->parent;
-    if(child->parent == nullptr) root_ = child;
-    else if(child->parent->left == node) child->parent->left = child;
-    else child->parent->right = child;
+    child->set_parent(node->parent());
+    if(child->parent() == nullptr) root_ = child;
+    else if(child->parent()->left == node) child->parent()->left = child;
+    else child->parent()->right = child;
     node->left = child->right;
-    if(node->left != nullptr) node->left->parent = node;
+    if(node->left != nullptr) node->left->set_parent(node);
     child->right = node;
-    node->parent = child;
+    node->set_parent(child);
   }
 
   // changes node to its next.
@@ -101,8 +672,8 @@ private:
     // if node == root here, for node != right_most_, we must have node->right != nullptr.
     // so is in the loop.
     if(node->right == nullptr) {
-      while(node->parent->right == node) node = node->parent;
-      node = node->parent;
+      while(node->parent()->right == node) node = node->parent();
+      node = node->parent();
       return node;
     }
     node = node->right;
@@ -116,8 +687,8 @@ private:
     // if node == root here, for node != left_most_, we must have node->left != nullptr.
     // so is in the loop.
     if(node->left == nullptr) {
-      while(node->parent->left == node) node = node->parent;
-      node = node->parent;
+      while(node->parent()->left == node) node = node->parent();
+      node = node->parent();
       return node;
     }
     node = node->left;
@@ -125,159 +696,231 @@ private:
     return node;
   }
 
-  void insertion_maintain(Node *node) {
-    // This node should be red.
-    // maintain upwards.
-
-    // Case 1: the new node is the root / tree is previously empty.
-    if(node == root_) {
-      node->color = Node::Color::Black;
+  static bool is_red(const Node *node) {
+    return node != nullptr && node->color() == Node::Color::Red;
+  }
+  // node is red and may have a red parent. the loop walks up while the uncle is red.
+  void insertion_maintain(Node *node, red_black_balance) {
+    while(true) {
+      // Case 1: the new node is the root / tree is previously empty.
+      if(node == root_) {
+        paint(node, Node::Color::Black);
+        return;
+      }
+      Node *parent = node->parent();
+      // Case 2: parent is black.
+      if(parent->color() == Node::Color::Black) return;
+      // Case 3: parent is red root.
+      if(parent == root_) {
+        paint(parent, Node::Color::Black);
+        return;
+      }
+      // node has a black grandparent.
+      Node *grandparent = parent->parent();
+      bool parent_is_left = (grandparent->left == parent);
+      Node *uncle = parent_is_left ? grandparent->right : grandparent->left;
+      // Case 4: uncle is red. the red moves up to grandparent, which is fixed next.
+      if(is_red(uncle)) {
+        paint(parent, Node::Color::Black);
+        paint(uncle, Node::Color::Black);
+        paint(grandparent, Node::Color::Red);
+        node = grandparent;
+        continue;
+      }
+      // Case 5: the direction of the two parent-child relationship isn't identical.
+      if(parent_is_left != (parent->left == node)) {
+        if(parent_is_left) left_rotate(parent);
+        else right_rotate(parent);
+        std::swap(node, parent);
+      }
+      // Case 6: the direction of the two parent-child relationship is identical.
+      paint(parent, Node::Color::Black);
+      paint(grandparent, Node::Color::Red);
+      if(parent_is_left) right_rotate(grandparent);
+      else left_rotate(grandparent);
       return;
     }
-
-    // node has parent.
-    Node *parent = node->parent;
-    // Case 2: parent is black.
-    if(parent->color == Node::Color::Black) return;
-
-    // parent is red.
-    // Case 3: parent is red root.
-    if(parent == root_) {
-      parent->color = Node::Color::Black;
+  }
+  // the black length through node has just been shortened by 1.
+  // the loop walks up while the sibling and its children are all black.
+  // node itself is never moved off its parent, so a black leaf can be fixed before it's unlinked.
+  void erasure_maintain(Node *node, red_black_balance) {
+    // Case 1: node is root. no actual node is affected.
+    while(node != root_) {
+      Node *parent = node->parent();
+      bool is_left = (parent->left == node);
+      Node *sibling = is_left ? parent->right : parent->left;
+      // Case 2: sibling is red. rotate it above parent, so that node gets a black sibling.
+      if(is_red(sibling)) {
+        paint(parent, Node::Color::Red);
+        paint(sibling, Node::Color::Black);
+        if(is_left) {
+          left_rotate(parent);
+          sibling = parent->right;
+        } else {
+          right_rotate(parent);
+          sibling = parent->left;
+        }
+      }
+      // the black length through node is at least 1, so the sibling's side
+      // holds a black node and the sibling can't be null.
+      Node *near = is_left ? sibling->left : sibling->right;
+      Node *far = is_left ? sibling->right : sibling->left;
+      // Case 3: sibling has no red children. take one black away from the sibling's side too.
+      if(!is_red(near) && !is_red(far)) {
+        paint(sibling, Node::Color::Red);
+        if(parent->color() == Node::Color::Red) {
+          paint(parent, Node::Color::Black);
+          return;
+        }
+        node = parent;
+        continue;
+      }
+      // Case 4: sibling has a red child. first make sure the far one is red.
+      if(!is_red(far)) {
+        paint(near, Node::Color::Black);
+        paint(sibling, Node::Color::Red);
+        if(is_left) right_rotate(sibling);
+        else left_rotate(sibling);
+        far = sibling;
+        sibling = near;
+      }
+      paint(sibling, parent->color());
+      paint(parent, Node::Color::Black);
+      paint(far, Node::Color::Black);
+      if(is_left) left_rotate(parent);
+      else right_rotate(parent);
       return;
     }
+  }
 
-    // node has grandparent (black).
-    Node *grandparent = parent->parent;
-    Node *uncle = (grandparent->left == parent) ? grandparent->right : grandparent->left;
-    // Case 4: uncle node exists, and it's red.
-    if(uncle != nullptr && uncle->color == Node::Color::Red) {
-      parent->color = uncle->color = Node::Color::Black;
-      grandparent->color = Node::Color::Red;
-      insertion_maintain(grandparent);
-      return;
+  void tilt(Node *node, Slope slope) {
+    count_recoloring();
+    node->set_mark(slope);
+  }
+  // node has become 2 higher on its left if left_high, or else on its right.
+  // rotates the higher child, or its inner child, above node and returns it.
+  // shrunk is false only if the subtree kept its height, which happens only after an erasure.
+  Node* rotate_high_side(Node *node, bool left_high, bool &shrunk) {
+    Slope high = left_high ? kLeftHigh : kRightHigh, low = left_high ? kRightHigh : kLeftHigh;
+    Node *child = left_high ? node->left : node->right;
+    if(child->slope() != low) {
+      // the single rotation. an even child, left by an erasure, stays higher on the same side.
+      shrunk = (child->slope() == high);
+      if(left_high) right_rotate(node);
+      else left_rotate(node);
+      tilt(node, shrunk ? kEven : high);
+      tilt(child, shrunk ? kEven : low);
+      return child;
     }
-
-    // uncle node doesn't exist or is black.
-    // Case 5: the direction of the two parent-child relationship isn't identical.
-    if((grandparent->left == parent) ^ (parent->left == node)) {
-      if(parent->left == node) right_rotate(parent);
-      else left_rotate(parent);
-      std::swap(node, parent);
-      // Go on to case 6.
-    }
-
-    // Case 6: the direction of the two parent-child relationship is identical.
-    parent->color = Node::Color::Black;
-    grandparent->color = Node::Color::Red;
-    if(grandparent->left == parent) right_rotate(grandparent);
-    else left_rotate(grandparent);
-  }
-  void erasure_maintain(Node *node) {
-    // The black length of parent of this node has just been shortened by 1.
-    // the ancestors of this node might be affected.
-    // maintain upwards.
-
-    // Case 1: node is root.
-    if(node == root_) return; // no actual node is affected.
-
-    // node here has parent.
-    Node *parent = node->parent;
-    Node *sibling = (parent->left == node) ? parent->right : parent->left;
-    // Check case: sibling not exist.
-    if(sibling == nullptr) {
-      // at least parent node is not affected.
-      // other ancestors are still in need of maintenance.
-      erasure_maintain(parent);
-      return;
+    // the double rotation: the inner grandchild goes on top, and the tilt it had is split between both sides.
+    Node *grandchild = left_high ? child->right : child->left;
+    Slope slope = grandchild->slope();
+    if(left_high) {
+      left_rotate(child);
+      right_rotate(node);
+    } else {
+      right_rotate(child);
+      left_rotate(node);
     }
-
-    // Case 2: sibling node is red.
-    if(sibling->color == Node::Color::Red) {
-      // parent should be black.
-      // children of sibling nodes should be black.
-      parent->color = Node::Color::Red;
-      sibling->color = Node::Color::Black;
-      if(parent->left == sibling) {
-        right_rotate(parent);
-        sibling = parent->left;
-      } else {
-        left_rotate(parent);
-        sibling = parent->right;
+    tilt(child, slope == low ? high : kEven);
+    tilt(node, slope == high ? low : kEven);
+    tilt(grandchild, kEven);
+    shrunk = true;
+    return grandchild;
+  }
+  // the subtree of node, a new leaf, has grown by 1. the loop walks up while its parent was even.
+  void insertion_maintain(Node *node, avl_balance) {
+    while(node != root_) {
+      Node *parent = node->parent();
+      bool is_left = (parent->left == node);
+      Slope slope = parent->slope();
+      if(slope == kEven) {
+        tilt(parent, is_left ? kLeftHigh : kRightHigh);
+        node = parent;
+        continue;
       }
-      // now sibling node is black (or not exist).
-      // continue to further maintenance.
-    }
-
-    // Check case: sibling not exist.
-    if(sibling == nullptr) {
-      // at least parent node is not affected.
-      // other ancestors are still in need of maintenance.
-      erasure_maintain(parent);
+      // the lower side has caught up.
+      if(slope != (is_left ? kLeftHigh : kRightHigh)) {
+        tilt(parent, kEven);
+        return;
+      }
+      // after an insertion, a rotation always restores the old height.
+      bool shrunk;
+      rotate_high_side(parent, is_left, shrunk);
       return;
     }
-
-    // Case 3: sibling has no red children
-    if((sibling->left == nullptr || sibling->left->color == Node::Color::Black)
-      && (sibling->right == nullptr || sibling->right->color == Node::Color::Black)) {
-      sibling->color = Node::Color::Black;
-      if(parent->color == Node::Color::Red) {
-        parent->color = Node::Color::Black;
+  }
+  // the subtree on the left of parent if is_left, or else on its right, has shrunk by 1.
+  // the loop walks up while the subtree of parent shrinks too.
+  void erasure_maintain(Node *parent, bool is_left, avl_balance) {
+    while(parent != nullptr) {
+      Slope slope = parent->slope();
+      if(slope == kEven) {
+        tilt(parent, is_left ? kRightHigh : kLeftHigh);
         return;
+      }
+      Node *top = parent;
+      if(slope == (is_left ? kLeftHigh : kRightHigh)) {
+        tilt(parent, kEven);
       } else {
-        erasure_maintain(parent);
-        return;
+        bool shrunk;
+        top = rotate_high_side(parent, !is_left, shrunk);
+        if(!shrunk) return;
       }
+      parent = top->parent();
+      if(parent != nullptr) is_left = (parent->left == top);
     }
+  }
 
-    // Case 4: sibling has at least one red children
-    // Modify: make sibling's opposite-side (compared to node's side in parent) child is red.
-    if(node == parent->left) {
-      if(sibling->right == nullptr || sibling->right->color == Node::Color::Black) {
-        // sibling->left->color == Red
-        sibling->left->color = Node::Color::Black;
-        sibling->color = Node::Color::Red;
-        right_rotate(sibling);
-        sibling = parent->right;
-      }
-      // now sibling->right->color = Red
-      sibling->color = parent->color;
-      parent->color = Node::Color::Black;
-      sibling->right->color = Node::Color::Black;
-      left_rotate(parent);
-      return;
-    } else {
-      // node == parent_right
-      if(sibling->left == nullptr || sibling->left->color == Node::Color::Black) {
-        // sibling->right->color == Red
-        sibling->right->color = Node::Color::Black;
-        sibling->color = Node::Color::Red;
-        left_rotate(sibling);
-        sibling = parent->left;
-      }
-      // now sibling->left->color = Red
-      sibling->color = parent->color;
-      parent->color = Node::Color::Black;
-      sibling->left->color = Node::Color::Black;
-      right_rotate(parent);
+  // removes node, which has at most one child, from the tree and frees it.
+  void unlink(Node *node, red_black_balance) {
+    bool to_maintain = (node->color() == Node::Color::Black);
+    if(node->left == nullptr && node->right == nullptr) {
+      // discard it.
+      // a black leaf is fixed while it's still linked, standing in for the empty subtree it leaves.
+      if(to_maintain) erasure_maintain(node, red_black_balance());
+      Node *parent = node->parent(); // definitely not nullptr, for size_ == 1 case has been handled.
+      if(parent->left == node) parent->left = nullptr;
+      else parent->right = nullptr;
+      delete_node(node);
       return;
     }
+    Node *parent = node->parent(); // may be nullptr if node == root_
+    Node *child = (node->left == nullptr) ? node->right : node->left; // only one side is not nullptr.
+    if(parent == nullptr) root_ = child;
+    else if(parent->left == node) parent->left = child;
+    else parent->right = child;
+    child->set_parent(parent);
+    // node is black and its only child is red,
+    // so painting the child black restores the black height without further maintenance.
+    paint(child, Node::Color::Black);
+    delete_node(node);
+  }
+  void unlink(Node *node, avl_balance) {
+    Node *parent = node->parent(); // may be nullptr if node == root_
+    Node *child = (node->left == nullptr) ? node->right : node->left; // a leaf, if any.
+    bool is_left = (parent != nullptr && parent->left == node);
+    if(parent == nullptr) root_ = child;
+    else if(is_left) parent->left = child;
+    else parent->right = child;
+    if(child != nullptr) child->set_parent(parent);
+    delete_node(node);
+    erasure_maintain(parent, is_left, avl_balance());
   }
-
-
 
 public:
   class const_iterator;
   class iterator {
-    friend void sjtu::map<Key, Tp, Compare>::erase(iterator pos);
+    friend void sjtu::map<Key, Tp, Compare, Balance, Stats>::erase(iterator pos);
     friend const_iterator;
   private:
-    const map<Key, Tp, Compare> *container;
+    const map *container;
     Node *node;
 
   public:
     iterator(): container(nullptr), node(nullptr) {} // default iterator as end()
-    iterator(const map<Key, Tp, Compare> *the_map, Node *the_node): container(the_map), node(the_node) {}
+    iterator(const map *the_map, Node *the_node): container(the_map), node(the_node) {}
     iterator(const iterator &other): container(other.container), node(other.node) {}
     iterator& operator=(const iterator &other) = default;
     iterator& operator=(iterator &&other) = default;
@@ -327,12 +970,12 @@ public:
   class const_iterator {
     friend iterator;
   private:
-    const map<Key, Tp, Compare> *container;
+    const map *container;
     Node *node;
 
   public:
     const_iterator(): container(nullptr), node(nullptr) {} // default iterator as cend()
-    const_iterator(const map<Key, Tp, Compare> *the_map, Node *the_node): container(the_map), node(the_node) {}
+    const_iterator(const map *the_map, Node *the_node): container(the_map), node(the_node) {}
     const_iterator(const const_iterator &other): container(other.container), node(other.node) {}
     const_iterator(const iterator &other): container(other.container), node(other.node) {}
     const_iterator& operator=(const const_iterator &other) = default;
@@ -385,20 +1028,23 @@ public:
     root_ = nullptr;
     left_most_ = right_most_ = nullptr;
   }
+  explicit map(const Compare &comp): map() {
+    lesser_comparer_ = comp;
+  }
   map(const map &other): map() {
+    lesser_comparer_ = other.lesser_comparer_;
     if(other.empty()) return;
     size_ = other.size_;
-    root_ = new Node(other.root_->value);
-    root_->color =  other.root_->color;
+    root_ = new_node(other.root_->value);
+    root_->set_mark(other.root_->mark());
     if(other.left_most_ == other.root_) left_most_ = root_;
     if(other.right_most_ == other.root_) right_most_ = root_;
     copy_tree(root_, other.root_, other);
   }
-  map(map &&other) {
-    size_ = other.size_;
-    root_ = other.root_;
-    left_most_ = other.left_most_;
-    right_most_ = other.right_most_;
+  // O(1); other is left empty but usable.
+  map(map &&other) noexcept(std::is_nothrow_copy_assignable<Compare>::value): map() {
+    lesser_comparer_ = other.lesser_comparer_;
+    steal_tree(other);
   }
   ~map() {
     clear();
@@ -406,22 +1052,22 @@ public:
   map& operator=(const map &other) {
     if(this == &other) return *this;
     clear();
+    lesser_comparer_ = other.lesser_comparer_;
     if(other.empty()) return *this;
     size_ = other.size_;
-    root_ = new Node(other.root_->value);
-    root_->color =  other.root_->color;
+    root_ = new_node(other.root_->value);
+    root_->set_mark(other.root_->mark());
     if(other.left_most_ == other.root_) left_most_ = root_;
     if(other.right_most_ == other.root_) right_most_ = root_;
     copy_tree(root_, other.root_, other);
     return *this;
   }
-  map& operator=(map &&other) {
+  // O(1) besides freeing the old elements; other is left empty but usable.
+  map& operator=(map &&other) noexcept(std::is_nothrow_copy_assignable<Compare>::value) {
     if(this == &other) return *this;
     clear();
-    size_ = other.size_;
-    root_ = other.root_;
-    left_most_ = other.left_most_;
-    right_most_ = other.right_most_;
+    lesser_comparer_ = other.lesser_comparer_;
+    steal_tree(other);
     return *this;
   }
   // when empty(), begin() == end().
@@ -439,11 +1085,15 @@ public:
     return const_iterator(this, nullptr);
   }
   void clear() {
-    if(empty()) return;
-    clear_tree(root_);
-    size_ = 0;
-    root_ = nullptr;
-    left_most_ = right_most_ = nullptr;
+    if(!empty()) {
+      clear_tree(root_);
+      size_ = 0;
+      root_ = nullptr;
+      left_most_ = right_most_ = nullptr;
+    }
+#ifdef SJTU_MAP_COMPACT_NODES
+    pool_.release();
+#endif
   }
   size_t size() const {
     return size_;
@@ -451,30 +1101,130 @@ public:
   bool empty() const {
     return size_ == 0;
   }
+  // O(n). also validates the invariants of the balance policy, see map_shape::violation.
+  map_shape shape() const {
+    map_shape res;
+    size_t depth_sum = 0;
+    // a red root is allowed, as maintenance of an insertion below it repaints it.
+    if(root_ != nullptr && root_->parent() != nullptr) res.violation = "root has a parent";
+    size_t rank = audit(root_, 0, nullptr, nullptr, res, depth_sum);
+    if(std::is_same<Balance, red_black_balance>::value) res.black_height = rank;
+    if(res.nodes != 0) res.average_depth = static_cast<double>(depth_sum) / res.nodes;
+    if(res.violation == nullptr) {
+      if(res.nodes != size_) res.violation = "size mismatch";
+      else if(root_ != nullptr) {
+        const Node *node = root_;
+        while(node->left != nullptr) node = node->left;
+        if(node != left_most_) res.violation = "stale left_most";
+        node = root_;
+        while(node->right != nullptr) node = node->right;
+        if(node != right_most_) res.violation = "stale right_most";
+      } else if(left_most_ != nullptr || right_most_ != nullptr)
+        res.violation = "stale left_most";
+    }
+    return res;
+  }
+  // O(n). throws runtime_error if any invariant is broken.
+  void self_check() const {
+    if(shape().violation != nullptr) throw runtime_error();
+  }
+  /**
+   * writes the map to a file in one sequential pass.
+   * Key and Tp should be trivially copyable.
+   * throws runtime_error if the file can't be written.
+   */
+  void save(const char *path) const {
+    static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Tp>::value,
+      "only trivially copyable keys and values can be saved");
+    FileWriter writer(path);
+    if(writer.file == nullptr) throw runtime_error();
+    map_file_header header = map_file_header::make(sizeof(Key), sizeof(Tp), size_);
+    writer.write(&header, sizeof(header));
+    for(Node *node = left_most_; node != nullptr; node = get_next(node)) {
+      writer.write(&node->value.first, sizeof(Key));
+      writer.write(&node->value.second, sizeof(Tp));
+    }
+    if(root_ != nullptr) save_shape(root_, writer);
+    if(!writer.close()) throw runtime_error();
+  }
+  /**
+   * replaces the content with the map saved in a file, in O(n) without rebalancing,
+   * as the saved tree is rebuilt node by node. the result is then checked with shape(),
+   * which compares each key with its bounds: at most 2n comparisons, not counted in stats().
+   * throws runtime_error if the file can't be read, holds other types,
+   * or isn't a valid tree under this comparator and balance policy; the map is unchanged then.
+   */
+  void load(const char *path) {
+    static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Tp>::value,
+      "only trivially copyable keys and values can be loaded");
+    map res;
+    res.lesser_comparer_ = lesser_comparer_;
+    {
+      FileReader reader(path);
+      map_file_header header;
+      reader.records.read(&header, sizeof(header));
+      if(!header.matches(sizeof(Key), sizeof(Tp))) throw runtime_error();
+      // the count is checked against the file size before seeking,
+      // so a corrupt header can't make the offset of the shape wrap around.
+      const std::uint64_t record_size = sizeof(Key) + sizeof(Tp), file_size = reader.shape.size();
+      if(file_size < sizeof(header) || header.count > (file_size - sizeof(header)) / record_size)
+        throw runtime_error();
+      reader.remaining = header.count;
+      reader.shape.seek(sizeof(header) + header.count * record_size);
+      size_t height;
+      if(header.count != 0) res.root_ = res.load_tree(reader, 0, height);
+      // set even if the tree is short of records, so that res frees what it holds.
+      res.size_ = header.count;
+      if(reader.remaining != 0) throw runtime_error();
+    }
+    if(res.root_ != nullptr) {
+      res.left_most_ = res.right_most_ = res.root_;
+      while(res.left_most_->left != nullptr) res.left_most_ = res.left_most_->left;
+      while(res.right_most_->right != nullptr) res.right_most_ = res.right_most_->right;
+    }
+    if(res.shape().violation != nullptr) throw runtime_error();
+    clear();
+    steal_tree(res);
+  }
+  // all zero with no_stats.
+  container_stats stats() const {
+    return snapshot_stats();
+  }
+  void reset_stats() {
+    clear_stats();
+  }
   // returns end iterator if search fails.
   iterator find(const Key &key) {
-    if(empty()) return end();
-    Node *node = root_;
-    while(node != nullptr) {
-      if(lesser_comparer_(key, node->value.first))
-        node = node->left;
-      else if(lesser_comparer_(node->value.first, key))
-        node = node->right;
-      else return iterator(this, node);
-    }
-    return end();
+    Node *parent;
+    bool is_left;
+    return iterator(this, descend(key, parent, is_left));
   }
   const_iterator find(const Key &key) const {
-    if(empty()) return cend();
-    Node *node = root_;
-    while(node != nullptr) {
-      if(lesser_comparer_(key, node->value.first))
-        node = node->left;
-      else if(lesser_comparer_(node->value.first, key))
-        node = node->right;
-      else return const_iterator(this, node);
-    }
-    return cend();
+    Node *parent;
+    bool is_left;
+    return const_iterator(this, descend(key, parent, is_left));
+  }
+  /**
+   * writes find(key) for every key in [first, last) to out, in order, and returns the end of the output.
+   * it's faster than calling find() in a loop on a map that doesn't fit in the cache,
+   * as up to 16 lookups run at the same time and wait for memory together.
+   * the keys must be stored somewhere: KeyIt should dereference to a const Key&.
+   */
+  template<class KeyIt, class OutIt>
+  OutIt find_batch(KeyIt first, KeyIt last, OutIt out) {
+    batch_descend(first, last, [this, &out](Node *node) {
+      *out = iterator(this, node);
+      ++out;
+    });
+    return out;
+  }
+  template<class KeyIt, class OutIt>
+  OutIt find_batch(KeyIt first, KeyIt last, OutIt out) const {
+    batch_descend(first, last, [this, &out](Node *node) {
+      *out = const_iterator(this, node);
+      ++out;
+    });
+    return out;
   }
   size_t count(const Key &key) const {
     return (find(key) == cend()) ? 0 : 1;
@@ -493,37 +1243,11 @@ public:
   Tp& operator[](const Key &key) {
     static_assert(std::is_default_constructible<Tp>::value,
       "The type of value (Tp) should be default constructible if you want to use non-const operator[]");
-    if(empty()) {
-      size_ = 1;
-      root_ = left_most_ = right_most_ = new Node(value_type(key, Tp()));
-      return root_->value.second;
-    }
-    Node *node = root_, *parent = nullptr;
-    bool is_left = true;
-    // at lease one comparison would be done.
-    while(node != nullptr) {
-      if(lesser_comparer_(key, node->value.first)) {
-        parent = node;
-        node = node->left;
-        is_left = true;
-      } else if(lesser_comparer_(node->value.first, key)) {
-        parent = node;
-        node = node->right;
-        is_left = false;
-      } else return node->value.second;
-    }
-    ++size_;
-    Node *res = new Node(value_type(key, Tp()));
-    res->parent = parent;
-    if(is_left) {
-      parent->left = res;
-      if(parent == left_most_) left_most_ = res;
-    } else {
-      parent->right = res;
-      if(parent == right_most_) right_most_ = res;
-    }
-    insertion_maintain(res);
-    return res->value.second;
+    Node *parent;
+    bool is_left;
+    Node *node = descend(key, parent, is_left);
+    if(node != nullptr) return node->value.second;
+    return attach(value_type(key, Tp()), parent, is_left)->value.second;
   }
   // throws index_out_of_bound if key doesn't exist.
   const Tp& operator[](const Key &key) const {
@@ -532,37 +1256,11 @@ public:
     return it->second;
   }
   pair<iterator, bool> insert(const value_type &value) {
-    if(empty()) {
-      size_ = 1;
-      root_ = left_most_ = right_most_ = new Node(value);
-      return pair<iterator, bool>(iterator(this, root_), true);
-    }
-    Node *node = root_, *parent = nullptr;
-    bool is_left = true;
-    // at lease one comparison would be done.
-    while(node != nullptr) {
-      if(lesser_comparer_(value.first, node->value.first)) {
-        parent = node;
-        node = node->left;
-        is_left = true;
-      } else if(lesser_comparer_(node->value.first, value.first)) {
-        parent = node;
-        node = node->right;
-        is_left = false;
-      } else return pair<iterator, bool>(iterator(this, node), false);
-    }
-    ++size_;
-    Node *res = new Node(value);
-    res->parent = parent;
-    if(is_left) {
-      parent->left = res;
-      if(parent == left_most_) left_most_ = res;
-    } else {
-      parent->right = res;
-      if(parent == right_most_) right_most_ = res;
-    }
-    insertion_maintain(res);
-    return pair<iterator, bool>(iterator(this, res), true);
+    Node *parent;
+    bool is_left;
+    Node *node = descend(value.first, parent, is_left);
+    if(node != nullptr) return pair<iterator, bool>(iterator(this, node), false);
+    return pair<iterator, bool>(iterator(this, attach(value, parent, is_left)), true);
   }
   // may throw invalid_iterator if invalidation is detected.
   // (visiting deleted pointer may occur, resulting in core dump(?).)
@@ -571,7 +1269,7 @@ public:
     if(pos.container != this || empty() || pos == end()) throw invalid_iterator();
     if(size_ == 1) {
       if(pos.node != root_) throw invalid_iterator();
-      delete root_;
+      delete_node(root_);
       root_ = nullptr;
       left_most_ = right_most_ = nullptr;
       size_ = 0;
@@ -591,70 +1289,47 @@ public:
       node = prev;
       */
       if(node->left == prev) {
-        // prev->right == nullptr
-        right_rotate(node);
-        // now node->left == nullptr
+        // prev->right == nullptr. swap node with its left child, marks included.
+        Node *node_parent = node->parent(), *node_right = node->right, *prev_left = prev->left;
+        prev->set_parent(node_parent);
+        if(node_parent == nullptr) root_ = prev;
+        else if(node_parent->left == node) node_parent->left = prev;
+        else node_parent->right = prev;
+        prev->right = node_right;
+        node_right->set_parent(prev);
+        prev->left = node;
+        node->set_parent(prev);
+        node->left = prev_left;
+        if(prev_left != nullptr) prev_left->set_parent(node);
+        node->right = nullptr;
+        unsigned mark = node->mark(); node->set_mark(prev->mark()); prev->set_mark(mark);
+        // now node->right == nullptr
       } else {
-        Node *node_parent = node->parent, *node_left = node->left, *node_right = node->right;
-        Node *prev_parent = prev->parent, *prev_left = prev->left, *prev_right = prev->right;
+        Node *node_parent = node->parent(), *node_left = node->left, *node_right = node->right;
+        Node *prev_parent = prev->parent(), *prev_left = prev->left, *prev_right = prev->right;
 
-        node->parent = prev_parent; node->left = prev_left; node->right = prev_right;
-        prev->parent = node_parent; prev->left = node_left; prev->right = node_right;
-        auto color = node->color; node->color = prev->color; prev->color = color;
+        node->set_parent(prev_parent); node->left = prev_left; node->right = prev_right;
+        prev->set_parent(node_parent); prev->left = node_left; prev->right = node_right;
+        unsigned mark = node->mark(); node->set_mark(prev->mark()); prev->set_mark(mark);
 
         if(node_parent != nullptr) {
           if(node_parent->left == node) node_parent->left = prev;
           else node_parent->right = prev;
         }
-        if(node_left != nullptr) node_left->parent = prev;
-        if(node_right != nullptr) node_right->parent = prev;
+        if(node_left != nullptr) node_left->set_parent(prev);
+        if(node_right != nullptr) node_right->set_parent(prev);
         if(prev_parent != nullptr) {
           if(prev_parent->left == prev) prev_parent->left = node;
           else prev_parent->right = node;
         }
-        if(prev_left != nullptr) prev_left->parent = node;
-        if(prev_right != nullptr) prev_right->parent = node;
+        if(prev_left != nullptr) prev_left->set_parent(node);
+        if(prev_right != nullptr) prev_right->set_parent(node);
         if(root_ == node) root_ = prev; // Don't forget this.
       }
       // now (node->left == nullptr || node->right == nullptr) is true.
     }
     // no two-child node here.
-    bool to_maintain = (node->color == Node::Color::Black);
-    if(node->left == nullptr && node->right == nullptr) {
-      // discard it.
-      Node *parent = node->parent; // definitely not nullptr, for size_ == 1 case has been handled.
-      if(to_maintain) {
-        // temporarily use a new nil node whose parent is "parent".
-        Node *helper_node = new Node(parent->value);
-        helper_node->color = Node::Color::Black; // somehow needless
-        helper_node->parent = parent;
-        if(parent->left == node) {
-          parent->left = helper_node;
-          erasure_maintain(helper_node);
-          parent->left = nullptr;
-        } else {
-          parent->right = helper_node;
-          erasure_maintain(helper_node);
-          parent->right = nullptr;
-        }
-        helper_node->parent = nullptr;
-        delete helper_node;
-      } else {
-        if(parent->left == node) parent->left = nullptr;
-        else parent->right = nullptr;
-      }
-      delete node;
-      return;
-    }
-    Node *parent = node->parent; // may be nullptr if node == root_
-    Node *child = (node->left == nullptr) ? node->right : node->left; // only one side is not nullptr.
-    if(parent == nullptr) root_ = child;
-    else if(parent->left == node) parent->left = child;
-    else parent->right = child;
-    child->parent = parent;
-    child->color = node->color; // important?
-    erasure_maintain(child);
-    delete node;
+    unlink(node, Balance());
   }
 };
 }
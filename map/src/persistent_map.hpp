@@ -0,0 +1,420 @@
+/**
+ * implement a persistent (immutable) ordered map.
+ */
+#ifndef SJTU_PERSISTENT_MAP_HPP
+#define SJTU_PERSISTENT_MAP_HPP
+
+#include <atomic>
+#include <functional>
+#include <cstddef>
+#include <type_traits>
+
+#include "utility.hpp"
+#include "exceptions.hpp"
+
+namespace sjtu {
+
+/**
+ * every version of a persistent_map is immutable.
+ * insert() and erase() return a new version, which shares all untouched nodes
+ * with the old one, so copying a version is O(1) and an update costs O(log n) new nodes.
+ * nodes are reference-counted atomically, so versions may be read from different threads.
+ * it is a weight-balanced tree internal (delta = 3, gamma = 2).
+ */
+template<class Key, class Tp, class Compare = std::less<Key>>
+class persistent_map {
+public:
+  typedef pair<const Key, Tp> value_type;
+private:
+  struct Node {
+    const Node *left, *right;
+    value_type value;
+    size_t size;
+    mutable std::atomic<size_t> refs;
+
+    Node(const value_type &value_, const Node *left_, const Node *right_)
+      : left(left_), right(right_), value(value_),
+        size(1 + size_of(left_) + size_of(right_)), refs(1) {}
+    Node(const Node &other) = delete;
+    Node(Node &&other) = delete;
+  };
+  static constexpr size_t kDelta = 3, kGamma = 2;
+
+  const Node *root_;
+  Compare lesser_comparer_;
+
+  persistent_map(const Node *root, const Compare &comparer): root_(root), lesser_comparer_(comparer) {}
+
+  static size_t size_of(const Node *node) {
+    return (node == nullptr) ? 0 : node->size;
+  }
+  static const Node* retain(const Node *node) {
+    if(node != nullptr) node->refs.fetch_add(1, std::memory_order_relaxed);
+    return node;
+  }
+  static void release(const Node *node) {
+    // only the path down to shared subtrees is freed.
+    while(node != nullptr && node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      const Node *left = node->left, *right = node->right;
+      delete node;
+      release(left);
+      node = right;
+    }
+  }
+
+  // an owned reference, which is released when it goes out of scope unless taken.
+  struct OwnedNode {
+    const Node *node;
+
+    explicit OwnedNode(const Node *node_): node(node_) {}
+    OwnedNode(const OwnedNode &other) = delete;
+    ~OwnedNode() {
+      release(node);
+    }
+    const Node* take() {
+      const Node *res = node;
+      node = nullptr;
+      return res;
+    }
+  };
+
+  // the functions below consume the references of their Node* arguments
+  // (except where noted), and return an owned reference.
+  // they consume them even when they throw, so every reference is taken into a local
+  // before the next call that may throw.
+  static const Node* make(const value_type &value, const Node *left, const Node *right) {
+    try {
+      return new Node(value, left, right);
+    } catch(...) {
+      release(left);
+      release(right);
+      throw;
+    }
+  }
+  static const Node* single_left(const value_type &value, const Node *left, const Node *right) {
+    OwnedNode old(right);
+    const Node *lower = make(value, left, retain(right->left));
+    return make(right->value, lower, retain(right->right));
+  }
+  static const Node* double_left(const value_type &value, const Node *left, const Node *right) {
+    OwnedNode old(right);
+    const Node *mid = right->left;
+    OwnedNode lower_left(make(value, left, retain(mid->left)));
+    const Node *lower_right = make(right->value, retain(mid->right), retain(right->right));
+    return make(mid->value, lower_left.take(), lower_right);
+  }
+  static const Node* single_right(const value_type &value, const Node *left, const Node *right) {
+    OwnedNode old(left);
+    const Node *lower = make(value, retain(left->right), right);
+    return make(left->value, retain(left->left), lower);
+  }
+  static const Node* double_right(const value_type &value, const Node *left, const Node *right) {
+    OwnedNode old(left);
+    const Node *mid = left->right;
+    OwnedNode lower_right(make(value, retain(mid->right), right));
+    const Node *lower_left = make(left->value, retain(left->left), retain(mid->left));
+    return make(mid->value, lower_left, lower_right.take());
+  }
+  // rebuilds a node whose subtrees were balanced before one of them changed by one.
+  static const Node* balance(const value_type &value, const Node *left, const Node *right) {
+    size_t left_weight = size_of(left) + 1, right_weight = size_of(right) + 1;
+    if(kDelta * left_weight < right_weight) {
+      if(size_of(right->left) + 1 < kGamma * (size_of(right->right) + 1))
+        return single_left(value, left, right);
+      return double_left(value, left, right);
+    }
+    if(kDelta * right_weight < left_weight) {
+      if(size_of(left->right) + 1 < kGamma * (size_of(left->left) + 1))
+        return single_right(value, left, right);
+      return double_right(value, left, right);
+    }
+    return make(value, left, right);
+  }
+
+  // node is borrowed. the old value of the same key is replaced.
+  const Node* insert_node(const Node *node, const value_type &value) const {
+    if(node == nullptr) return make(value, nullptr, nullptr);
+    if(lesser_comparer_(value.first, node->value.first)) {
+      const Node *left = insert_node(node->left, value);
+      return balance(node->value, left, retain(node->right));
+    }
+    if(lesser_comparer_(node->value.first, value.first)) {
+      const Node *right = insert_node(node->right, value);
+      return balance(node->value, retain(node->left), right);
+    }
+    return make(value, retain(node->left), retain(node->right));
+  }
+  // node is borrowed and not empty. the minimum is left in min_node, which is borrowed too.
+  static const Node* erase_min(const Node *node, const Node *&min_node) {
+    if(node->left == nullptr) {
+      min_node = node;
+      return retain(node->right);
+    }
+    const Node *left = erase_min(node->left, min_node);
+    return balance(node->value, left, retain(node->right));
+  }
+  static const Node* erase_max(const Node *node, const Node *&max_node) {
+    if(node->right == nullptr) {
+      max_node = node;
+      return retain(node->left);
+    }
+    const Node *right = erase_max(node->right, max_node);
+    return balance(node->value, retain(node->left), right);
+  }
+  // joins two borrowed subtrees of a removed node.
+  static const Node* glue(const Node *left, const Node *right) {
+    if(left == nullptr) return retain(right);
+    if(right == nullptr) return retain(left);
+    const Node *extreme;
+    if(size_of(left) > size_of(right)) {
+      const Node *rest = erase_max(left, extreme);
+      return balance(extreme->value, rest, retain(right));
+    }
+    const Node *rest = erase_min(right, extreme);
+    return balance(extreme->value, retain(left), rest);
+  }
+  // node is borrowed. the key should be in the tree.
+  const Node* erase_node(const Node *node, const Key &key) const {
+    if(lesser_comparer_(key, node->value.first)) {
+      const Node *left = erase_node(node->left, key);
+      return balance(node->value, left, retain(node->right));
+    }
+    if(lesser_comparer_(node->value.first, key)) {
+      const Node *right = erase_node(node->right, key);
+      return balance(node->value, retain(node->left), right);
+    }
+    return glue(node->left, node->right);
+  }
+
+  const Node* find_node(const Key &key) const {
+    const Node *node = root_;
+    while(node != nullptr) {
+      if(lesser_comparer_(key, node->value.first)) node = node->left;
+      else if(lesser_comparer_(node->value.first, key)) node = node->right;
+      else return node;
+    }
+    return nullptr;
+  }
+public:
+  // iterators stay valid as long as the version they come from is alive.
+  class const_iterator {
+    friend persistent_map;
+  private:
+    // paths up to this deep are kept inside the iterator, deeper ones move to the heap.
+    // a copy only takes the live part of the path.
+    static constexpr size_t kInlineDepth = 16;
+
+    const persistent_map *container;
+    // the path from the root down to the current node, which is empty for cend().
+    // it points to inline_path until it outgrows it.
+    const Node **path;
+    size_t depth, capacity;
+    const Node *inline_path[kInlineDepth];
+
+    explicit const_iterator(const persistent_map *the_map)
+      : container(the_map), path(inline_path), depth(0), capacity(kInlineDepth) {}
+    void push(const Node *node) {
+      if(depth == capacity) reserve(capacity * 2);
+      path[depth++] = node;
+    }
+    void reserve(size_t new_capacity) {
+      if(new_capacity <= capacity) return;
+      const Node **new_path = new const Node*[new_capacity];
+      for(size_t i = 0; i < depth; ++i) new_path[i] = path[i];
+      if(path != inline_path) delete[] path;
+      path = new_path;
+      capacity = new_capacity;
+    }
+    void push_leftmost(const Node *node) {
+      for(; node != nullptr; node = node->left) push(node);
+    }
+    void push_rightmost(const Node *node) {
+      for(; node != nullptr; node = node->right) push(node);
+    }
+    const Node* current() const {
+      return (depth == 0) ? nullptr : path[depth - 1];
+    }
+
+  public:
+    const_iterator(): container(nullptr), path(inline_path), depth(0), capacity(kInlineDepth) {}
+    const_iterator(const const_iterator &other)
+      : container(other.container), path(inline_path), depth(0), capacity(kInlineDepth) {
+      reserve(other.depth);
+      for(; depth < other.depth; ++depth) path[depth] = other.path[depth];
+    }
+    // a path on the heap is taken over; an inline one is copied.
+    const_iterator(const_iterator &&other) noexcept
+      : container(other.container), path(inline_path), depth(other.depth), capacity(kInlineDepth) {
+      if(other.path != other.inline_path) {
+        path = other.path;
+        capacity = other.capacity;
+        other.path = other.inline_path;
+        other.capacity = kInlineDepth;
+      } else {
+        for(size_t i = 0; i < depth; ++i) path[i] = other.path[i];
+      }
+      other.depth = 0;
+    }
+    ~const_iterator() {
+      if(path != inline_path) delete[] path;
+    }
+    const_iterator& operator=(const const_iterator &other) {
+      if(this == &other) return *this;
+      depth = 0;
+      reserve(other.depth);
+      container = other.container;
+      for(; depth < other.depth; ++depth) path[depth] = other.path[depth];
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator res = *this;
+      ++(*this);
+      return res;
+    }
+    // amortized O(1).
+    const_iterator& operator++() {
+      if(depth == 0) // cend()
+        throw invalid_iterator();
+      const Node *node = path[depth - 1];
+      if(node->right != nullptr) {
+        push_leftmost(node->right);
+        return *this;
+      }
+      // climb up to the first ancestor whose left subtree we leave.
+      --depth;
+      while(depth != 0 && path[depth - 1]->right == node) node = path[--depth];
+      return *this;
+    }
+    const_iterator operator--(int) {
+      const_iterator res = *this;
+      --(*this);
+      return res;
+    }
+    // amortized O(1).
+    const_iterator& operator--() {
+      if(depth == 0) { // cend()
+        if(container == nullptr || container->empty()) throw invalid_iterator();
+        push_rightmost(container->root_);
+        return *this;
+      }
+      const Node *node = path[depth - 1];
+      if(node->left != nullptr) {
+        push_rightmost(node->left);
+        return *this;
+      }
+      size_t up = depth - 1;
+      while(up != 0 && path[up - 1]->left == node) node = path[--up];
+      if(up == 0) // cbegin()
+        throw invalid_iterator();
+      depth = up;
+      return *this;
+    }
+    bool operator==(const const_iterator &other) const {
+      return container == other.container && current() == other.current();
+    }
+    bool operator!=(const const_iterator &other) const {
+      return !(*this == other);
+    }
+    const value_type& operator*() const {
+      return current()->value;
+    }
+    const value_type* operator->() const {
+      return &*(*this);
+    }
+  };
+  typedef const_iterator iterator;
+
+  persistent_map(): root_(nullptr) {}
+  explicit persistent_map(const Compare &comp): root_(nullptr), lesser_comparer_(comp) {}
+  persistent_map(const persistent_map &other)
+    : root_(retain(other.root_)), lesser_comparer_(other.lesser_comparer_) {}
+  // the comparator is copied, so that other stays usable.
+  persistent_map(persistent_map &&other) noexcept(std::is_nothrow_copy_constructible<Compare>::value)
+    : root_(other.root_), lesser_comparer_(other.lesser_comparer_) {
+    other.root_ = nullptr;
+  }
+  ~persistent_map() {
+    release(root_);
+  }
+  persistent_map& operator=(const persistent_map &other) {
+    if(this == &other) return *this;
+    retain(other.root_);
+    release(root_);
+    root_ = other.root_;
+    lesser_comparer_ = other.lesser_comparer_;
+    return *this;
+  }
+  // the comparator is assigned first, so this is unchanged if it throws.
+  persistent_map& operator=(persistent_map &&other) noexcept(std::is_nothrow_copy_assignable<Compare>::value) {
+    if(this == &other) return *this;
+    lesser_comparer_ = other.lesser_comparer_;
+    release(root_);
+    root_ = other.root_;
+    other.root_ = nullptr;
+    return *this;
+  }
+  // when empty(), cbegin() == cend().
+  const_iterator begin() const {
+    const_iterator res(this);
+    res.push_leftmost(root_);
+    return res;
+  }
+  const_iterator end() const {
+    return const_iterator(this);
+  }
+  const_iterator cbegin() const {
+    return begin();
+  }
+  const_iterator cend() const {
+    return end();
+  }
+  size_t size() const {
+    return size_of(root_);
+  }
+  bool empty() const {
+    return root_ == nullptr;
+  }
+  // returns cend() if search fails.
+  const_iterator find(const Key &key) const {
+    const_iterator res(this);
+    const Node *node = root_;
+    while(node != nullptr) {
+      res.push(node);
+      if(lesser_comparer_(key, node->value.first)) node = node->left;
+      else if(lesser_comparer_(node->value.first, key)) node = node->right;
+      else return res;
+    }
+    return cend();
+  }
+  size_t count(const Key &key) const {
+    return (find_node(key) == nullptr) ? 0 : 1;
+  }
+  // throws index_out_of_bound if key doesn't exist.
+  const Tp& at(const Key &key) const {
+    const Node *node = find_node(key);
+    if(node == nullptr) throw index_out_of_bound();
+    return node->value.second;
+  }
+  // throws index_out_of_bound if key doesn't exist.
+  const Tp& operator[](const Key &key) const {
+    return at(key);
+  }
+  // the version with value inserted. if the key exists, this version is returned.
+  persistent_map insert(const value_type &value) const {
+    if(find_node(value.first) != nullptr) return *this;
+    return persistent_map(insert_node(root_, value), lesser_comparer_);
+  }
+  // the version with value inserted, or with the old value of the key replaced.
+  persistent_map insert_or_assign(const value_type &value) const {
+    return persistent_map(insert_node(root_, value), lesser_comparer_);
+  }
+  // the version without key. if the key doesn't exist, this version is returned.
+  persistent_map erase(const Key &key) const {
+    if(find_node(key) == nullptr) return *this;
+    return persistent_map(erase_node(root_, key), lesser_comparer_);
+  }
+};
+
+}
+
+#endif
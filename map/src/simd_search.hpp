@@ -0,0 +1,202 @@
+#ifndef SJTU_SIMD_SEARCH_HPP
+#define SJTU_SIMD_SEARCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SJTU_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define SJTU_SIMD_X86 0
+#endif
+
+namespace sjtu {
+
+/**
+ * lower_bound over a sorted array of arithmetic keys under std::less.
+ * a branchless binary search narrows the range down to a small window,
+ * whose keys are then compared against the key 4 to 8 at a time with SSE2 or AVX2,
+ * chosen once at runtime. other platforms use the scalar kernel.
+ */
+namespace simd {
+
+enum class isa { scalar, sse2, avx2 };
+
+// the widest instruction set the cpu supports.
+inline isa best_isa() {
+#if SJTU_SIMD_X86
+  static const isa best = __builtin_cpu_supports("avx2") ? isa::avx2
+    : (__builtin_cpu_supports("sse2") ? isa::sse2 : isa::scalar);
+  return best;
+#else
+  return isa::scalar;
+#endif
+}
+
+// the keys of the same width and kind as T which the kernels are written for, or void.
+template<class T>
+struct kernel_key {
+  typedef typename std::conditional<std::is_floating_point<T>::value,
+    typename std::conditional<sizeof(T) == 4, float,
+      typename std::conditional<sizeof(T) == 8, double, void>::type>::type,
+    typename std::conditional<sizeof(T) == 4,
+      typename std::conditional<std::is_signed<T>::value, std::int32_t, std::uint32_t>::type,
+      typename std::conditional<sizeof(T) == 8,
+        typename std::conditional<std::is_signed<T>::value, std::int64_t, std::uint64_t>::type,
+        void>::type>::type>::type type;
+};
+
+// whether a container searching Key under Compare should use lower_bound below.
+template<class Key, class Compare>
+struct enabled : std::integral_constant<bool, std::is_arithmetic<Key>::value
+  && !std::is_same<Key, bool>::value
+  && !std::is_void<typename kernel_key<Key>::type>::value
+  && std::is_same<Compare, std::less<Key>>::value> {};
+
+template<class T>
+inline size_t count_less_scalar(const T *first, size_t n, T key) {
+  size_t count = 0;
+  for(size_t i = 0; i < n; ++i) count += first[i] < key;
+  return count;
+}
+
+#if SJTU_SIMD_X86
+
+// the integer kernels read the keys as T, the exact key type, through unaligned vector loads.
+// unsigned keys are compared as signed ones after flipping their sign bits.
+template<class T>
+__attribute__((target("sse2")))
+inline size_t count_less_sse2_32(const T *first, size_t n, T key) {
+  const std::int32_t flip = std::is_signed<T>::value ? 0 : INT32_MIN;
+  __m128i f = _mm_set1_epi32(flip), k = _mm_xor_si128(_mm_set1_epi32(static_cast<std::int32_t>(key)), f);
+  size_t count = 0, i = 0;
+  for(; i + 4 <= n; i += 4) {
+    __m128i v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(first + i)), f);
+    count += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(k, v))));
+  }
+  return count + count_less_scalar(first + i, n - i, key);
+}
+__attribute__((target("sse2")))
+inline size_t count_less_sse2(const float *first, size_t n, float key) {
+  __m128 k = _mm_set1_ps(key);
+  size_t count = 0, i = 0;
+  for(; i + 4 <= n; i += 4)
+    count += __builtin_popcount(_mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(first + i), k)));
+  return count + count_less_scalar(first + i, n - i, key);
+}
+__attribute__((target("sse2")))
+inline size_t count_less_sse2(const double *first, size_t n, double key) {
+  __m128d k = _mm_set1_pd(key);
+  size_t count = 0, i = 0;
+  for(; i + 2 <= n; i += 2)
+    count += __builtin_popcount(_mm_movemask_pd(_mm_cmplt_pd(_mm_loadu_pd(first + i), k)));
+  return count + count_less_scalar(first + i, n - i, key);
+}
+
+template<class T>
+__attribute__((target("avx2")))
+inline size_t count_less_avx2_32(const T *first, size_t n, T key) {
+  const std::int32_t flip = std::is_signed<T>::value ? 0 : INT32_MIN;
+  __m256i f = _mm256_set1_epi32(flip), k = _mm256_xor_si256(_mm256_set1_epi32(static_cast<std::int32_t>(key)), f);
+  size_t count = 0, i = 0;
+  for(; i + 8 <= n; i += 8) {
+    __m256i v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(first + i)), f);
+    count += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(k, v))));
+  }
+  return count + count_less_scalar(first + i, n - i, key);
+}
+template<class T>
+__attribute__((target("avx2")))
+inline size_t count_less_avx2_64(const T *first, size_t n, T key) {
+  const std::int64_t flip = std::is_signed<T>::value ? 0 : INT64_MIN;
+  __m256i f = _mm256_set1_epi64x(flip), k = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<std::int64_t>(key)), f);
+  size_t count = 0, i = 0;
+  for(; i + 4 <= n; i += 4) {
+    __m256i v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(first + i)), f);
+    count += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(k, v))));
+  }
+  return count + count_less_scalar(first + i, n - i, key);
+}
+__attribute__((target("avx2")))
+inline size_t count_less_avx2(const float *first, size_t n, float key) {
+  __m256 k = _mm256_set1_ps(key);
+  size_t count = 0, i = 0;
+  for(; i + 8 <= n; i += 8)
+    count += __builtin_popcount(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(first + i), k, _CMP_LT_OQ)));
+  return count + count_less_scalar(first + i, n - i, key);
+}
+__attribute__((target("avx2")))
+inline size_t count_less_avx2(const double *first, size_t n, double key) {
+  __m256d k = _mm256_set1_pd(key);
+  size_t count = 0, i = 0;
+  for(; i + 4 <= n; i += 4)
+    count += __builtin_popcount(_mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(first + i), k, _CMP_LT_OQ)));
+  return count + count_less_scalar(first + i, n - i, key);
+}
+
+// the kernels for each size of integer key. sse2 has no 64-bit integer comparison, so it falls back to scalar.
+template<class T>
+inline size_t count_less_int(const T *first, size_t n, T key, isa set, std::integral_constant<size_t, 4>) {
+  if(set == isa::avx2) return count_less_avx2_32(first, n, key);
+  if(set == isa::sse2) return count_less_sse2_32(first, n, key);
+  return count_less_scalar(first, n, key);
+}
+template<class T>
+inline size_t count_less_int(const T *first, size_t n, T key, isa set, std::integral_constant<size_t, 8>) {
+  if(set == isa::avx2) return count_less_avx2_64(first, n, key);
+  return count_less_scalar(first, n, key);
+}
+// dispatches on the exact key type, which is never read through another one.
+template<class T>
+inline size_t count_less(const T *first, size_t n, T key, isa set) {
+  static_assert(std::is_integral<T>::value, "the floating-point keys have overloads of their own");
+  return count_less_int(first, n, key, set, std::integral_constant<size_t, sizeof(T)>());
+}
+inline size_t count_less(const float *first, size_t n, float key, isa set) {
+  if(set == isa::avx2) return count_less_avx2(first, n, key);
+  if(set == isa::sse2) return count_less_sse2(first, n, key);
+  return count_less_scalar(first, n, key);
+}
+inline size_t count_less(const double *first, size_t n, double key, isa set) {
+  if(set == isa::avx2) return count_less_avx2(first, n, key);
+  if(set == isa::sse2) return count_less_sse2(first, n, key);
+  return count_less_scalar(first, n, key);
+}
+
+#else
+
+template<class T>
+inline size_t count_less(const T *first, size_t n, T key, isa) {
+  return count_less_scalar(first, n, key);
+}
+
+#endif
+
+// the binary search stops at a window of about one cache line, which is scanned linearly.
+static constexpr size_t kWindowBytes = 64;
+
+/**
+ * the index of the first key in [first, first + n) not less than key.
+ * set should not be wider than best_isa().
+ */
+template<class T>
+inline size_t lower_bound(const T *first, size_t n, T key, isa set = best_isa()) {
+  static_assert(enabled<T, std::less<T>>::value, "simd::lower_bound only takes 32-bit and 64-bit arithmetic keys");
+  const T *base = first;
+  // the answer is always in [first, first + n].
+  while(n > kWindowBytes / sizeof(T)) {
+    size_t half = n / 2;
+    first = (first[half] < key) ? first + half : first;
+    n -= half;
+  }
+  return (first - base) + count_less(first, n, key, set);
+}
+
+}
+
+}
+
+#endif
@@ -0,0 +1,98 @@
+#include "priority_queue.hpp"
+
+#include <iostream>
+#include <string>
+#include <utility>
+
+// a max-heap or a min-heap, so a queue that lost its comparator shows up.
+struct Order {
+	bool min_heap;
+	Order(bool min_heap = false) : min_heap(min_heap) {}
+	bool operator()(int lhs, int rhs) const { return min_heap ? rhs < lhs : lhs < rhs; }
+};
+
+typedef sjtu::priority_queue<int, Order> Queue;
+
+// copies its argument, so the queue passed in is untouched.
+void Drain(Queue q)
+{
+	while (!q.empty()) {
+		std::cout << q.top() << " ";
+		q.pop();
+	}
+	std::cout << "| " << q.size() << std::endl;
+}
+
+Queue Build(int n, bool min_heap)
+{
+	Queue q{Order(min_heap)};
+	for (int i = 0; i < n; ++i) {
+		q.push((i * 7) % n);
+	}
+	return q;
+}
+
+void TestEmptyCopies()
+{
+	std::cout << "Testing copies of empty queues..." << std::endl;
+	Queue a;
+	Queue b(a);
+	Queue c;
+	c.push(1);
+	c = a;
+	std::cout << b.size() << " " << c.size() << std::endl;
+	try {
+		c.top();
+	} catch (sjtu::container_is_empty) {
+		std::cout << "container_is_empty" << std::endl;
+	}
+	c.push(2);
+	Drain(c);
+}
+
+void TestMoves()
+{
+	std::cout << "Testing moves..." << std::endl;
+	Queue a = Build(6, true);
+	Queue b(std::move(a));
+	std::cout << a.size() << " " << b.size() << std::endl;
+	a.push(3);
+	Drain(a);
+	Drain(b);
+	Queue c;
+	c.push(100);
+	c = std::move(b);
+	std::cout << b.size() << " " << c.size() << std::endl;
+	Drain(c);
+	c = std::move(c);
+	std::cout << c.size() << std::endl;
+}
+
+void TestComparator()
+{
+	std::cout << "Testing comparators..." << std::endl;
+	Queue a{Order(true)};
+	Queue b(a), c;
+	c = a;
+	for (int i = 0; i < 4; ++i) {
+		b.push(i);
+		c.push(i);
+	}
+	Drain(b);
+	Drain(c);
+	Queue d = Build(5, false);
+	d = Build(5, true);
+	d.push(-1);
+	Drain(d);
+	Queue e = Build(3, false), f = Build(3, true);
+	e.merge(f);
+	std::cout << e.size() << " " << f.size() << std::endl;
+}
+
+int main()
+{
+	TestEmptyCopies();
+	TestMoves();
+	TestComparator();
+	return 0;
+}
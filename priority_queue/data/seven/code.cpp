@@ -0,0 +1,55 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <cstdlib>
+
+#include "priority_queue.hpp"
+
+void TestTopK()
+{
+	std::cout << "Testing top_k..." << std::endl;
+	sjtu::priority_queue<int> pq;
+	std::vector<int> ref;
+	srand(20240324);
+	for (int i = 0; i < 5000; ++i) {
+		int x = rand() % 10000;
+		pq.push(x);
+		ref.push_back(x);
+	}
+	pq.pop();
+	std::sort(ref.begin(), ref.end(), std::greater<int>());
+	ref.erase(ref.begin());
+	std::vector<int> res;
+	pq.top_k(10, std::back_inserter(res));
+	for (int x : res) std::cout << x << " ";
+	std::cout << std::endl;
+	res.clear();
+	pq.top_k(pq.size(), std::back_inserter(res));
+	std::cout << (res == ref ? "OK" : "WRONG") << " " << pq.size() << std::endl;
+}
+
+void TestException()
+{
+	std::cout << "Testing exceptions..." << std::endl;
+	sjtu::priority_queue<int> pq;
+	std::vector<int> res;
+	pq.top_k(0, std::back_inserter(res));
+	pq.push(1);
+	pq.push(2);
+	try {
+		pq.top_k(3, std::back_inserter(res));
+	} catch (sjtu::container_is_empty &) {
+		std::cout << "Throw correctly." << std::endl;
+	}
+	pq.top_k(2, std::back_inserter(res));
+	std::cout << res.size() << " " << res[0] << " " << res[1] << " " << pq.empty() << std::endl;
+}
+
+int main(int argc, char *const argv[])
+{
+	TestTopK();
+	TestException();
+	return 0;
+}
@@ -0,0 +1,142 @@
+#include <iostream>
+#include <queue>
+#include <vector>
+#include <functional>
+#include <cstdlib>
+#include <new>
+
+#include "radix_heap.hpp"
+
+// array allocations fail once the budget runs out. radix_heap allocates its buckets with new[].
+int array_budget = -1;
+void *operator new[](size_t size)
+{
+	if (array_budget == 0) throw std::bad_alloc();
+	if (array_budget > 0) --array_budget;
+	void *p = std::malloc(size == 0 ? 1 : size);
+	if (p == nullptr) throw std::bad_alloc();
+	return p;
+}
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete[](void *p, size_t) noexcept { std::free(p); }
+
+void TestMonotoneTrace()
+{
+	std::cout << "Testing monotone trace..." << std::endl;
+	sjtu::radix_heap<unsigned int> rh;
+	std::priority_queue<unsigned int, std::vector<unsigned int>, std::greater<unsigned int>> ref;
+	srand(19260817);
+	for (int i = 0; i < 1000; ++i) {
+		unsigned int key = rand() % 1000;
+		rh.push(key);
+		ref.push(key);
+	}
+	bool ok = true;
+	unsigned long long sum = 0;
+	for (int i = 0; i < 200000; ++i) {
+		if (rh.top() != ref.top()) ok = false;
+		unsigned int now = rh.top();
+		sum += now;
+		rh.pop();
+		ref.pop();
+		int pushes = rand() % 3;
+		for (int j = 0; j < pushes; ++j) {
+			unsigned int key = now + rand() % 5000;
+			rh.push(key);
+			ref.push(key);
+		}
+		if (rh.size() != ref.size()) ok = false;
+		if (rh.empty()) break;
+	}
+	std::cout << (ok ? "OK" : "WRONG") << " " << sum << std::endl;
+}
+
+void TestSignedKeys()
+{
+	std::cout << "Testing signed keys..." << std::endl;
+	sjtu::radix_heap<long long> rh;
+	for (long long i = 10; i >= -10; --i) {
+		rh.push(i * 1000000000000LL);
+	}
+	sjtu::radix_heap<long long> copy(rh);
+	while (!rh.empty()) {
+		std::cout << rh.top() / 1000000000000LL << " ";
+		rh.pop();
+	}
+	std::cout << std::endl;
+	std::cout << copy.size() << " " << copy.top() / 1000000000000LL << std::endl;
+}
+
+void TestException()
+{
+	std::cout << "Testing exceptions..." << std::endl;
+	sjtu::radix_heap<int> rh;
+	try {
+		rh.top();
+	} catch (sjtu::container_is_empty &) {
+		std::cout << "Throw correctly." << std::endl;
+	}
+	try {
+		rh.pop();
+	} catch (sjtu::container_is_empty &) {
+		std::cout << "Throw correctly." << std::endl;
+	}
+	rh.push(5);
+	rh.push(7);
+	rh.pop();
+	try {
+		rh.push(3);
+	} catch (sjtu::runtime_error &) {
+		std::cout << "Throw correctly." << std::endl;
+	}
+	rh.push(5);
+	std::cout << rh.top() << " " << rh.size() << std::endl;
+	rh.clear();
+	rh.push(3);
+	std::cout << rh.top() << " " << rh.size() << std::endl;
+}
+
+void TestFailedCopy()
+{
+	std::cout << "Testing copies that run out of memory..." << std::endl;
+	sjtu::radix_heap<int> rh, target;
+	for (int i = 0; i < 1000; ++i) {
+		rh.push(i * 37 % 1000);
+	}
+	// spreads the keys over many buckets.
+	rh.top();
+	target.push(1);
+	target.push(2000);
+	array_budget = 2;
+	try {
+		sjtu::radix_heap<int> copy(rh);
+	} catch (std::bad_alloc &) {
+		std::cout << "copy failed" << std::endl;
+	}
+	array_budget = 2;
+	try {
+		target = rh;
+	} catch (std::bad_alloc &) {
+		std::cout << "copy failed" << std::endl;
+	}
+	array_budget = -1;
+	std::cout << target.size() << " " << target.top() << " ";
+	target.pop();
+	std::cout << target.top() << std::endl;
+	target = rh;
+	long long sum = 0;
+	while (!target.empty()) {
+		sum += target.top();
+		target.pop();
+	}
+	std::cout << sum << " " << rh.size() << std::endl;
+}
+
+int main(int argc, char *const argv[])
+{
+	TestMonotoneTrace();
+	TestSignedKeys();
+	TestException();
+	TestFailedCopy();
+	return 0;
+}
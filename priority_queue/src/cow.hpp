@@ -0,0 +1,2 @@
+// the copy-on-write handle is shared by all the containers; see common/cow.hpp.
+#include "../../common/cow.hpp"
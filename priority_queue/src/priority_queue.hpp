@@ -3,15 +3,25 @@
 
 #include <cstddef>
 #include <functional>
+#include <type_traits>
+#include <utility>
 #include "exceptions.hpp"
+#include "stats.hpp"
 
 namespace sjtu {
 
 /**
  * a container like std::priority_queue which is a heap internal.
  */
-template<typename T, class Compare = std::less<T>>
-class priority_queue {
+template<typename T, class Compare = std::less<T>, class Stats = no_stats>
+class priority_queue : private Stats {
+  // the Stats policy is a dependent base, so its calls are brought in by name.
+  using Stats::count_allocation;
+  using Stats::count_deallocation;
+  using Stats::count_comparison;
+  using Stats::count_link;
+  using Stats::snapshot_stats;
+  using Stats::clear_stats;
 private:
   struct Node {
     T *val_ptr;
@@ -29,13 +39,29 @@ private:
   size_t size_;
   Compare comparer_;
 
+  // a node owns two allocations, the node and its value.
+  Node* new_node(const T &e) {
+    count_allocation(sizeof(Node));
+    count_allocation(sizeof(T));
+    return new Node(e);
+  }
+  void delete_node(Node *node) {
+    count_deallocation();
+    count_deallocation();
+    delete node;
+  }
+  bool less(const T &lhs, const T &rhs) const {
+    count_comparison();
+    return comparer_(lhs, rhs);
+  }
+
   void copy_heap(Node *des, Node *src) {
     if(src->child == nullptr) return;
-    des->child = new Node(*src->child->val_ptr);
+    des->child = new_node(*src->child->val_ptr);
     copy_heap(des->child, src->child);
     Node *cur_src = src->child, *cur_des = des->child;
     while(cur_src->sibling != nullptr) {
-      cur_des->sibling = new Node(*cur_src->sibling->val_ptr);
+      cur_des->sibling = new_node(*cur_src->sibling->val_ptr);
       copy_heap(cur_des->sibling, cur_src->sibling);
       cur_src = cur_src->sibling;
       cur_des = cur_des->sibling;
@@ -44,61 +70,157 @@ private:
   void free_heap(Node *ptr) {
     if(ptr == nullptr) return;
     Node *cur = ptr->child, *del;
-    delete ptr;
+    delete_node(ptr);
     while(cur != nullptr) {
       del = cur; cur = cur->sibling;
       free_heap(del);
     }
   }
+  // links two roots, and returns the new root. their siblings are ignored.
+  Node* link(Node *lhs, Node *rhs) {
+    count_link();
+    if(less(*lhs->val_ptr, *rhs->val_ptr)) {
+      lhs->sibling = rhs->child;
+      rhs->child = lhs;
+      return rhs;
+    }
+    rhs->sibling = lhs->child;
+    lhs->child = rhs;
+    return lhs;
+  }
+  // two-pass pairing of the sibling list starting from cur:
+  // link siblings in pairs from left to right, then fold the pairs from right to left.
   Node* multiple_merge(Node *cur) {
     if(cur == nullptr || cur->sibling == nullptr) return cur;
-    Node *nxt = cur->sibling, *rest = multiple_merge(nxt->sibling);
-    cur->sibling = nullptr;
-    nxt->sibling = nullptr;
-    if(comparer_(*cur->val_ptr, *nxt->val_ptr)) {
-      cur->sibling = nxt->child;
-      nxt->child = cur;
-      cur = nxt;
-    } else {
-      nxt->sibling = cur->child;
-      cur->child = nxt;
-    }
-    if(rest == nullptr) return cur;
-    if(comparer_(*cur->val_ptr, *rest->val_ptr)) {
-      cur->sibling = rest->child;
-      rest->child = cur;
-      return rest;
-    } else {
-      rest->sibling = cur->child;
-      cur->child = rest;
-      return cur;
+    Node *pairs = nullptr; // linked pairs in reversed order, chained by sibling.
+    while(cur != nullptr) {
+      Node *nxt = cur->sibling;
+      if(nxt == nullptr) {
+        cur->sibling = pairs;
+        pairs = cur;
+        break;
+      }
+      Node *rest = nxt->sibling;
+      cur->sibling = nxt->sibling = nullptr;
+      cur = link(cur, nxt);
+      cur->sibling = pairs;
+      pairs = cur;
+      cur = rest;
+    }
+    Node *res = pairs;
+    pairs = pairs->sibling;
+    res->sibling = nullptr;
+    while(pairs != nullptr) {
+      Node *nxt = pairs->sibling;
+      pairs->sibling = nullptr;
+      res = link(pairs, res);
+      pairs = nxt;
+    }
+    return res;
+  }
+
+  // a growable array of nodes, used as the frontier when walking the heap order.
+  struct NodeBuffer {
+    Node **data;
+    size_t size, capacity;
+
+    NodeBuffer(): data(nullptr), size(0), capacity(0) {}
+    NodeBuffer(const NodeBuffer &other) = delete;
+    ~NodeBuffer() {
+      delete[] data;
+    }
+    void reserve(size_t new_capacity) {
+      if(new_capacity <= capacity) return;
+      Node **new_data = new Node*[new_capacity];
+      for(size_t i = 0; i < size; ++i) new_data[i] = data[i];
+      delete[] data;
+      data = new_data;
+      capacity = new_capacity;
+    }
+    void push_back(Node *node) {
+      if(size == capacity) reserve((capacity + 1) * 2);
+      data[size++] = node;
+    }
+  };
+  // frontier is a binary heap of nodes, whose top is the greatest one.
+  void frontier_push(NodeBuffer &frontier, Node *node) const {
+    frontier.push_back(node);
+    size_t pos = frontier.size - 1;
+    while(pos > 0) {
+      size_t parent = (pos - 1) / 2;
+      if(!less(*frontier.data[parent]->val_ptr, *node->val_ptr)) break;
+      frontier.data[pos] = frontier.data[parent];
+      pos = parent;
+    }
+    frontier.data[pos] = node;
+  }
+  Node* frontier_pop(NodeBuffer &frontier) const {
+    Node *res = frontier.data[0], *last = frontier.data[--frontier.size];
+    size_t pos = 0;
+    while(true) {
+      size_t child = pos * 2 + 1;
+      if(child >= frontier.size) break;
+      if(child + 1 < frontier.size
+        && less(*frontier.data[child]->val_ptr, *frontier.data[child + 1]->val_ptr))
+        ++child;
+      if(!less(*last->val_ptr, *frontier.data[child]->val_ptr)) break;
+      frontier.data[pos] = frontier.data[child];
+      pos = child;
+    }
+    if(frontier.size != 0) frontier.data[pos] = last;
+    return res;
+  }
+  // collects the k greatest nodes into chosen, in order, without modifying the heap.
+  // k must be positive. the children of the k-th node are never visited,
+  // since a root may have O(n) children.
+  void select_top(size_t k, NodeBuffer &chosen, NodeBuffer &frontier) const {
+    chosen.reserve(k);
+    frontier.reserve(k * 2);
+    frontier_push(frontier, root_);
+    while(true) {
+      Node *node = frontier_pop(frontier);
+      chosen.push_back(node);
+      if(chosen.size == k) break;
+      for(Node *child = node->child; child != nullptr; child = child->sibling)
+        frontier_push(frontier, child);
     }
   }
 
 public:
-  priority_queue(): size_(0), root_(nullptr) {}
-  priority_queue(const priority_queue &other): size_(other.size_) {
-    root_ = new Node(*other.root_->val_ptr);
-    copy_heap(root_, other.root_);
+  priority_queue(): root_(nullptr), size_(0) {}
+  explicit priority_queue(const Compare &comp): root_(nullptr), size_(0), comparer_(comp) {}
+  priority_queue(const priority_queue &other): Stats(), root_(nullptr), size_(0), comparer_(other.comparer_) {
+    if(other.empty()) return;
+    root_ = new_node(*other.root_->val_ptr);
+    try {
+      copy_heap(root_, other.root_);
+    } catch(...) {
+      // every node copied so far is already linked under root_.
+      free_heap(root_);
+      throw;
+    }
+    size_ = other.size_;
   }
-  priority_queue(priority_queue &&other): root_(other.root_), size_(other.size_) {
+  // O(1); other is left empty but usable.
+  priority_queue(priority_queue &&other) noexcept(std::is_nothrow_copy_constructible<Compare>::value)
+    : root_(other.root_), size_(other.size_), comparer_(other.comparer_) {
     other.root_ = nullptr;
     other.size_ = 0;
   }
   ~priority_queue() {
     clear();
   }
+  // the copy is made first, so this is unchanged if it throws.
   priority_queue &operator=(const priority_queue &other) {
     if(this == &other) return *this;
-    clear();
-    size_ = other.size_;
-    root_ = new Node(*other.root_->val_ptr);
-    copy_heap(root_, other.root_);
-    return *this;
+    priority_queue copy(other);
+    return *this = std::move(copy);
   }
-  priority_queue &operator=(priority_queue &&other) {
+  // O(1) besides freeing the old elements; other is left empty but usable.
+  priority_queue &operator=(priority_queue &&other) noexcept(std::is_nothrow_copy_assignable<Compare>::value) {
     if(this == &other) return *this;
     clear();
+    comparer_ = other.comparer_;
     size_ = other.size_;
     root_ = other.root_;
     other.root_ = nullptr;
@@ -112,18 +234,19 @@ public:
   void push(const T &e) {
     if(empty()) {
       size_ = 1;
-      Node *node_ptr = new Node(e);
+      Node *node_ptr = new_node(e);
       root_ = node_ptr;
       return;
     }
     ++size_;
-    if(comparer_(*root_->val_ptr, e)) {
-      Node *node_ptr = new Node(e);
+    count_link();
+    if(less(*root_->val_ptr, e)) {
+      Node *node_ptr = new_node(e);
       node_ptr->child = root_;
       root_ = node_ptr;
       return;
     }
-    Node *node_ptr = new Node(e);
+    Node *node_ptr = new_node(e);
     node_ptr->sibling = root_->child;
     root_->child = node_ptr;
   }
@@ -134,7 +257,7 @@ public:
       return;
     }
     Node *cur = root_->child;
-    delete root_;
+    delete_node(root_);
     root_ = multiple_merge(cur);
     --size_;
   }
@@ -149,6 +272,29 @@ public:
   bool empty() const {
     return size_ == 0;
   }
+  // all zero with no_stats.
+  container_stats stats() const {
+    return snapshot_stats();
+  }
+  void reset_stats() {
+    clear_stats();
+  }
+  /**
+   * write the k greatest elements to out in order, without modifying the heap.
+   * throw container_is_empty if k > size.
+   */
+  template<class OutputIt>
+  OutputIt top_k(size_t k, OutputIt out) const {
+    if(k > size_) throw container_is_empty();
+    if(k == 0) return out;
+    NodeBuffer chosen, frontier;
+    select_top(k, chosen, frontier);
+    for(size_t i = 0; i < k; ++i) {
+      *out = *chosen.data[i]->val_ptr;
+      ++out;
+    }
+    return out;
+  }
   /**
    * merge two priority_queues with at most O(logn) complexity.
    * clear the other priority_queue.
@@ -164,7 +310,8 @@ public:
       *this = std::move(other);
       return;
     }
-    if(comparer_(*root_->val_ptr, *other.root_->val_ptr)) {
+    count_link();
+    if(less(*root_->val_ptr, *other.root_->val_ptr)) {
       root_->sibling = other.root_->child;
       other.root_->child = root_;
       root_ = nullptr;
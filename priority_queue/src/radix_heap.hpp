@@ -0,0 +1,211 @@
+#ifndef SJTU_RADIX_HEAP_HPP
+#define SJTU_RADIX_HEAP_HPP
+
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include "exceptions.hpp"
+
+namespace sjtu {
+
+/**
+ * a monotone priority queue for integer keys, which is a radix heap internal.
+ * unlike priority_queue, top() is the *smallest* key, and keys pushed
+ * should never be smaller than the last key seen by top() or pop().
+ * push is O(1), pop is amortized O(log C) where C is the span of the keys.
+ */
+template<typename T>
+class radix_heap {
+  static_assert(std::is_integral<T>::value, "radix_heap only holds integer keys");
+private:
+  typedef typename std::make_unsigned<T>::type Bits;
+  static constexpr size_t kBits = sizeof(T) * CHAR_BIT;
+  // bucket 0 holds keys equal to last_,
+  // bucket i (i > 0) holds keys whose highest bit differing from last_ is bit i - 1.
+  static constexpr size_t kBucketCount = kBits + 1;
+
+  struct Bucket {
+    T *data = nullptr;
+    size_t size = 0, capacity = 0;
+
+    // unchanged if the allocation throws.
+    void reserve(size_t new_capacity) {
+      if(new_capacity <= capacity) return;
+      T *new_data = new T[new_capacity];
+      if(size != 0) std::memcpy(new_data, data, size * sizeof(T));
+      delete[] data;
+      data = new_data;
+      capacity = new_capacity;
+    }
+    void push_back(const T &e) {
+      if(size == capacity) reserve((capacity + 1) * 2);
+      data[size++] = e;
+    }
+  };
+  // top() only redistributes the buckets, which is invisible from outside.
+  mutable Bucket buckets_[kBucketCount];
+  // bit i - 1 is set iff bucket i (i > 0) is not empty.
+  mutable unsigned long long occupied_;
+  mutable Bits last_;
+  size_t size_;
+
+  // order-preserving map from T to its unsigned counterpart.
+  static Bits to_bits(const T &e) {
+    return std::is_signed<T>::value
+      ? static_cast<Bits>(static_cast<Bits>(e) ^ (Bits(1) << (kBits - 1)))
+      : static_cast<Bits>(e);
+  }
+  // the number of bits needed to write x, 0 for 0.
+  static size_t bit_width(Bits x) {
+    if(x == 0) return 0;
+#if defined(__GNUC__)
+    return sizeof(unsigned long long) * CHAR_BIT
+      - __builtin_clzll(static_cast<unsigned long long>(x));
+#else
+    size_t width = 0;
+    for(unsigned long long y = x; y != 0; y >>= 1) ++width;
+    return width;
+#endif
+  }
+  // the index of the lowest set bit of x, which shouldn't be 0.
+  static size_t lowest_bit(unsigned long long x) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);
+#else
+    size_t index = 0;
+    for(; (x & 1) == 0; x >>= 1) ++index;
+    return index;
+#endif
+  }
+  size_t bucket_of(const T &e) const {
+    return bit_width(to_bits(e) ^ last_);
+  }
+  void put(const T &e) const {
+    size_t i = bucket_of(e);
+    buckets_[i].push_back(e);
+    if(i != 0) occupied_ |= 1ULL << (i - 1);
+  }
+  // make sure bucket 0 holds the minimum keys. heap shouldn't be empty.
+  // the destination buckets are reserved before anything is moved,
+  // so the heap is unchanged if an allocation throws.
+  void refill() const {
+    if(buckets_[0].size != 0) return;
+    size_t i = lowest_bit(occupied_) + 1;
+    Bucket &bucket = buckets_[i];
+    Bits min_bits = to_bits(bucket.data[0]);
+    for(size_t j = 1; j < bucket.size; ++j)
+      if(to_bits(bucket.data[j]) < min_bits) min_bits = to_bits(bucket.data[j]);
+    // every key in bucket i goes to a bucket strictly lower than i.
+    size_t counts[kBucketCount] = {};
+    for(size_t j = 0; j < bucket.size; ++j)
+      ++counts[bit_width(to_bits(bucket.data[j]) ^ min_bits)];
+    for(size_t k = 0; k < i; ++k)
+      if(counts[k] != 0) buckets_[k].reserve(buckets_[k].size + counts[k]);
+    occupied_ &= ~(1ULL << (i - 1));
+    last_ = min_bits;
+    for(size_t j = 0; j < bucket.size; ++j)
+      put(bucket.data[j]);
+    bucket.size = 0;
+  }
+  // this heap should be empty and own no buffers. if an allocation throws,
+  // the buckets copied so far are freed and it stays empty.
+  void copy_from(const radix_heap &other) {
+    try {
+      for(size_t i = 0; i < kBucketCount; ++i) {
+        const Bucket &src = other.buckets_[i];
+        if(src.size == 0) continue;
+        buckets_[i].data = new T[src.size];
+        std::memcpy(buckets_[i].data, src.data, src.size * sizeof(T));
+        buckets_[i].size = buckets_[i].capacity = src.size;
+      }
+    } catch(...) {
+      free_buckets();
+      throw;
+    }
+    occupied_ = other.occupied_;
+    last_ = other.last_;
+    size_ = other.size_;
+  }
+  void steal_from(radix_heap &other) {
+    for(size_t i = 0; i < kBucketCount; ++i) {
+      buckets_[i] = other.buckets_[i];
+      other.buckets_[i] = Bucket();
+    }
+    occupied_ = other.occupied_;
+    last_ = other.last_;
+    size_ = other.size_;
+    other.occupied_ = 0;
+    other.last_ = 0;
+    other.size_ = 0;
+  }
+  void free_buckets() {
+    for(size_t i = 0; i < kBucketCount; ++i) {
+      delete[] buckets_[i].data;
+      buckets_[i] = Bucket();
+    }
+  }
+
+public:
+  radix_heap(): occupied_(0), last_(0), size_(0) {}
+  radix_heap(const radix_heap &other): occupied_(0), last_(0), size_(0) {
+    copy_from(other);
+  }
+  radix_heap(radix_heap &&other) noexcept: occupied_(0), last_(0), size_(0) {
+    steal_from(other);
+  }
+  ~radix_heap() {
+    free_buckets();
+  }
+  radix_heap &operator=(const radix_heap &other) {
+    if(this == &other) return *this;
+    // copied aside first, so that this heap is untouched if that throws.
+    radix_heap copy(other);
+    free_buckets();
+    steal_from(copy);
+    return *this;
+  }
+  radix_heap &operator=(radix_heap &&other) noexcept {
+    if(this == &other) return *this;
+    free_buckets();
+    steal_from(other);
+    return *this;
+  }
+  // throw container_is_empty if empty.
+  const T& top() const {
+    if(empty()) throw container_is_empty();
+    refill();
+    return buckets_[0].data[buckets_[0].size - 1];
+  }
+  // throw runtime_error if e is smaller than the last key seen by top() or pop().
+  void push(const T &e) {
+    if(to_bits(e) < last_) throw runtime_error();
+    put(e);
+    ++size_;
+  }
+  // throw container_is_empty if empty.
+  void pop() {
+    if(empty()) throw container_is_empty();
+    refill();
+    --buckets_[0].size;
+    --size_;
+  }
+  // also resets the monotone lower bound, while the buffers are kept for reuse.
+  void clear() {
+    for(size_t i = 0; i < kBucketCount; ++i)
+      buckets_[i].size = 0;
+    occupied_ = 0;
+    last_ = 0;
+    size_ = 0;
+  }
+  size_t size() const {
+    return size_;
+  }
+  bool empty() const {
+    return size_ == 0;
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef SJTU_STATS_HPP
+#define SJTU_STATS_HPP
+
+#include <atomic>
+#include <cstddef>
+
+namespace sjtu {
+
+/**
+ * operation counters of the containers.
+ * each container takes a Stats policy as its last template parameter, and inherits it privately:
+ *   no_stats, the default, is empty and counts nothing, so the counting calls compile to nothing;
+ *   atomic_stats counts into the container itself;
+ *   global_atomic_stats also adds every count to global_stats(), the sum over such containers.
+ * the policy is part of the container's type, so containers that count and containers
+ * that don't can be mixed freely, even within one program.
+ */
+struct container_stats {
+  size_t allocations = 0, deallocations = 0, bytes_allocated = 0;
+  // a reallocation moves the elements into a new, larger buffer.
+  size_t reallocations = 0, moves = 0;
+  size_t comparisons = 0;
+  // map only. an AVL map counts the updates of balance factors as recolorings.
+  size_t rotations = 0, recolorings = 0;
+  // priority_queue only: two heaps linked into one.
+  size_t links = 0;
+
+  container_stats& operator+=(const container_stats &other) {
+    allocations += other.allocations;
+    deallocations += other.deallocations;
+    bytes_allocated += other.bytes_allocated;
+    reallocations += other.reallocations;
+    moves += other.moves;
+    comparisons += other.comparisons;
+    rotations += other.rotations;
+    recolorings += other.recolorings;
+    links += other.links;
+    return *this;
+  }
+};
+
+// the same counters, updated atomically.
+// const operations count too, so threads reading one container may count at once.
+// the counting is relaxed, as the counters order nothing; a snapshot taken while
+// other threads count may mix values from before and after an operation.
+struct atomic_container_stats {
+  std::atomic<size_t> allocations{0}, deallocations{0}, bytes_allocated{0};
+  std::atomic<size_t> reallocations{0}, moves{0};
+  std::atomic<size_t> comparisons{0};
+  std::atomic<size_t> rotations{0}, recolorings{0};
+  std::atomic<size_t> links{0};
+
+  void add(std::atomic<size_t> atomic_container_stats::*field, size_t n) {
+    (this->*field).fetch_add(n, std::memory_order_relaxed);
+  }
+  container_stats load() const {
+    container_stats res;
+    res.allocations = allocations.load(std::memory_order_relaxed);
+    res.deallocations = deallocations.load(std::memory_order_relaxed);
+    res.bytes_allocated = bytes_allocated.load(std::memory_order_relaxed);
+    res.reallocations = reallocations.load(std::memory_order_relaxed);
+    res.moves = moves.load(std::memory_order_relaxed);
+    res.comparisons = comparisons.load(std::memory_order_relaxed);
+    res.rotations = rotations.load(std::memory_order_relaxed);
+    res.recolorings = recolorings.load(std::memory_order_relaxed);
+    res.links = links.load(std::memory_order_relaxed);
+    return res;
+  }
+  void clear() {
+    allocations.store(0, std::memory_order_relaxed);
+    deallocations.store(0, std::memory_order_relaxed);
+    bytes_allocated.store(0, std::memory_order_relaxed);
+    reallocations.store(0, std::memory_order_relaxed);
+    moves.store(0, std::memory_order_relaxed);
+    comparisons.store(0, std::memory_order_relaxed);
+    rotations.store(0, std::memory_order_relaxed);
+    recolorings.store(0, std::memory_order_relaxed);
+    links.store(0, std::memory_order_relaxed);
+  }
+};
+
+// the sum over all containers with global_atomic_stats.
+inline atomic_container_stats& global_stats_storage() {
+  static atomic_container_stats stats;
+  return stats;
+}
+inline container_stats global_stats() {
+  return global_stats_storage().load();
+}
+inline void reset_global_stats() {
+  global_stats_storage().clear();
+}
+
+// empty, so the containers stay the same size through the empty base optimization.
+class no_stats {
+protected:
+  void count_allocation(size_t) const {}
+  void count_deallocation() const {}
+  void count_reallocation() const {}
+  void count_moves(size_t) const {}
+  void count_comparison() const {}
+  void count_rotation() const {}
+  void count_recoloring() const {}
+  void count_link() const {}
+  container_stats snapshot_stats() const {
+    return container_stats();
+  }
+  void clear_stats() {}
+};
+
+// a copy of a container starts from zero instead of copying the counters.
+template<bool Global>
+class basic_atomic_stats {
+private:
+  mutable atomic_container_stats stats_;
+
+  void add(std::atomic<size_t> atomic_container_stats::*field, size_t n) const {
+    stats_.add(field, n);
+    if(Global) global_stats_storage().add(field, n);
+  }
+
+protected:
+  basic_atomic_stats() = default;
+  basic_atomic_stats(const basic_atomic_stats &) {}
+  basic_atomic_stats& operator=(const basic_atomic_stats &) {
+    return *this;
+  }
+
+  void count_allocation(size_t bytes) const {
+    add(&atomic_container_stats::allocations, 1);
+    add(&atomic_container_stats::bytes_allocated, bytes);
+  }
+  void count_deallocation() const {
+    add(&atomic_container_stats::deallocations, 1);
+  }
+  void count_reallocation() const {
+    add(&atomic_container_stats::reallocations, 1);
+  }
+  void count_moves(size_t n) const {
+    add(&atomic_container_stats::moves, n);
+  }
+  void count_comparison() const {
+    add(&atomic_container_stats::comparisons, 1);
+  }
+  void count_rotation() const {
+    add(&atomic_container_stats::rotations, 1);
+  }
+  void count_recoloring() const {
+    add(&atomic_container_stats::recolorings, 1);
+  }
+  void count_link() const {
+    add(&atomic_container_stats::links, 1);
+  }
+  container_stats snapshot_stats() const {
+    return stats_.load();
+  }
+  void clear_stats() {
+    stats_.clear();
+  }
+};
+
+typedef basic_atomic_stats<false> atomic_stats;
+typedef basic_atomic_stats<true> global_atomic_stats;
+
+}
+
+#endif
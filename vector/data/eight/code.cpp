@@ -0,0 +1,128 @@
+#include "small_vector.hpp"
+
+#include <iostream>
+#include <string>
+
+struct Tracked {
+	static int live;
+	int num;
+	Tracked(int num) : num(num) { ++live; }
+	Tracked(const Tracked &other) : num(other.num) { ++live; }
+	Tracked &operator=(const Tracked &other) = default;
+	~Tracked() { --live; }
+};
+int Tracked::live = 0;
+
+template <class Vector>
+void Print(const Vector &v)
+{
+	for (typename Vector::const_iterator it = v.cbegin(); it != v.cend(); ++it) {
+		std::cout << *it << " ";
+	}
+	std::cout << "| " << v.size() << " " << (v.is_inline() ? "inline" : "heap") << std::endl;
+}
+
+void TestInline()
+{
+	std::cout << "Testing inline storage..." << std::endl;
+	sjtu::small_vector<int, 4, sjtu::atomic_stats> v;
+	for (int i = 0; i < 4; ++i) {
+		v.push_back(i);
+	}
+	Print(v);
+	std::cout << v.stats().allocations << std::endl;
+	v.push_back(4);
+	Print(v);
+	std::cout << v.stats().allocations << " " << v.capacity() << std::endl;
+	v.clear();
+	v.push_back(7);
+	Print(v);
+}
+
+void TestInsertErase()
+{
+	std::cout << "Testing insert and erase..." << std::endl;
+	sjtu::small_vector<std::string, 3> v;
+	v.insert(v.begin(), "b");
+	v.insert(v.begin(), "a");
+	v.insert(v.end(), "d");
+	Print(v);
+	v.insert(v.begin() + 2, "c");
+	Print(v);
+	v.insert(1, v[3]);
+	Print(v);
+	v.erase(v.begin() + 1);
+	v.erase(0);
+	Print(v);
+	v.pop_back();
+	std::cout << v.front() << " " << v.back() << std::endl;
+}
+
+void TestCopyMove()
+{
+	std::cout << "Testing copies and moves..." << std::endl;
+	sjtu::small_vector<Tracked, 2> a;
+	a.push_back(Tracked(1));
+	sjtu::small_vector<Tracked, 2> b(a);
+	sjtu::small_vector<Tracked, 2> c(std::move(a));
+	std::cout << a.size() << " " << b[0].num << " " << c[0].num << std::endl;
+	for (int i = 2; i <= 5; ++i) {
+		c.push_back(Tracked(i));
+	}
+	b = c;
+	sjtu::small_vector<Tracked, 2> d(std::move(c));
+	std::cout << b.size() << " " << c.size() << " " << c.is_inline() << " " << d.size() << " " << d.is_inline() << std::endl;
+	d = std::move(b);
+	std::cout << d.back().num << " " << b.size() << std::endl;
+	b = d;
+	b = b;
+	std::cout << b.size() << " " << Tracked::live << std::endl;
+}
+
+void TestIterators()
+{
+	std::cout << "Testing iterators..." << std::endl;
+	sjtu::small_vector<int, 4> v, w;
+	for (int i = 0; i < 6; ++i) {
+		v.push_back(i * i);
+	}
+	sjtu::small_vector<int, 4>::iterator it = v.begin() + 3;
+	std::cout << *it << " " << (v.end() - it) << " " << *(it - 2) << std::endl;
+	*it = -1;
+	std::cout << v[3] << std::endl;
+	try {
+		it = v.end() + 1;
+	} catch (sjtu::index_out_of_bound) {
+		std::cout << "index_out_of_bound" << std::endl;
+	}
+	try {
+		std::cout << (w.end() - v.begin()) << std::endl;
+	} catch (sjtu::invalid_iterator) {
+		std::cout << "invalid_iterator" << std::endl;
+	}
+	try {
+		v.erase(w.begin());
+	} catch (sjtu::invalid_iterator) {
+		std::cout << "invalid_iterator" << std::endl;
+	}
+	try {
+		w.pop_back();
+	} catch (sjtu::container_is_empty) {
+		std::cout << "container_is_empty" << std::endl;
+	}
+	try {
+		std::cout << v.at(6) << std::endl;
+	} catch (sjtu::index_out_of_bound) {
+		std::cout << "index_out_of_bound" << std::endl;
+	}
+}
+
+int main()
+{
+	TestInline();
+	TestInsertErase();
+	TestCopyMove();
+	std::cout << Tracked::live << std::endl;
+	TestIterators();
+	return 0;
+}
@@ -0,0 +1,122 @@
+#include "segmented_vector.hpp"
+
+#include <iostream>
+#include <string>
+
+struct Tracked {
+	static int live;
+	int num;
+	Tracked(int num) : num(num) { ++live; }
+	Tracked(const Tracked &other) : num(other.num) { ++live; }
+	Tracked &operator=(const Tracked &other) = default;
+	~Tracked() { --live; }
+};
+int Tracked::live = 0;
+
+template <class Vector>
+void Print(const Vector &v)
+{
+	for (typename Vector::const_iterator it = v.cbegin(); it != v.cend(); ++it) {
+		std::cout << *it << " ";
+	}
+	std::cout << "| " << v.size() << std::endl;
+}
+
+void TestGrowth()
+{
+	std::cout << "Testing growth..." << std::endl;
+	sjtu::segmented_vector<int, sjtu::atomic_stats> v;
+	v.push_back(0);
+	int *first = &v[0];
+	std::cout << v.capacity() << std::endl;
+	for (int i = 1; i < 100000; ++i) {
+		v.push_back(i);
+	}
+	// the segments hold 16, 32, 64, ... elements.
+	std::cout << v.capacity() << " " << v.stats().allocations << " " << v.stats().reallocations << " "
+		<< v.stats().moves << std::endl;
+	std::cout << (first == &v[0]) << " " << (&v[15] + 1 == &v[16]) << std::endl;
+	bool ok = true;
+	for (int i = 0; i < 100000; ++i) {
+		if (v[i] != i || *(v.begin() + i) != i) ok = false;
+	}
+	std::cout << ok << " " << v.front() << " " << v.back() << " " << (v.end() - v.begin()) << std::endl;
+	try {
+		v.at(100000);
+	} catch (sjtu::index_out_of_bound) {
+		std::cout << "index_out_of_bound" << std::endl;
+	}
+	for (int i = 0; i < 99990; ++i) {
+		v.pop_back();
+	}
+	Print(v);
+	v.clear();
+	v.reserve(100);
+	std::cout << v.capacity() << " " << v.stats().allocations << std::endl;
+}
+
+void TestInsertErase()
+{
+	std::cout << "Testing insert and erase..." << std::endl;
+	sjtu::segmented_vector<std::string> v;
+	v.insert(v.begin(), "b");
+	v.insert(v.begin(), "a");
+	v.insert(v.end(), "d");
+	Print(v);
+	v.insert(v.begin() + 2, "c");
+	Print(v);
+	v.insert(1, v[3]);
+	Print(v);
+	v.erase(v.begin() + 1);
+	v.erase(0);
+	Print(v);
+	// a shift across the boundary of two segments.
+	sjtu::segmented_vector<int> w;
+	for (int i = 0; i < 20; ++i) {
+		w.push_back(i);
+	}
+	w.insert(3, -1);
+	w.erase(w.begin() + 10);
+	Print(w);
+	try {
+		w.erase(w.end());
+	} catch (sjtu::index_out_of_bound) {
+		std::cout << "index_out_of_bound" << std::endl;
+	}
+	sjtu::segmented_vector<int> other(w);
+	try {
+		w.insert(other.begin(), 0);
+	} catch (sjtu::invalid_iterator) {
+		std::cout << "invalid_iterator" << std::endl;
+	}
+}
+
+void TestCopyMove()
+{
+	std::cout << "Testing copies and moves..." << std::endl;
+	{
+		sjtu::segmented_vector<Tracked> a;
+		for (int i = 0; i < 40; ++i) {
+			a.push_back(Tracked(i));
+		}
+		Tracked *kept = &a[39];
+		sjtu::segmented_vector<Tracked> b(a);
+		sjtu::segmented_vector<Tracked> c(std::move(a));
+		std::cout << a.size() << " " << a.capacity() << " " << b[39].num << " " << (&c[39] == kept) << std::endl;
+		a = b;
+		b = std::move(c);
+		a = a;
+		std::cout << a.size() << " " << b.size() << " " << c.size() << " " << Tracked::live << std::endl;
+		c.push_back(Tracked(7));
+		std::cout << c.back().num << " " << c.capacity() << std::endl;
+	}
+	std::cout << Tracked::live << std::endl;
+}
+
+int main()
+{
+	TestGrowth();
+	TestInsertErase();
+	TestCopyMove();
+	return 0;
+}
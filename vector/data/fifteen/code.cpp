@@ -0,0 +1,134 @@
+#include "vector.hpp"
+
+#include <iostream>
+
+struct Tracked {
+	static int live, copies, assignments;
+	int num;
+	Tracked(int num) : num(num) { ++live; }
+	Tracked(const Tracked &other) : num(other.num) { ++live; ++copies; }
+	Tracked &operator=(const Tracked &other)
+	{
+		num = other.num;
+		++assignments;
+		return *this;
+	}
+	~Tracked() { --live; }
+};
+int Tracked::live = 0, Tracked::copies = 0, Tracked::assignments = 0;
+
+// its copies throw once the budget runs out, and it has no move constructor.
+struct Fragile {
+	static int budget;
+	int num;
+	Fragile(int num) : num(num) {}
+	Fragile(const Fragile &other) : num(other.num)
+	{
+		if (budget-- == 0) throw 0;
+	}
+	Fragile &operator=(const Fragile &other) = default;
+};
+int Fragile::budget = -1;
+
+typedef sjtu::vector<Tracked, sjtu::heap_storage, sjtu::atomic_stats> Counted;
+
+void reset()
+{
+	Tracked::copies = Tracked::assignments = 0;
+}
+
+bool same(const Counted &a, const Counted &b)
+{
+	if (a.size() != b.size()) return false;
+	for (size_t i = 0; i < a.size(); ++i) {
+		if (a[i].num != b[i].num) return false;
+	}
+	return true;
+}
+
+void TestReuse()
+{
+	std::cout << "Testing a reused buffer..." << std::endl;
+	{
+		Counted big, small, scratch;
+		for (int i = 0; i < 100; ++i) {
+			big.push_back(Tracked(i));
+		}
+		for (int i = 0; i < 30; ++i) {
+			small.push_back(Tracked(-i));
+		}
+		reset();
+		scratch = big;
+		std::cout << same(scratch, big) << " " << scratch.stats().allocations << " " << Tracked::copies << " " << Tracked::assignments << std::endl;
+		// smaller and larger again, in the same buffer.
+		reset();
+		scratch = small;
+		std::cout << same(scratch, small) << " " << scratch.stats().allocations << " " << Tracked::copies << " " << Tracked::assignments << std::endl;
+		reset();
+		scratch = big;
+		std::cout << same(scratch, big) << " " << scratch.stats().allocations << " " << Tracked::copies << " " << Tracked::assignments << std::endl;
+		std::cout << Tracked::live << std::endl;
+		// the elements sit at the back, so the copies must start further to the front.
+		Counted shifted(big);
+		for (int i = 0; i < 95; ++i) {
+			shifted.erase(shifted.begin());
+		}
+		reset();
+		shifted = small;
+		std::cout << same(shifted, small) << " " << shifted.stats().allocations << " " << Tracked::copies << " " << Tracked::assignments << std::endl;
+		shifted.push_back(Tracked(7));
+		shifted.insert(shifted.begin(), Tracked(8));
+		std::cout << shifted.size() << " " << shifted.front().num << " " << shifted.back().num << " " << shifted[1].num << std::endl;
+		Counted empty;
+		scratch = empty;
+		std::cout << scratch.empty() << " " << scratch.stats().allocations << std::endl;
+	}
+	std::cout << Tracked::live << std::endl;
+}
+
+void TestNewBuffer()
+{
+	std::cout << "Testing a new buffer..." << std::endl;
+	sjtu::vector<int, sjtu::heap_storage, sjtu::atomic_stats> source;
+	for (int i = 0; i < 1000; ++i) {
+		source.push_back(i);
+	}
+	// the new buffer is sized to the elements, not to the spare room of the source.
+	sjtu::vector<int, sjtu::heap_storage, sjtu::atomic_stats> copy;
+	copy.push_back(1);
+	copy = source;
+	std::cout << copy.stats().allocations << " " << copy.stats().bytes_allocated / sizeof(int) << std::endl;
+	copy.push_back(1000);
+	copy.insert(copy.begin(), -1);
+	std::cout << copy.size() << " " << copy.front() << " " << copy[1000] << " " << copy.back() << std::endl;
+}
+
+void TestThrowing()
+{
+	std::cout << "Testing throwing copies..." << std::endl;
+	sjtu::vector<Fragile> a, b;
+	for (int i = 0; i < 3; ++i) {
+		a.push_back(Fragile(i));
+	}
+	for (int i = 0; i < 10; ++i) {
+		b.push_back(Fragile(10 + i));
+	}
+	Fragile::budget = 5;
+	try {
+		a = b;
+	} catch (int) {
+		std::cout << "thrown" << std::endl;
+	}
+	Fragile::budget = -1;
+	std::cout << a.size() << " " << a[0].num << " " << a.back().num << std::endl;
+	a = b;
+	std::cout << a.size() << " " << a[0].num << " " << a.back().num << std::endl;
+}
+
+int main()
+{
+	TestReuse();
+	TestNewBuffer();
+	TestThrowing();
+	return 0;
+}
@@ -0,0 +1,55 @@
+#include "vector.hpp"
+#include "cow.hpp"
+
+#include <iostream>
+
+void TestSharing()
+{
+	std::cout << "Testing sharing on copy..." << std::endl;
+	sjtu::vector<int> v;
+	for (int i = 1; i <= 10; ++i) {
+		v.push_back(i);
+	}
+	sjtu::cow<sjtu::vector<int>> a(v);
+	sjtu::cow<sjtu::vector<int>> b(a), c;
+	c = b;
+	std::cout << a.use_count() << " " << (&a.read() == &c.read()) << std::endl;
+	for (size_t i = 0; i < c->size(); ++i) {
+		std::cout << (*c)[i] << " ";
+	}
+	std::cout << std::endl;
+}
+
+void TestCopyOnWrite()
+{
+	std::cout << "Testing copy on write..." << std::endl;
+	sjtu::cow<sjtu::vector<int>> a;
+	std::cout << a.use_count() << " " << a->size() << std::endl;
+	for (int i = 0; i < 5; ++i) {
+		a.write().push_back(i);
+	}
+	sjtu::cow<sjtu::vector<int>> b = a;
+	b.write().push_back(100);
+	b.write()[0] = -1;
+	std::cout << a.use_count() << " " << b.use_count() << std::endl;
+	for (size_t i = 0; i < a->size(); ++i) {
+		std::cout << a->at(i) << " ";
+	}
+	std::cout << std::endl;
+	for (size_t i = 0; i < b->size(); ++i) {
+		std::cout << b->at(i) << " ";
+	}
+	std::cout << std::endl;
+	sjtu::cow<sjtu::vector<int>> c = std::move(b);
+	std::cout << b.use_count() << " " << b->size() << " " << c->size() << std::endl;
+	c = a;
+	a.write().pop_back();
+	std::cout << a->size() << " " << c->size() << " " << c.unique() << std::endl;
+}
+
+int main()
+{
+	TestSharing();
+	TestCopyOnWrite();
+	return 0;
+}
@@ -0,0 +1,146 @@
+#include "vector.hpp"
+
+#include <iostream>
+#include <string>
+
+struct Tracked {
+	static int live;
+	int num;
+	Tracked() : num(-1) { ++live; }
+	Tracked(int num) : num(num) { ++live; }
+	Tracked(const Tracked &other) : num(other.num) { ++live; }
+	Tracked &operator=(const Tracked &other) = default;
+	~Tracked() { --live; }
+};
+int Tracked::live = 0;
+
+// its copies throw once the budget runs out, and it has no move constructor.
+struct Fragile {
+	static int budget;
+	int num;
+	Fragile(int num = 0) : num(num) {}
+	Fragile(const Fragile &other) : num(other.num)
+	{
+		if (budget-- == 0) throw 0;
+	}
+	Fragile &operator=(const Fragile &other) = default;
+};
+int Fragile::budget = -1;
+
+void TestResize()
+{
+	std::cout << "Testing resize..." << std::endl;
+	{
+		sjtu::vector<Tracked, sjtu::heap_storage, sjtu::atomic_stats> v;
+		v.resize(5);
+		std::cout << v.size() << " " << v[0].num << " " << v[4].num << " " << Tracked::live << std::endl;
+		v.resize(8, Tracked(7));
+		std::cout << v.size() << " " << v[4].num << " " << v[5].num << " " << v[7].num << " " << Tracked::live << std::endl;
+		v.resize(3);
+		std::cout << v.size() << " " << v.back().num << " " << Tracked::live << std::endl;
+		// the value is an element, and growing reallocates.
+		v[2].num = 42;
+		size_t before = v.stats().reallocations;
+		v.resize(100, v[2]);
+		bool ok = true;
+		for (size_t i = 2; i < v.size(); ++i) {
+			if (v[i].num != 42) ok = false;
+		}
+		std::cout << ok << " " << (v.stats().reallocations > before) << " " << Tracked::live - (int)v.size() << std::endl;
+		v.resize(0);
+		std::cout << v.empty() << " " << Tracked::live << std::endl;
+	}
+	sjtu::vector<std::string> s;
+	s.resize(2, "ab");
+	s.resize(4);
+	std::cout << s[0] << s[1] << "[" << s[3] << "] " << s.size() << std::endl;
+}
+
+void TestResizeUninitialized()
+{
+	std::cout << "Testing resize_uninitialized..." << std::endl;
+	sjtu::vector<int> v;
+	for (int i = 0; i < 10; ++i) {
+		v.push_back(i);
+	}
+	v.resize_uninitialized(1000);
+	for (int i = 10; i < 1000; ++i) {
+		v.data()[i] = i;
+	}
+	bool ok = true;
+	for (int i = 0; i < 1000; ++i) {
+		if (v[i] != i) ok = false;
+	}
+	std::cout << ok << " " << v.size() << std::endl;
+	v.resize_uninitialized(4);
+	std::cout << v.size() << " " << v.back() << std::endl;
+}
+
+void TestAppend()
+{
+	std::cout << "Testing append..." << std::endl;
+	int raw[100];
+	for (int i = 0; i < 100; ++i) {
+		raw[i] = i * i;
+	}
+	sjtu::vector<int, sjtu::heap_storage, sjtu::atomic_stats> v;
+	v.append(raw, 100);
+	v.append(raw, 0);
+	v.append(nullptr, 0);
+	std::cout << v.size() << " " << v[99] << " " << v.stats().reallocations << std::endl;
+	// from itself, while reallocating.
+	v.append(v.data() + 90, 10);
+	v.append(v.data(), v.size());
+	bool ok = true;
+	for (int i = 0; i < 100; ++i) {
+		if (v[i] != i * i || v[110 + i] != i * i) ok = false;
+	}
+	for (int i = 0; i < 10; ++i) {
+		if (v[100 + i] != (90 + i) * (90 + i) || v[210 + i] != v[100 + i]) ok = false;
+	}
+	std::cout << ok << " " << v.size() << std::endl;
+	{
+		Tracked items[3] = {Tracked(1), Tracked(2), Tracked(3)};
+		sjtu::vector<Tracked> t;
+		t.push_back(Tracked(0));
+		t.append(items, 3);
+		std::cout << t.size() << " " << t[0].num << t[1].num << t[3].num << " " << Tracked::live << std::endl;
+	}
+	std::cout << Tracked::live << std::endl;
+}
+
+void TestStrongGuarantee()
+{
+	std::cout << "Testing throwing copies..." << std::endl;
+	sjtu::vector<Fragile> v;
+	for (int i = 0; i < 4; ++i) {
+		v.push_back(Fragile(i));
+	}
+	Fragile items[5] = {Fragile(4), Fragile(5), Fragile(6), Fragile(7), Fragile(8)};
+	Fragile::budget = 2;
+	try {
+		v.append(items, 5);
+	} catch (int) {
+		std::cout << "thrown" << std::endl;
+	}
+	std::cout << v.size() << " " << v.back().num << std::endl;
+	Fragile::budget = 3;
+	try {
+		v.resize(10, Fragile(9));
+	} catch (int) {
+		std::cout << "thrown" << std::endl;
+	}
+	Fragile::budget = -1;
+	std::cout << v.size() << " " << v.back().num << std::endl;
+	v.append(items, 5);
+	std::cout << v.size() << " " << v.back().num << std::endl;
+}
+
+int main()
+{
+	TestResize();
+	TestResizeUninitialized();
+	TestAppend();
+	TestStrongGuarantee();
+	return 0;
+}
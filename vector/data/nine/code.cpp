@@ -0,0 +1,160 @@
+#include "vector.hpp"
+
+#include <iostream>
+#include <string>
+
+// copying throws once the budget runs out. moving never throws unless kMayThrow.
+template <bool kMayThrow>
+struct Fragile {
+	static int live, budget;
+	int num;
+	std::string text;
+	Fragile(int num) : num(num), text(std::to_string(num)) { ++live; }
+	Fragile(const Fragile &other) : num(other.num), text(other.text)
+	{
+		if (budget == 0) {
+			throw std::string("copy failed");
+		}
+		--budget;
+		++live;
+	}
+	Fragile(Fragile &&other) noexcept(!kMayThrow) : num(other.num), text(std::move(other.text)) { ++live; }
+	Fragile &operator=(const Fragile &other) = default;
+	Fragile &operator=(Fragile &&other) = default;
+	~Fragile() { --live; }
+};
+template <bool kMayThrow> int Fragile<kMayThrow>::live = 0;
+template <bool kMayThrow> int Fragile<kMayThrow>::budget = 1 << 30;
+
+template <class Tp>
+void Print(const sjtu::vector<Tp> &v)
+{
+	for (size_t i = 0; i < v.size(); ++i) {
+		std::cout << v[i].num << ":" << v[i].text << " ";
+	}
+	std::cout << "| " << Tp::live << std::endl;
+}
+
+void TestReserveCopies()
+{
+	std::cout << "Testing reserve with throwing moves..." << std::endl;
+	typedef Fragile<true> T;
+	{
+		sjtu::vector<T> v;
+		for (int i = 0; i < 6; ++i) {
+			v.push_back(T(i));
+		}
+		T::budget = 3;
+		try {
+			v.reserve(100);
+		} catch (std::string &) {
+			std::cout << "copy failed" << std::endl;
+		}
+		T::budget = 1 << 30;
+		Print(v);
+		v.reserve(100);
+		Print(v);
+	}
+	std::cout << T::live << std::endl;
+}
+
+void TestReserveMoves()
+{
+	std::cout << "Testing reserve with noexcept moves..." << std::endl;
+	typedef Fragile<false> T;
+	{
+		sjtu::vector<T> v;
+		for (int i = 0; i < 6; ++i) {
+			v.push_back(T(i));
+		}
+		T::budget = 0;
+		v.reserve(100);
+		T::budget = 1 << 30;
+		Print(v);
+	}
+	std::cout << T::live << std::endl;
+}
+
+void TestShifting()
+{
+	std::cout << "Testing insert and erase..." << std::endl;
+	typedef Fragile<false> T;
+	{
+		sjtu::vector<T> v;
+		for (int i = 0; i < 8; ++i) {
+			v.push_back(T(i));
+		}
+		v.insert(v.begin() + 6, v[0]);
+		v.insert(v.begin() + 1, v[8]);
+		v.insert(v.begin(), T(-1));
+		v.insert(v.end(), v.front());
+		Print(v);
+		v.erase(v.begin() + 8);
+		v.erase(v.begin() + 2);
+		v.erase(v.begin());
+		v.erase(v.end() - 1);
+		Print(v);
+		T::budget = 0;
+		try {
+			v.insert(v.begin() + 3, v[0]);
+		} catch (std::string &) {
+			std::cout << "copy failed" << std::endl;
+		}
+		T::budget = 1 << 30;
+		Print(v);
+	}
+	std::cout << T::live << std::endl;
+}
+
+void TestPushBackAlias()
+{
+	std::cout << "Testing push_back of its own elements..." << std::endl;
+	typedef Fragile<false> T;
+	{
+		sjtu::vector<T> v;
+		v.push_back(T(1));
+		for (int i = 0; i < 5; ++i) {
+			v.push_back(v.back());
+			v.push_back(v[0]);
+		}
+		Print(v);
+	}
+	std::cout << T::live << std::endl;
+}
+
+void TestCopyFailure()
+{
+	std::cout << "Testing copies that throw..." << std::endl;
+	typedef Fragile<false> T;
+	{
+		sjtu::vector<T> v, w;
+		for (int i = 0; i < 5; ++i) {
+			v.push_back(T(i));
+		}
+		T::budget = 2;
+		try {
+			sjtu::vector<T> copy(v);
+		} catch (std::string &) {
+			std::cout << "copy failed" << std::endl;
+		}
+		T::budget = 2;
+		try {
+			w = v;
+		} catch (std::string &) {
+			std::cout << "copy failed" << std::endl;
+		}
+		T::budget = 1 << 30;
+		Print(w);
+	}
+	std::cout << T::live << std::endl;
+}
+
+int main()
+{
+	TestReserveCopies();
+	TestReserveMoves();
+	TestShifting();
+	TestPushBackAlias();
+	TestCopyFailure();
+	return 0;
+}
@@ -0,0 +1,112 @@
+#include "vector.hpp"
+#include "mapped_vector.hpp"
+
+#include <cstdio>
+#include <iostream>
+
+const char *kPath = "vector_seven.bin";
+
+struct Point {
+	int x, y;
+	double weight;
+};
+
+void TestRoundTrip()
+{
+	std::cout << "Testing save and load..." << std::endl;
+	sjtu::vector<Point> v;
+	for (int i = 0; i < 1000; ++i) {
+		v.push_back(Point{i, -i, i / 2.0});
+	}
+	v.erase(v.begin());
+	v.save(kPath);
+	sjtu::vector<Point> loaded;
+	loaded.push_back(Point{0, 0, 0});
+	loaded.load(kPath);
+	std::cout << loaded.size() << " " << loaded.front().x << " " << loaded.back().y << " " << loaded[500].weight << std::endl;
+	loaded.insert(loaded.begin(), Point{-1, 1, 0});
+	loaded.push_back(Point{1000, -1000, 500});
+	std::cout << loaded.size() << " " << loaded.front().x << " " << loaded.back().x << std::endl;
+}
+
+void TestMapped()
+{
+	std::cout << "Testing mapped files..." << std::endl;
+	sjtu::vector<long long> v;
+	for (long long i = 0; i < 100000; ++i) {
+		v.push_back(i * i);
+	}
+	v.save(kPath);
+	sjtu::mapped_vector<long long> mapped(kPath);
+	long long sum = 0;
+	for (sjtu::mapped_vector<long long>::const_iterator it = mapped.cbegin(); it != mapped.cend(); ++it) {
+		sum += *it;
+	}
+	std::cout << mapped.size() << " " << mapped[99999] << " " << sum << std::endl;
+	sjtu::mapped_vector<long long> moved(std::move(mapped));
+	std::cout << mapped.size() << " " << moved.size() << " " << moved.back() << std::endl;
+	try {
+		moved.at(100000);
+	} catch (sjtu::index_out_of_bound) {
+		std::cout << "out of bound" << std::endl;
+	}
+	try {
+		sjtu::mapped_vector<int> wrong(kPath);
+		std::cout << wrong.size() << std::endl;
+	} catch (sjtu::runtime_error) {
+		std::cout << "wrong type" << std::endl;
+	}
+}
+
+void TestEmpty()
+{
+	std::cout << "Testing empty files..." << std::endl;
+	sjtu::vector<int> v;
+	v.save(kPath);
+	sjtu::mapped_vector<int> mapped(kPath);
+	std::cout << mapped.size() << " " << mapped.empty() << " " << (mapped.begin() == mapped.end()) << std::endl;
+	sjtu::vector<int> loaded;
+	loaded.push_back(1);
+	loaded.load(kPath);
+	std::cout << loaded.size() << std::endl;
+	loaded.push_back(2);
+	std::cout << loaded.size() << " " << loaded[0] << std::endl;
+	try {
+		loaded.load("vector_seven.missing");
+	} catch (sjtu::runtime_error) {
+		std::cout << "missing " << loaded.size() << std::endl;
+	}
+}
+
+void TestCorrupt()
+{
+	std::cout << "Testing corrupt files..." << std::endl;
+	sjtu::vector<int> v;
+	for (int i = 0; i < 100; ++i) {
+		v.push_back(i);
+	}
+	v.save(kPath);
+	// a count far beyond the file size, once huge and once wrapping count * sizeof(int) around.
+	const unsigned long long counts[] = {1ULL << 40, (1ULL << 62) + 1};
+	for (unsigned long long count : counts) {
+		std::FILE *file = std::fopen(kPath, "r+b");
+		std::fseek(file, 16, SEEK_SET);
+		std::fwrite(&count, sizeof(count), 1, file);
+		std::fclose(file);
+		try {
+			v.load(kPath);
+		} catch (sjtu::runtime_error) {
+			std::cout << "corrupt " << v.size() << " " << v.back() << std::endl;
+		}
+	}
+}
+
+int main()
+{
+	TestRoundTrip();
+	TestMapped();
+	TestEmpty();
+	TestCorrupt();
+	std::remove(kPath);
+	return 0;
+}
@@ -0,0 +1,108 @@
+#include "vector.hpp"
+
+#include <iostream>
+#include <thread>
+
+typedef sjtu::vector<int, sjtu::heap_storage, sjtu::atomic_stats> Vector;
+typedef sjtu::vector<int, sjtu::heap_storage, sjtu::global_atomic_stats> GlobalVector;
+
+void PrintStats(const sjtu::container_stats &stats)
+{
+	std::cout << stats.allocations << " " << stats.deallocations << " " << stats.bytes_allocated << " "
+		<< stats.reallocations << " " << stats.moves << std::endl;
+}
+
+void TestGrowth()
+{
+	std::cout << "Testing reallocations on growth..." << std::endl;
+	Vector v;
+	PrintStats(v.stats());
+	for (int i = 0; i < 10; ++i) {
+		v.push_back(i);
+	}
+	PrintStats(v.stats());
+	v.reserve(100);
+	PrintStats(v.stats());
+	v.reset_stats();
+	PrintStats(v.stats());
+}
+
+void TestShifting()
+{
+	std::cout << "Testing moves on insert and erase..." << std::endl;
+	Vector v;
+	v.reserve(100);
+	for (int i = 0; i < 20; ++i) {
+		v.push_back(i);
+	}
+	v.reset_stats();
+	v.insert(v.begin() + 15, -1);
+	PrintStats(v.stats());
+	v.insert(v.begin() + 2, -2);
+	PrintStats(v.stats());
+	v.erase(v.begin() + 20);
+	PrintStats(v.stats());
+	v.erase(v.begin() + 1);
+	PrintStats(v.stats());
+}
+
+void TestCopy()
+{
+	std::cout << "Testing copies and global stats..." << std::endl;
+	sjtu::reset_global_stats();
+	GlobalVector a;
+	for (int i = 0; i < 5; ++i) {
+		a.push_back(i);
+	}
+	GlobalVector b(a);
+	PrintStats(b.stats());
+	// neither counts into the global stats, and the default one counts nothing at all.
+	sjtu::vector<int> plain;
+	Vector local;
+	for (int i = 0; i < 5; ++i) {
+		plain.push_back(i);
+		local.push_back(i);
+	}
+	PrintStats(plain.stats());
+	PrintStats(sjtu::global_stats());
+}
+
+void TestThreads()
+{
+	std::cout << "Testing global stats from several threads..." << std::endl;
+	sjtu::reset_global_stats();
+	const int kThreads = 4;
+	sjtu::container_stats local[kThreads];
+	std::thread threads[kThreads];
+	for (int t = 0; t < kThreads; ++t) {
+		threads[t] = std::thread([&local, t]() {
+			for (int round = 0; round < 1000; ++round) {
+				GlobalVector v;
+				for (int i = 0; i < 100; ++i) {
+					v.push_back(i);
+				}
+				local[t] += v.stats();
+			}
+		});
+	}
+	for (int t = 0; t < kThreads; ++t) {
+		threads[t].join();
+	}
+	sjtu::container_stats sum;
+	for (int t = 0; t < kThreads; ++t) {
+		sum += local[t];
+	}
+	sjtu::container_stats global = sjtu::global_stats();
+	std::cout << (global.allocations == sum.allocations && global.moves == sum.moves) << " ";
+	PrintStats(global);
+}
+
+int main()
+{
+	TestGrowth();
+	TestShifting();
+	TestCopy();
+	PrintStats(sjtu::global_stats());
+	TestThreads();
+	return 0;
+}
@@ -0,0 +1,135 @@
+#include "vector.hpp"
+#include "huge_page_storage.hpp"
+#include "parallel.hpp"
+
+#include <cstdint>
+#include <iostream>
+
+struct Tracked {
+	static int live;
+	int num;
+	Tracked(int num) : num(num) { ++live; }
+	Tracked(const Tracked &other) : num(other.num) { ++live; }
+	Tracked &operator=(const Tracked &other) = default;
+	~Tracked() { --live; }
+};
+int Tracked::live = 0;
+
+struct Triple {
+	int a, b, c;
+};
+
+template <class Tp, class Storage, class Stats>
+bool aligned(const sjtu::vector<Tp, Storage, Stats> &v, size_t align = 64)
+{
+	return reinterpret_cast<std::uintptr_t>(v.data()) % align == 0;
+}
+
+void TestAligned()
+{
+	std::cout << "Testing aligned_heap_storage..." << std::endl;
+	sjtu::vector<int, sjtu::aligned_heap_storage<64>, sjtu::atomic_stats> v;
+	bool ok = true;
+	for (int i = 0; i < 10000; ++i) {
+		v.push_back(i);
+	}
+	for (int i = 0; i < 10000; ++i) {
+		if (v[i] != i) ok = false;
+	}
+	std::cout << ok << " " << aligned(v) << " " << v.stats().reallocations << std::endl;
+	// inserting at the front moves the first element off the alignment until the next reallocation.
+	v.insert(v.begin(), -1);
+	std::cout << aligned(v) << " ";
+	v.reserve(100000);
+	std::cout << aligned(v) << " " << v.front() << " " << v[10000] << " ";
+	v.clear();
+	v.push_back(7);
+	std::cout << aligned(v) << " " << v.size() << std::endl;
+
+	sjtu::vector<Triple, sjtu::aligned_heap_storage<64>> t;
+	for (int i = 0; i < 1000; ++i) {
+		t.push_back(Triple{i, -i, i * 2});
+	}
+	sjtu::vector<double, sjtu::aligned_heap_storage<4096>> d;
+	d.resize(3000, 0.5);
+	std::cout << aligned(t) << " " << t[999].c << " " << aligned(d, 4096) << " "
+		<< sjtu::reduce(d, 0.0) << std::endl;
+	{
+		sjtu::vector<Tracked, sjtu::aligned_heap_storage<32>, sjtu::atomic_stats> a, b;
+		for (int i = 0; i < 100; ++i) {
+			a.push_back(Tracked(i));
+		}
+		b = a;
+		sjtu::vector<Tracked, sjtu::aligned_heap_storage<32>, sjtu::atomic_stats> c(std::move(a));
+		std::cout << b[99].num << " " << c[50].num << " " << Tracked::live << std::endl;
+		std::cout << b.stats().allocations - b.stats().deallocations << " "
+			<< c.stats().allocations - c.stats().deallocations << std::endl;
+	}
+	std::cout << Tracked::live << std::endl;
+}
+
+// the aligned first element must never be left at index 0 with nothing in front of it.
+template <class Storage>
+void TestFrontInsert(const char *name)
+{
+	std::cout << "Testing front insertion with " << name << "..." << std::endl;
+	sjtu::vector<long long, Storage> v;
+	v.insert(v.begin(), 1);
+	v.insert(v.begin(), 0);
+	std::cout << v.size() << " " << v[0] << " " << v[1] << std::endl;
+	sjtu::vector<long long, Storage> w;
+	for (int i = 0; i < 3; ++i) {
+		w.push_back(i);
+	}
+	w.clear();
+	w.insert(w.begin(), 5);
+	w.clear();
+	for (int i = 0; i < 100; ++i) {
+		w.insert(w.begin(), i);
+	}
+	bool ok = true;
+	for (int i = 0; i < 100; ++i) {
+		if (w[i] != 99 - i) ok = false;
+	}
+	w.reserve(100000);
+	std::cout << ok << " " << w.size() << " " << aligned(w) << std::endl;
+}
+
+template <class Storage>
+void TestHugePages(const char *name)
+{
+	std::cout << "Testing " << name << "..." << std::endl;
+	// grows from the heap into huge pages, past several of them.
+	sjtu::vector<int, Storage> v;
+	bool ok = true;
+	for (int i = 0; i < 3000000; ++i) {
+		v.push_back(i);
+	}
+	for (int i = 0; i < 3000000; ++i) {
+		if (v[i] != i) ok = false;
+	}
+	std::cout << ok << " " << aligned(v) << " " << v.size() << std::endl;
+	sjtu::vector<int, Storage> w(v);
+	v.clear();
+	v.append(w.data(), 1000);
+	v = w;
+	std::cout << aligned(w) << " " << w.back() << " " << v.size() << " " << v[2999999] << std::endl;
+	sjtu::vector<long long, Storage> big;
+	big.resize_uninitialized(1 << 20);
+	for (size_t i = 0; i < big.size(); ++i) {
+		big.data()[i] = i;
+	}
+	std::cout << aligned(big) << " " << sjtu::reduce(big, 0LL) << std::endl;
+}
+
+int main()
+{
+	TestAligned();
+	TestFrontInsert<sjtu::aligned_heap_storage<64>>("aligned_heap_storage<64>");
+	TestFrontInsert<sjtu::aligned_heap_storage<4096>>("aligned_heap_storage<4096>");
+	TestFrontInsert<sjtu::transparent_huge_page_storage>("transparent_huge_page_storage");
+	TestFrontInsert<sjtu::explicit_huge_page_storage>("explicit_huge_page_storage");
+	TestHugePages<sjtu::transparent_huge_page_storage>("transparent_huge_page_storage");
+	TestHugePages<sjtu::explicit_huge_page_storage>("explicit_huge_page_storage");
+	return 0;
+}
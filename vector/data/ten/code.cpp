@@ -0,0 +1,130 @@
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+bool Same(const sjtu::vector<int> &v, const std::vector<int> &ref)
+{
+	if (v.size() != ref.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < ref.size(); ++i) {
+		if (v[i] != ref[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void TestSort(sjtu::thread_pool &pool)
+{
+	std::cout << "Testing parallel_sort..." << std::endl;
+	srand(20240303);
+	for (int n : {0, 1, 100, 100000, 300000}) {
+		sjtu::vector<int> v;
+		std::vector<int> ref;
+		for (int i = 0; i < n; ++i) {
+			// few distinct keys for the small cases, many for the big ones.
+			int x = (n > 100000) ? rand() : rand() % 7;
+			v.push_back(x);
+			ref.push_back(x);
+		}
+		sjtu::parallel_sort(v, std::less<int>(), pool);
+		std::sort(ref.begin(), ref.end());
+		std::cout << n << " " << Same(v, ref) << std::endl;
+	}
+	sjtu::vector<int> sorted;
+	std::vector<int> ref;
+	for (int i = 0; i < 200000; ++i) {
+		sorted.push_back(200000 - i);
+		ref.push_back(i + 1);
+	}
+	sjtu::parallel_sort(sorted, std::less<int>(), pool);
+	std::cout << "reversed " << Same(sorted, ref) << std::endl;
+	sjtu::parallel_sort(sorted, std::greater<int>(), pool);
+	std::cout << sorted.front() << " " << sorted.back() << std::endl;
+
+	sjtu::vector<std::string> words;
+	for (int i = 0; i < 50000; ++i) {
+		words.push_back(std::to_string(i * 7919 % 50000));
+	}
+	sjtu::parallel_sort(words, std::less<std::string>(), pool);
+	std::cout << words[0] << " " << words[1] << " " << words[49999] << std::endl;
+}
+
+void TestElementwise(sjtu::thread_pool &pool)
+{
+	std::cout << "Testing parallel_for_each, transform and reduce..." << std::endl;
+	sjtu::vector<long long> v;
+	for (int i = 1; i <= 1000000; ++i) {
+		v.push_back(i);
+	}
+	sjtu::parallel_for_each(v, [](long long &x) { x *= 2; }, pool);
+	std::cout << sjtu::reduce(v, 0LL, std::plus<long long>(), pool) << std::endl;
+	sjtu::vector<double> halves;
+	for (int i = 0; i < 1000000; ++i) {
+		halves.push_back(0);
+	}
+	sjtu::transform(v, halves, [](long long x) { return x / 4.0; }, pool);
+	std::cout << halves[0] << " " << halves[999999] << std::endl;
+	sjtu::transform(v, v, [](long long x) { return x % 3; }, pool);
+	std::cout << sjtu::reduce(v, 0LL, std::plus<long long>(), pool) << std::endl;
+	// string concatenation is associative but not commutative.
+	sjtu::vector<std::string> letters;
+	for (int i = 0; i < 20000; ++i) {
+		letters.push_back(std::string(1, 'a' + i % 26));
+	}
+	std::string joined = sjtu::reduce(letters, std::string(">"), std::plus<std::string>(), pool);
+	std::cout << joined.size() << " " << joined.substr(0, 30) << " " << joined.substr(joined.size() - 5) << std::endl;
+	sjtu::vector<int> empty;
+	std::cout << sjtu::reduce(empty, 42, std::plus<int>(), pool) << std::endl;
+	try {
+		sjtu::transform(v, empty, [](long long x) { return static_cast<int>(x); }, pool);
+	} catch (sjtu::index_out_of_bound) {
+		std::cout << "index_out_of_bound" << std::endl;
+	}
+}
+
+void TestExceptions(sjtu::thread_pool &pool)
+{
+	std::cout << "Testing exceptions from tasks..." << std::endl;
+	sjtu::vector<int> v;
+	for (int i = 0; i < 100000; ++i) {
+		v.push_back(i);
+	}
+	try {
+		sjtu::parallel_for_each(v, [](int &x) {
+			if (x == 77777) {
+				throw std::string("bad element");
+			}
+			++x;
+		}, pool);
+	} catch (std::string &error) {
+		std::cout << error << std::endl;
+	}
+	sjtu::parallel_for_each(v, [](int &x) { x = 1; }, pool);
+	std::cout << sjtu::reduce(v, 0, std::plus<int>(), pool) << std::endl;
+}
+
+int main()
+{
+	for (size_t workers : {0, 3}) {
+		std::cout << "workers: " << workers << std::endl;
+		sjtu::thread_pool pool(workers);
+		std::cout << pool.concurrency() << std::endl;
+		TestSort(pool);
+		TestElementwise(pool);
+		TestExceptions(pool);
+	}
+	sjtu::vector<int> v;
+	v.push_back(3);
+	v.push_back(1);
+	v.push_back(2);
+	sjtu::parallel_sort(v);
+	std::cout << v[0] << v[1] << v[2] << std::endl;
+	return 0;
+}
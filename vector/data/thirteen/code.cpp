@@ -0,0 +1,155 @@
+#include "deamortized_vector.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+struct Tracked {
+	static int live;
+	int num;
+	Tracked(int num) : num(num) { ++live; }
+	Tracked(const Tracked &other) : num(other.num) { ++live; }
+	Tracked &operator=(const Tracked &other) = default;
+	~Tracked() { --live; }
+};
+int Tracked::live = 0;
+
+// its copies throw once the budget runs out, and it has no move constructor.
+struct Fragile {
+	static int budget;
+	int num;
+	Fragile(int num) : num(num) {}
+	Fragile(const Fragile &other) : num(other.num)
+	{
+		if (budget-- == 0) throw 0;
+	}
+	Fragile &operator=(const Fragile &other) = default;
+};
+int Fragile::budget = -1;
+
+void TestBoundedWork()
+{
+	std::cout << "Testing work per push_back..." << std::endl;
+	sjtu::deamortized_vector<int, sjtu::atomic_stats> v;
+	size_t worst = 0, migrations = 0;
+	for (int i = 0; i < 100000; ++i) {
+		size_t before = v.stats().moves;
+		bool was_migrating = v.migrating();
+		v.push_back(i);
+		size_t moved = v.stats().moves - before;
+		if (moved > worst) worst = moved;
+		if (!was_migrating && v.migrating()) ++migrations;
+	}
+	std::cout << worst << " " << migrations << " " << v.stats().reallocations << " " << v.capacity() << std::endl;
+	bool ok = true;
+	for (int i = 0; i < 100000; ++i) {
+		if (v[i] != i || *(v.begin() + i) != i) ok = false;
+	}
+	std::cout << ok << " " << v.front() << " " << v.back() << " " << v.migrating() << std::endl;
+	try {
+		v.at(100000);
+	} catch (sjtu::index_out_of_bound) {
+		std::cout << "index_out_of_bound" << std::endl;
+	}
+}
+
+void TestMidMigration()
+{
+	std::cout << "Testing edits during a migration..." << std::endl;
+	sjtu::deamortized_vector<int> v;
+	std::vector<int> ref;
+	srand(20240602);
+	bool ok = true;
+	for (int round = 0; round < 50000; ++round) {
+		int op = rand() % 20;
+		if (op < 14 || ref.empty()) {
+			v.push_back(round);
+			ref.push_back(round);
+		} else if (op < 18) {
+			v.pop_back();
+			ref.pop_back();
+		} else if (op == 18) {
+			size_t pos = rand() % (ref.size() + 1);
+			v.insert(pos, round);
+			ref.insert(ref.begin() + pos, round);
+		} else {
+			size_t pos = rand() % ref.size();
+			v.erase(v.begin() + pos);
+			ref.erase(ref.begin() + pos);
+		}
+		if (round % 97 == 0) {
+			for (size_t i = 0; i < ref.size(); ++i) {
+				if (v[i] != ref[i]) ok = false;
+			}
+		}
+	}
+	std::cout << ok << " " << v.size() << " " << ref.size() << std::endl;
+	// popping back into the old buffer ends the migration early.
+	sjtu::deamortized_vector<int> w;
+	for (int i = 0; i < 17; ++i) {
+		w.push_back(i);
+	}
+	std::cout << w.migrating() << " ";
+	w.pop_back();
+	w.pop_back();
+	std::cout << w.migrating() << " ";
+	for (int i = 0; i < 14; ++i) {
+		w.pop_back();
+	}
+	std::cout << w.migrating() << " " << w.size() << " " << w[0] << std::endl;
+}
+
+void TestStrongGuarantee()
+{
+	std::cout << "Testing a throwing migration..." << std::endl;
+	sjtu::deamortized_vector<Fragile> v;
+	for (int i = 0; i < 17; ++i) {
+		v.push_back(Fragile(i));
+	}
+	// the new element is copied, then the migration of an old one throws.
+	Fragile::budget = 1;
+	try {
+		v.push_back(Fragile(17));
+	} catch (int) {
+		std::cout << "thrown" << std::endl;
+	}
+	Fragile::budget = -1;
+	bool ok = true;
+	for (int i = 0; i < 17; ++i) {
+		if (v[i].num != i) ok = false;
+	}
+	std::cout << ok << " " << v.size() << " " << v.migrating() << std::endl;
+	v.push_back(Fragile(17));
+	std::cout << v.back().num << " " << v.size() << std::endl;
+}
+
+void TestCopyMove()
+{
+	std::cout << "Testing copies and moves..." << std::endl;
+	{
+		sjtu::deamortized_vector<Tracked> a;
+		for (int i = 0; i < 20; ++i) {
+			a.push_back(Tracked(i));
+		}
+		sjtu::deamortized_vector<Tracked> b(a);
+		sjtu::deamortized_vector<Tracked> c(std::move(a));
+		std::cout << a.size() << " " << b.migrating() << " " << c.migrating() << " " << b[19].num << " " << c[3].num << std::endl;
+		a = c;
+		b = std::move(c);
+		b = b;
+		b.reserve(100);
+		std::cout << a.size() << " " << b.size() << " " << b.migrating() << " " << b.capacity() << " " << Tracked::live << std::endl;
+		a.clear();
+		std::cout << a.migrating() << " " << Tracked::live << std::endl;
+	}
+	std::cout << Tracked::live << std::endl;
+}
+
+int main()
+{
+	TestBoundedWork();
+	TestMidMigration();
+	TestStrongGuarantee();
+	TestCopyMove();
+	return 0;
+}
@@ -0,0 +1,239 @@
+#include "gap_buffer.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct Tracked {
+	static int live;
+	int num;
+	Tracked(int num) : num(num) { ++live; }
+	Tracked(const Tracked &other) : num(other.num) { ++live; }
+	Tracked &operator=(const Tracked &other) = default;
+	~Tracked() { --live; }
+};
+int Tracked::live = 0;
+
+// its moves and copies throw once the budget runs out.
+struct Fragile {
+	static int live, budget;
+	int num;
+	Fragile(int num) : num(num) { ++live; }
+	Fragile(const Fragile &other) : num(other.num)
+	{
+		spend();
+		++live;
+	}
+	Fragile(Fragile &&other) : num(other.num)
+	{
+		spend();
+		++live;
+	}
+	Fragile &operator=(const Fragile &other)
+	{
+		spend();
+		num = other.num;
+		return *this;
+	}
+	Fragile &operator=(Fragile &&other)
+	{
+		spend();
+		num = other.num;
+		return *this;
+	}
+	~Fragile() { --live; }
+	static void spend()
+	{
+		if (budget == 0) throw 0;
+		if (budget > 0) --budget;
+	}
+};
+int Fragile::live = 0, Fragile::budget = -1;
+
+template <class Vector>
+void Print(const Vector &v)
+{
+	for (typename Vector::const_iterator it = v.cbegin(); it != v.cend(); ++it) {
+		std::cout << *it;
+	}
+	std::cout << " | " << v.size() << " " << v.gap() << std::endl;
+}
+
+void TestTyping()
+{
+	std::cout << "Testing typing at a cursor..." << std::endl;
+	sjtu::gap_buffer<char, sjtu::atomic_stats> text;
+	std::string line = "hello world";
+	for (size_t i = 0; i < line.size(); ++i) {
+		text.push_back(line[i]);
+	}
+	Print(text);
+	// the cursor goes back to the space, and the edits after that move nothing.
+	text.reset_stats();
+	size_t cursor = 5;
+	text.insert(cursor++, ',');
+	text.erase(cursor);
+	const char *word = " there ";
+	for (const char *c = word; *c; ++c) {
+		text.insert(cursor++, *c);
+	}
+	Print(text);
+	std::cout << text.stats().moves << " " << text.stats().reallocations << std::endl;
+	text.insert(text.begin(), '>');
+	std::cout << text.stats().moves << " " << text.front() << text.back() << " " << text[6] << std::endl;
+	Print(text);
+}
+
+void TestRandomEdits()
+{
+	std::cout << "Testing random edits..." << std::endl;
+	sjtu::gap_buffer<int> v;
+	std::vector<int> ref;
+	srand(20240521);
+	bool ok = true;
+	size_t cursor = 0;
+	for (int round = 0; round < 100000; ++round) {
+		int op = rand() % 10;
+		if (op == 0) {
+			cursor = rand() % (ref.size() + 1);
+		} else if (op < 7) {
+			v.insert(v.begin() + cursor, round);
+			ref.insert(ref.begin() + cursor, round);
+			++cursor;
+		} else if (!ref.empty()) {
+			if (cursor == ref.size()) --cursor;
+			v.erase(cursor);
+			ref.erase(ref.begin() + cursor);
+		}
+		if (round % 1000 == 0) {
+			for (size_t i = 0; i < ref.size(); ++i) {
+				if (v[i] != ref[i]) ok = false;
+			}
+		}
+	}
+	std::cout << ok << " " << v.size() << " " << ref.size() << std::endl;
+	try {
+		v.at(v.size());
+	} catch (sjtu::index_out_of_bound) {
+		std::cout << "index_out_of_bound" << std::endl;
+	}
+	try {
+		v.erase(v.end());
+	} catch (sjtu::index_out_of_bound) {
+		std::cout << "index_out_of_bound" << std::endl;
+	}
+	sjtu::gap_buffer<int> other;
+	try {
+		v.insert(other.begin(), 0);
+	} catch (sjtu::invalid_iterator) {
+		std::cout << "invalid_iterator" << std::endl;
+	}
+	while (!v.empty()) {
+		v.pop_back();
+	}
+	try {
+		v.pop_back();
+	} catch (sjtu::container_is_empty) {
+		std::cout << "container_is_empty" << std::endl;
+	}
+}
+
+void TestNonTrivialEdits()
+{
+	std::cout << "Testing random edits of strings..." << std::endl;
+	sjtu::gap_buffer<std::string> v;
+	std::vector<std::string> ref;
+	srand(20240522);
+	bool ok = true;
+	for (int round = 0; round < 20000; ++round) {
+		int op = rand() % 10;
+		size_t pos = rand() % (ref.size() + 1);
+		if (op < 6 || ref.empty()) {
+			std::string s = std::to_string(round) + std::string(round % 40, 'x');
+			v.insert(pos, s);
+			ref.insert(ref.begin() + pos, s);
+		} else {
+			if (pos == ref.size()) --pos;
+			v.erase(pos);
+			ref.erase(ref.begin() + pos);
+		}
+		if (round % 500 == 0) {
+			for (size_t i = 0; i < ref.size(); ++i) {
+				if (v[i] != ref[i]) ok = false;
+			}
+		}
+	}
+	std::cout << ok << " " << v.size() << " " << ref.size() << std::endl;
+}
+
+void TestThrowingMoves()
+{
+	std::cout << "Testing moves that throw..." << std::endl;
+	{
+		sjtu::gap_buffer<Fragile> v;
+		std::vector<int> ref;
+		for (int i = 0; i < 40; ++i) {
+			v.push_back(Fragile(i));
+			ref.push_back(i);
+		}
+		v.reserve(64);
+		srand(20240523);
+		bool ok = true;
+		int thrown = 0;
+		for (int round = 0; round < 2000; ++round) {
+			size_t pos = rand() % (ref.size() + 1);
+			Fragile::budget = rand() % 30;
+			try {
+				if (rand() % 2 == 0 && ref.size() < 60) {
+					v.insert(pos, Fragile(1000 + round));
+					ref.insert(ref.begin() + pos, 1000 + round);
+				} else if (pos < ref.size()) {
+					v.erase(pos);
+					ref.erase(ref.begin() + pos);
+				}
+			} catch (int) {
+				++thrown;
+			}
+			Fragile::budget = -1;
+			if (v.size() != ref.size() || Fragile::live != (int)ref.size()) ok = false;
+			for (size_t i = 0; i < ref.size() && ok; ++i) {
+				if (v[i].num != ref[i]) ok = false;
+			}
+		}
+		std::cout << ok << " " << (thrown > 100) << std::endl;
+	}
+	std::cout << Fragile::live << std::endl;
+}
+
+void TestCopyMove()
+{
+	std::cout << "Testing copies and moves..." << std::endl;
+	{
+		sjtu::gap_buffer<Tracked> a;
+		for (int i = 0; i < 10; ++i) {
+			a.push_back(Tracked(i));
+		}
+		a.insert(3, a[9]);
+		a.erase(a.begin());
+		sjtu::gap_buffer<Tracked> b(a);
+		sjtu::gap_buffer<Tracked> c(std::move(a));
+		std::cout << a.size() << " " << b[2].num << " " << c.gap() << " " << Tracked::live << std::endl;
+		a = b;
+		b = std::move(c);
+		b = b;
+		a.reserve(100);
+		std::cout << a[2].num << " " << a.back().num << " " << a.gap() << " " << a.capacity() << " " << Tracked::live << std::endl;
+	}
+	std::cout << Tracked::live << std::endl;
+}
+
+int main()
+{
+	TestTyping();
+	TestRandomEdits();
+	TestNonTrivialEdits();
+	TestThrowingMoves();
+	TestCopyMove();
+	return 0;
+}
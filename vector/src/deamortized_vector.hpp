@@ -0,0 +1,579 @@
+#ifndef SJTU_DEAMORTIZED_VECTOR_HPP
+#define SJTU_DEAMORTIZED_VECTOR_HPP
+
+#include "exceptions.hpp"
+#include "stats.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace sjtu {
+
+/**
+ * a vector whose push_back takes O(1) in the worst case, not just amortized.
+ * when the buffer is full, a buffer twice as large is allocated, but nothing is moved yet:
+ * new elements go to the new buffer, and every push_back migrates the next 2 old elements.
+ * the migration is done long before the new buffer fills, when the old one is freed.
+ * meanwhile the elements are split between the buffers, so indexing checks which side
+ * an element is on, and the elements aren't contiguous.
+ * insertion and erasure in the middle, which are O(n) anyway, finish the migration first.
+ * migrated elements are moved if that can't throw and copied otherwise.
+ * on linux, large buffers are mapped on their own, so they can be faulted in and given back
+ * to the kernel a chunk at a time: neither the page faults of the new buffer (on linux 5.14
+ * or later) nor freeing the old one lands on a single push.
+ */
+template <class Tp, class Stats = no_stats>
+class deamortized_vector : private Stats {
+  // the Stats policy is a dependent base, so its calls are brought in by name.
+  using Stats::count_allocation;
+  using Stats::count_deallocation;
+  using Stats::count_reallocation;
+  using Stats::count_moves;
+  using Stats::snapshot_stats;
+  using Stats::clear_stats;
+public:
+  class const_iterator;
+  class iterator {
+    friend deamortized_vector;
+    friend const_iterator;
+
+  public:
+    using differnce_type = std::ptrdiff_t;
+    using value_type = Tp;
+    using pointer = Tp*;
+    using reference = Tp&;
+    using iterator_category = std::output_iterator_tag;
+
+    iterator(): _container(nullptr), _index(0) {}
+    iterator(const iterator &) = default;
+    iterator& operator=(const iterator &) = default;
+    iterator operator+(const differnce_type &diff) const {
+      iterator res = *this;
+      return res += diff;
+    }
+    iterator operator-(const differnce_type &diff) const {
+      iterator res = *this;
+      return res -= diff;
+    }
+    // throw invalid_iterator if two containers are not same
+    differnce_type operator-(const iterator &other) const {
+      if(_container != other._container)
+        throw invalid_iterator{};
+      return static_cast<differnce_type>(_index) - static_cast<differnce_type>(other._index);
+    }
+    iterator& operator+=(const differnce_type &diff) {
+      if(diff < 0) return *this -= -diff;
+      if(_index + diff > _container->size())
+        throw index_out_of_bound{};
+      _index += diff;
+      return *this;
+    }
+    iterator& operator-=(const differnce_type &diff) {
+      if(diff < 0) return *this += -diff;
+      if(_index < static_cast<size_t>(diff))
+        throw index_out_of_bound{};
+      _index -= diff;
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator tmp = *this;
+      *this += 1;
+      return tmp;
+    }
+    iterator& operator++() {
+      return *this += 1;
+    }
+    iterator operator--(int) {
+      iterator tmp = *this;
+      *this -= 1;
+      return tmp;
+    }
+    iterator& operator--() {
+      return *this -= 1;
+    }
+    Tp& operator*() const {
+      return *_container->address(_index);
+    }
+    Tp* operator->() const {
+      return _container->address(_index);
+    }
+    bool operator==(const iterator &other) const {
+      return _container == other._container && _index == other._index;
+    }
+    bool operator==(const const_iterator &other) const {
+      return _container == other._container && _index == other._index;
+    }
+    bool operator!=(const iterator &other) const {
+      return !(*this == other);
+    }
+    bool operator!=(const const_iterator &other) const {
+      return !(*this == other);
+    }
+
+  private:
+    const deamortized_vector *_container;
+    size_t _index;
+    iterator(const deamortized_vector *container, const size_t &index): _container(container), _index(index) {}
+  };
+  class const_iterator {
+    friend deamortized_vector;
+    friend iterator;
+
+  public:
+    using differnce_type = std::ptrdiff_t;
+    using value_type = Tp;
+    using pointer = const Tp*;
+    using reference = const Tp&;
+    using iterator_category = std::output_iterator_tag;
+
+    const_iterator(): _container(nullptr), _index(0) {}
+    const_iterator(const const_iterator &) = default;
+    const_iterator(const iterator &other): _container(other._container), _index(other._index) {}
+    const_iterator& operator=(const const_iterator &) = default;
+    const_iterator operator+(const differnce_type &diff) const {
+      const_iterator res = *this;
+      return res += diff;
+    }
+    const_iterator operator-(const differnce_type &diff) const {
+      const_iterator res = *this;
+      return res -= diff;
+    }
+    // throw invalid_iterator if two containers are not same
+    differnce_type operator-(const const_iterator &other) const {
+      if(_container != other._container)
+        throw invalid_iterator{};
+      return static_cast<differnce_type>(_index) - static_cast<differnce_type>(other._index);
+    }
+    const_iterator& operator+=(const differnce_type &diff) {
+      if(diff < 0) return *this -= -diff;
+      if(_index + diff > _container->size())
+        throw index_out_of_bound{};
+      _index += diff;
+      return *this;
+    }
+    const_iterator& operator-=(const differnce_type &diff) {
+      if(diff < 0) return *this += -diff;
+      if(_index < static_cast<size_t>(diff))
+        throw index_out_of_bound{};
+      _index -= diff;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator tmp = *this;
+      *this += 1;
+      return tmp;
+    }
+    const_iterator& operator++() {
+      return *this += 1;
+    }
+    const_iterator operator--(int) {
+      const_iterator tmp = *this;
+      *this -= 1;
+      return tmp;
+    }
+    const_iterator& operator--() {
+      return *this -= 1;
+    }
+    const Tp& operator*() const {
+      return *_container->address(_index);
+    }
+    const Tp* operator->() const {
+      return _container->address(_index);
+    }
+    bool operator==(const const_iterator &other) const {
+      return _container == other._container && _index == other._index;
+    }
+    bool operator==(const iterator &other) const {
+      return _container == other._container && _index == other._index;
+    }
+    bool operator!=(const const_iterator &other) const {
+      return !(*this == other);
+    }
+    bool operator!=(const iterator &other) const {
+      return !(*this == other);
+    }
+
+  private:
+    const deamortized_vector *_container;
+    size_t _index;
+    const_iterator(const deamortized_vector *container, const size_t &index): _container(container), _index(index) {}
+  };
+
+  deamortized_vector(): _data(nullptr), _old(nullptr), _size(0), _capacity(0), _migrated(0), _split(0),
+    _front_ready(0), _back_ready(0), _released_bytes(0) {}
+  // if a copy throws, the destructor cleans up the elements copied so far.
+  deamortized_vector(const deamortized_vector &other): deamortized_vector() {
+    reserve(other._size);
+    for(; _size < other._size; ++_size)
+      new(_data + _size) Tp(*other.address(_size));
+  }
+  deamortized_vector(deamortized_vector &&other) noexcept: deamortized_vector() {
+    take(other);
+  }
+  ~deamortized_vector() {
+    clear();
+    deallocate(_data, _capacity);
+  }
+  deamortized_vector& operator=(const deamortized_vector &other) {
+    if(this == &other) return *this;
+    clear();
+    reserve(other._size);
+    for(; _size < other._size; ++_size)
+      new(_data + _size) Tp(*other.address(_size));
+    return *this;
+  }
+  deamortized_vector& operator=(deamortized_vector &&other) noexcept {
+    if(this == &other) return *this;
+    clear();
+    deallocate(_data, _capacity);
+    _data = nullptr;
+    _capacity = 0;
+    _front_ready = _back_ready = 0;
+    take(other);
+    return *this;
+  }
+
+  // throw index_out_of_bound if pos is not in [0, size)
+  Tp& at(const size_t &pos) {
+    if(pos >= _size)
+      throw index_out_of_bound{};
+    return *address(pos);
+  }
+  // throw index_out_of_bound if pos is not in [0, size)
+  const Tp& at(const size_t &pos) const {
+    if(pos >= _size)
+      throw index_out_of_bound{};
+    return *address(pos);
+  }
+  // throw index_out_of_bound if pos is not in [0, size)
+  Tp& operator[](const size_t &pos) {
+    return at(pos);
+  }
+  // throw index_out_of_bound if pos is not in [0, size)
+  const Tp& operator[](const size_t &pos) const {
+    return at(pos);
+  }
+  // throw container_is_empty if size is 0
+  const Tp& front() const {
+    if(empty())
+      throw container_is_empty{};
+    return *address(0);
+  }
+  // throw container_is_empty if size is 0
+  const Tp& back() const {
+    if(empty())
+      throw container_is_empty{};
+    return *address(_size - 1);
+  }
+  iterator begin() const {
+    return iterator{this, 0};
+  }
+  iterator end() const {
+    return iterator{this, _size};
+  }
+  const_iterator cbegin() const {
+    return const_iterator{this, 0};
+  }
+  const_iterator cend() const {
+    return const_iterator{this, _size};
+  }
+  bool empty() const {
+    return _size == 0;
+  }
+  size_t size() const {
+    return _size;
+  }
+  size_t capacity() const {
+    return _capacity;
+  }
+  // whether some elements are still in the old buffer.
+  bool migrating() const {
+    return _old != nullptr;
+  }
+  // destroys the elements and frees the old buffer, but keeps the current one.
+  void clear() {
+    for(size_t i = 0; i < _size; ++i)
+      address(i)->~Tp();
+    _size = 0;
+    free_old();
+  }
+  // reallocates at once, in O(n), after finishing the migration.
+  // if copying an element throws, the vector is left unchanged.
+  void reserve(const size_t &capacity) {
+    if(_capacity >= capacity) return;
+    finish_migration();
+    Tp *new_data = allocate(capacity);
+    size_t i = 0;
+    try {
+      for(; i < _size; ++i)
+        new(new_data + i) Tp(std::move_if_noexcept(_data[i]));
+    } catch(...) {
+      for(size_t j = 0; j < i; ++j)
+        new_data[j].~Tp();
+      deallocate(new_data, capacity);
+      throw;
+    }
+    for(size_t j = 0; j < _size; ++j)
+      _data[j].~Tp();
+    if(_data != nullptr) {
+      count_reallocation();
+      count_moves(_size);
+    }
+    deallocate(_data, _capacity);
+    _data = new_data;
+    _capacity = capacity;
+    _back_ready = small(_capacity) ? _capacity : _size;
+  }
+  // throw invalid_iterator if iter is not valid
+  // throw index_out_of_bound if iter has an index > size
+  iterator insert(const iterator &iter, const Tp &value) {
+    if(iter._container != this)
+      throw invalid_iterator{};
+    return insert(iter._index, value);
+  }
+  // throw index_out_of_bound if index > size
+  iterator insert(const size_t &index, const Tp &value) {
+    if(index > _size)
+      throw index_out_of_bound{};
+    if(index == _size) {
+      push_back(value);
+      return iterator{this, index};
+    }
+    // value may be an element of this vector, so it's copied before anything moves.
+    Tp copy(value);
+    finish_migration();
+    if(_size == _capacity)
+      reserve(_capacity * 2);
+    new(_data + _size) Tp(std::move(_data[_size - 1]));
+    ++_size;
+    for(size_t i = _size - 2; i > index; --i)
+      _data[i] = std::move(_data[i - 1]);
+    count_moves(_size - 1 - index);
+    _data[index] = std::move(copy);
+    return iterator{this, index};
+  }
+  // throw invalid_iterator if iter is not valid
+  // throw index_out_of_bound if iter has an index >= size
+  iterator erase(const iterator &iter) {
+    if(iter._container != this)
+      throw invalid_iterator{};
+    return erase(iter._index);
+  }
+  // throw index_out_of_bound if index >= size
+  iterator erase(const size_t &index) {
+    if(index >= _size)
+      throw index_out_of_bound{};
+    finish_migration();
+    for(size_t i = index; i + 1 < _size; ++i)
+      _data[i] = std::move(_data[i + 1]);
+    count_moves(_size - 1 - index);
+    --_size;
+    _data[_size].~Tp();
+    return iterator{this, index};
+  }
+  // the new element is constructed before any migration, so value may be an element of this vector.
+  // if a migration throws, the new element is destroyed again and the vector is unchanged.
+  void push_back(const Tp &value) {
+    if(_size == _capacity) grow();
+    if(_size >= _back_ready) _back_ready = prefault(_size, _capacity);
+    new(_data + _size) Tp(value);
+    migrate_or_undo();
+    ++_size;
+  }
+  void push_back(Tp &&value) {
+    if(_size == _capacity) grow();
+    if(_size >= _back_ready) _back_ready = prefault(_size, _capacity);
+    new(_data + _size) Tp(std::move(value));
+    migrate_or_undo();
+    ++_size;
+  }
+  // throw container_is_empty if size == 0
+  void pop_back() {
+    if(empty())
+      throw container_is_empty{};
+    --_size;
+    address(_size)->~Tp();
+    if(_old == nullptr || _size >= _split) return;
+    // the last old element is gone.
+    _split = _size;
+    if(_migrated > _split) _migrated = _split;
+    if(_migrated == _split) free_old();
+  }
+  // all zero with no_stats.
+  container_stats stats() const {
+    return snapshot_stats();
+  }
+  void reset_stats() {
+    clear_stats();
+  }
+
+private:
+  // the old elements migrated by every push_back. the migration of c elements ends
+  // after c / 2 pushes, while the new buffer has room for c more.
+  static constexpr size_t kMigrationStep = 2;
+  // the pages faulted in or released at once. a buffer smaller than this comes from
+  // operator new, whose memory the allocator has touched already, and is left alone.
+  static constexpr size_t kChunkBytes = size_t(256) << 10;
+
+  // while migrating, [0, _migrated) and [_split, _size) are in _data and [_migrated, _split) in _old.
+  Tp* address(size_t index) const {
+    if(_old != nullptr && index >= _migrated && index < _split) return _old + index;
+    return _data + index;
+  }
+  // starts a migration into a buffer twice as large. nothing is moved yet.
+  void grow() {
+    finish_migration();
+    Tp *new_data = allocate(_capacity == 0 ? 16 : _capacity * 2);
+    if(_data != nullptr && _size != 0) {
+      count_reallocation();
+      _old = _data;
+      _migrated = 0;
+      _split = _size;
+    } else {
+      deallocate(_data, _capacity);
+    }
+    _data = new_data;
+    _capacity = _capacity == 0 ? 16 : _capacity * 2;
+    _front_ready = small(_capacity) ? _capacity : 0;
+    _back_ready = small(_capacity) ? _capacity : _size;
+  }
+  void migrate(size_t count) {
+    for(; count != 0 && _old != nullptr; --count) {
+      if(_migrated >= _front_ready) _front_ready = prefault(_migrated, _split);
+      new(_data + _migrated) Tp(std::move_if_noexcept(_old[_migrated]));
+      _old[_migrated].~Tp();
+      count_moves(1);
+      if(++_migrated == _split) free_old();
+      else if(_migrated * sizeof(Tp) - _released_bytes >= kChunkBytes) release_migrated();
+    }
+  }
+  // the element at _size has just been constructed.
+  void migrate_or_undo() {
+    try {
+      migrate(kMigrationStep);
+    } catch(...) {
+      _data[_size].~Tp();
+      throw;
+    }
+  }
+  void finish_migration() {
+    if(_old != nullptr) migrate(_split - _migrated);
+  }
+  // the old buffer should hold no element. it is always half as large as the current one.
+  void free_old() {
+    deallocate(_old, _capacity / 2);
+    _old = nullptr;
+    _migrated = _split = _released_bytes = 0;
+  }
+  static bool small(size_t capacity) {
+    return capacity * sizeof(Tp) < kChunkBytes;
+  }
+  static size_t page_size() {
+#ifdef __linux__
+    static const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    return page;
+#else
+    return 4096;
+#endif
+  }
+  // faults in the pages of _data from index on, up to a chunk but not past limit,
+  // in one call instead of a page fault every few pushes. returns where it stopped.
+  // only called on a mapped buffer; elsewhere, and on kernels older than 5.14,
+  // the pages are left to fault in on their own.
+  size_t prefault(size_t index, size_t limit) {
+    size_t end = index + (kChunkBytes / sizeof(Tp) == 0 ? 1 : kChunkBytes / sizeof(Tp));
+    if(end > limit) end = limit;
+#if defined(__linux__) && defined(MADV_POPULATE_WRITE)
+    char *first = reinterpret_cast<char*>(_data + index), *last = reinterpret_cast<char*>(_data + end);
+    std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(first) & ~(page_size() - 1);
+    // whole pages are populated, but their contents are kept.
+    ::madvise(reinterpret_cast<void*>(begin), last - reinterpret_cast<char*>(begin), MADV_POPULATE_WRITE);
+#endif
+    return end;
+  }
+  // gives the whole pages of the old buffer below _migrated back to the kernel,
+  // so that freeing it at the end of the migration is cheap.
+  // only called on a mapped buffer, whose pages are not shared with anything else.
+  void release_migrated() {
+    std::uintptr_t page = page_size(), base = reinterpret_cast<std::uintptr_t>(_old);
+    std::uintptr_t begin = (base + _released_bytes + page - 1) & ~(page - 1);
+    std::uintptr_t end = (base + _migrated * sizeof(Tp)) & ~(page - 1);
+    if(begin >= end) return;
+#if defined(__linux__) && defined(MADV_DONTNEED)
+    ::madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+#endif
+    _released_bytes = end - base;
+  }
+  // takes the buffers of other, which is left empty without a buffer.
+  void take(deamortized_vector &other) {
+    _data = other._data;
+    _old = other._old;
+    _size = other._size;
+    _capacity = other._capacity;
+    _migrated = other._migrated;
+    _split = other._split;
+    _front_ready = other._front_ready;
+    _back_ready = other._back_ready;
+    _released_bytes = other._released_bytes;
+    other._data = other._old = nullptr;
+    other._size = other._capacity = other._migrated = other._split = 0;
+    other._front_ready = other._back_ready = other._released_bytes = 0;
+  }
+  // a buffer that isn't small is mapped on its own on linux, page-aligned,
+  // so that prefault and release_migrated may madvise its pages.
+  static bool mapped(size_t capacity) {
+#ifdef __linux__
+    return !small(capacity);
+#else
+    (void)capacity;
+    return false;
+#endif
+  }
+  // the only place that deamortized_vector gets or returns raw memory.
+  Tp* allocate(const size_t &capacity) {
+    count_allocation(capacity * sizeof(Tp));
+#ifdef __linux__
+    if(mapped(capacity)) {
+      void *p = ::mmap(nullptr, capacity * sizeof(Tp), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if(p == MAP_FAILED)
+        throw std::bad_alloc();
+      return static_cast<Tp*>(p);
+    }
+#endif
+    return static_cast<Tp*>(operator new(capacity * sizeof(Tp)));
+  }
+  // capacity is the one data was allocated with.
+  void deallocate(Tp *data, size_t capacity) {
+    if(data == nullptr) return;
+    count_deallocation();
+#ifdef __linux__
+    if(mapped(capacity)) {
+      ::munmap(data, capacity * sizeof(Tp));
+      return;
+    }
+#endif
+    operator delete(data);
+  }
+
+  // the current buffer, of _capacity elements.
+  Tp *_data;
+  // the previous buffer while a migration is going on, or nullptr.
+  Tp *_old;
+  size_t _size, _capacity;
+  size_t _migrated, _split;
+  // [.., _front_ready) and [.., _back_ready) of _data are faulted in, ahead of the migration
+  // and of push_back. the first _released_bytes of _old are given back already.
+  size_t _front_ready, _back_ready, _released_bytes;
+};
+
+}
+
+#endif
@@ -0,0 +1,544 @@
+#ifndef SJTU_GAP_BUFFER_HPP
+#define SJTU_GAP_BUFFER_HPP
+
+#include "exceptions.hpp"
+#include "stats.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace sjtu {
+
+/**
+ * a vector with a gap of free slots that follows the edits, as in a text editor.
+ * the elements are kept in one buffer as [0, gap) and [gap + gap_size, capacity),
+ * so an element is still found in O(1) from its index.
+ * an insertion or erasure first moves the gap to its position, shifting only the elements
+ * between the old and the new position, and then takes or gives one slot at the gap.
+ * the gap is only moved by edits, so a run of edits around a cursor costs O(1) each
+ * plus the distance the cursor travels, while vector pays for all elements after the position.
+ * push_back is an insertion at the end, so it moves the gap there first.
+ * every edit may move elements, which invalidates references to them.
+ */
+template <class Tp, class Stats = no_stats>
+class gap_buffer : private Stats {
+  // the Stats policy is a dependent base, so its calls are brought in by name.
+  using Stats::count_allocation;
+  using Stats::count_deallocation;
+  using Stats::count_reallocation;
+  using Stats::count_moves;
+  using Stats::snapshot_stats;
+  using Stats::clear_stats;
+public:
+  class const_iterator;
+  class iterator {
+    friend gap_buffer;
+    friend const_iterator;
+
+  public:
+    using differnce_type = std::ptrdiff_t;
+    using value_type = Tp;
+    using pointer = Tp*;
+    using reference = Tp&;
+    using iterator_category = std::output_iterator_tag;
+
+    iterator(): _container(nullptr), _index(0) {}
+    iterator(const iterator &) = default;
+    iterator& operator=(const iterator &) = default;
+    iterator operator+(const differnce_type &diff) const {
+      iterator res = *this;
+      return res += diff;
+    }
+    iterator operator-(const differnce_type &diff) const {
+      iterator res = *this;
+      return res -= diff;
+    }
+    // throw invalid_iterator if two containers are not same
+    differnce_type operator-(const iterator &other) const {
+      if(_container != other._container)
+        throw invalid_iterator{};
+      return static_cast<differnce_type>(_index) - static_cast<differnce_type>(other._index);
+    }
+    iterator& operator+=(const differnce_type &diff) {
+      if(diff < 0) return *this -= -diff;
+      if(_index + diff > _container->size())
+        throw index_out_of_bound{};
+      _index += diff;
+      return *this;
+    }
+    iterator& operator-=(const differnce_type &diff) {
+      if(diff < 0) return *this += -diff;
+      if(_index < static_cast<size_t>(diff))
+        throw index_out_of_bound{};
+      _index -= diff;
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator tmp = *this;
+      *this += 1;
+      return tmp;
+    }
+    iterator& operator++() {
+      return *this += 1;
+    }
+    iterator operator--(int) {
+      iterator tmp = *this;
+      *this -= 1;
+      return tmp;
+    }
+    iterator& operator--() {
+      return *this -= 1;
+    }
+    Tp& operator*() const {
+      return *_container->address(_index);
+    }
+    Tp* operator->() const {
+      return _container->address(_index);
+    }
+    bool operator==(const iterator &other) const {
+      return _container == other._container && _index == other._index;
+    }
+    bool operator==(const const_iterator &other) const {
+      return _container == other._container && _index == other._index;
+    }
+    bool operator!=(const iterator &other) const {
+      return !(*this == other);
+    }
+    bool operator!=(const const_iterator &other) const {
+      return !(*this == other);
+    }
+
+  private:
+    const gap_buffer *_container;
+    size_t _index;
+    iterator(const gap_buffer *container, const size_t &index): _container(container), _index(index) {}
+  };
+  class const_iterator {
+    friend gap_buffer;
+    friend iterator;
+
+  public:
+    using differnce_type = std::ptrdiff_t;
+    using value_type = Tp;
+    using pointer = const Tp*;
+    using reference = const Tp&;
+    using iterator_category = std::output_iterator_tag;
+
+    const_iterator(): _container(nullptr), _index(0) {}
+    const_iterator(const const_iterator &) = default;
+    const_iterator(const iterator &other): _container(other._container), _index(other._index) {}
+    const_iterator& operator=(const const_iterator &) = default;
+    const_iterator operator+(const differnce_type &diff) const {
+      const_iterator res = *this;
+      return res += diff;
+    }
+    const_iterator operator-(const differnce_type &diff) const {
+      const_iterator res = *this;
+      return res -= diff;
+    }
+    // throw invalid_iterator if two containers are not same
+    differnce_type operator-(const const_iterator &other) const {
+      if(_container != other._container)
+        throw invalid_iterator{};
+      return static_cast<differnce_type>(_index) - static_cast<differnce_type>(other._index);
+    }
+    const_iterator& operator+=(const differnce_type &diff) {
+      if(diff < 0) return *this -= -diff;
+      if(_index + diff > _container->size())
+        throw index_out_of_bound{};
+      _index += diff;
+      return *this;
+    }
+    const_iterator& operator-=(const differnce_type &diff) {
+      if(diff < 0) return *this += -diff;
+      if(_index < static_cast<size_t>(diff))
+        throw index_out_of_bound{};
+      _index -= diff;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator tmp = *this;
+      *this += 1;
+      return tmp;
+    }
+    const_iterator& operator++() {
+      return *this += 1;
+    }
+    const_iterator operator--(int) {
+      const_iterator tmp = *this;
+      *this -= 1;
+      return tmp;
+    }
+    const_iterator& operator--() {
+      return *this -= 1;
+    }
+    const Tp& operator*() const {
+      return *_container->address(_index);
+    }
+    const Tp* operator->() const {
+      return _container->address(_index);
+    }
+    bool operator==(const const_iterator &other) const {
+      return _container == other._container && _index == other._index;
+    }
+    bool operator==(const iterator &other) const {
+      return _container == other._container && _index == other._index;
+    }
+    bool operator!=(const const_iterator &other) const {
+      return !(*this == other);
+    }
+    bool operator!=(const iterator &other) const {
+      return !(*this == other);
+    }
+
+  private:
+    const gap_buffer *_container;
+    size_t _index;
+    const_iterator(const gap_buffer *container, const size_t &index): _container(container), _index(index) {}
+  };
+
+  gap_buffer(): _data(nullptr), _gap_begin(0), _gap_end(0), _capacity(0) {}
+  // if a copy throws, the destructor cleans up the elements copied so far.
+  gap_buffer(const gap_buffer &other): gap_buffer() {
+    reserve(other.size());
+    for(size_t i = 0; i < other.size(); ++i) {
+      new(_data + _gap_begin) Tp(*other.address(i));
+      ++_gap_begin;
+    }
+  }
+  gap_buffer(gap_buffer &&other) noexcept: gap_buffer() {
+    take(other);
+  }
+  ~gap_buffer() {
+    clear();
+    deallocate(_data);
+  }
+  gap_buffer& operator=(const gap_buffer &other) {
+    if(this == &other) return *this;
+    clear();
+    reserve(other.size());
+    for(size_t i = 0; i < other.size(); ++i) {
+      new(_data + _gap_begin) Tp(*other.address(i));
+      ++_gap_begin;
+    }
+    return *this;
+  }
+  gap_buffer& operator=(gap_buffer &&other) noexcept {
+    if(this == &other) return *this;
+    clear();
+    deallocate(_data);
+    _data = nullptr;
+    _gap_begin = _gap_end = _capacity = 0;
+    take(other);
+    return *this;
+  }
+
+  // throw index_out_of_bound if pos is not in [0, size)
+  Tp& at(const size_t &pos) {
+    if(pos >= size())
+      throw index_out_of_bound{};
+    return *address(pos);
+  }
+  // throw index_out_of_bound if pos is not in [0, size)
+  const Tp& at(const size_t &pos) const {
+    if(pos >= size())
+      throw index_out_of_bound{};
+    return *address(pos);
+  }
+  // throw index_out_of_bound if pos is not in [0, size)
+  Tp& operator[](const size_t &pos) {
+    return at(pos);
+  }
+  // throw index_out_of_bound if pos is not in [0, size)
+  const Tp& operator[](const size_t &pos) const {
+    return at(pos);
+  }
+  // throw container_is_empty if size is 0
+  const Tp& front() const {
+    if(empty())
+      throw container_is_empty{};
+    return *address(0);
+  }
+  // throw container_is_empty if size is 0
+  const Tp& back() const {
+    if(empty())
+      throw container_is_empty{};
+    return *address(size() - 1);
+  }
+  iterator begin() const {
+    return iterator{this, 0};
+  }
+  iterator end() const {
+    return iterator{this, size()};
+  }
+  const_iterator cbegin() const {
+    return const_iterator{this, 0};
+  }
+  const_iterator cend() const {
+    return const_iterator{this, size()};
+  }
+  bool empty() const {
+    return size() == 0;
+  }
+  size_t size() const {
+    return _capacity - (_gap_end - _gap_begin);
+  }
+  size_t capacity() const {
+    return _capacity;
+  }
+  // the index the gap is at: the next insertion there doesn't move anything.
+  size_t gap() const {
+    return _gap_begin;
+  }
+  // destroys the elements but keeps the buffer; the gap takes all of it.
+  void clear() {
+    for(size_t i = 0; i < _gap_begin; ++i)
+      _data[i].~Tp();
+    for(size_t i = _gap_end; i < _capacity; ++i)
+      _data[i].~Tp();
+    _gap_begin = 0;
+    _gap_end = _capacity;
+  }
+  // the elements keep their sides of the gap, which gets the new room.
+  // if copying an element throws, the buffer is left unchanged.
+  void reserve(const size_t &capacity) {
+    if(_capacity >= capacity) return;
+    Tp *new_data = allocate(capacity);
+    size_t after = _capacity - _gap_end, new_gap_end = capacity - after;
+    size_t i = 0, j = 0;
+    try {
+      for(; i < _gap_begin; ++i)
+        new(new_data + i) Tp(std::move_if_noexcept(_data[i]));
+      for(; j < after; ++j)
+        new(new_data + new_gap_end + j) Tp(std::move_if_noexcept(_data[_gap_end + j]));
+    } catch(...) {
+      for(size_t k = 0; k < i; ++k)
+        new_data[k].~Tp();
+      for(size_t k = 0; k < j; ++k)
+        new_data[new_gap_end + k].~Tp();
+      deallocate(new_data);
+      throw;
+    }
+    for(size_t k = 0; k < _gap_begin; ++k)
+      _data[k].~Tp();
+    for(size_t k = _gap_end; k < _capacity; ++k)
+      _data[k].~Tp();
+    if(_data != nullptr) {
+      count_reallocation();
+      count_moves(size());
+    }
+    deallocate(_data);
+    _data = new_data;
+    _gap_end = new_gap_end;
+    _capacity = capacity;
+  }
+  // throw invalid_iterator if iter is not valid
+  // throw index_out_of_bound if iter has an index > size
+  iterator insert(const iterator &iter, const Tp &value) {
+    if(iter._container != this)
+      throw invalid_iterator{};
+    return insert(iter._index, value);
+  }
+  // throw index_out_of_bound if index > size
+  iterator insert(const size_t &index, const Tp &value) {
+    if(index > size())
+      throw index_out_of_bound{};
+    // value may be an element of this buffer, so it's copied before anything moves.
+    Tp copy(value);
+    if(_gap_begin == _gap_end)
+      reserve((_capacity + 1) * 2);
+    move_gap(index);
+    new(_data + _gap_begin) Tp(std::move(copy));
+    ++_gap_begin;
+    return iterator{this, index};
+  }
+  // throw invalid_iterator if iter is not valid
+  // throw index_out_of_bound if iter has an index >= size
+  iterator erase(const iterator &iter) {
+    if(iter._container != this)
+      throw invalid_iterator{};
+    return erase(iter._index);
+  }
+  // throw index_out_of_bound if index >= size
+  iterator erase(const size_t &index) {
+    if(index >= size())
+      throw index_out_of_bound{};
+    move_gap(index);
+    _data[_gap_end].~Tp();
+    ++_gap_end;
+    return iterator{this, index};
+  }
+  void push_back(const Tp &value) {
+    insert(size(), value);
+  }
+  void push_back(Tp &&value) {
+    // moved into a local first, as the buffer may grow.
+    Tp copy(std::move(value));
+    if(_gap_begin == _gap_end)
+      reserve((_capacity + 1) * 2);
+    move_gap(size());
+    new(_data + _gap_begin) Tp(std::move(copy));
+    ++_gap_begin;
+  }
+  // throw container_is_empty if size == 0
+  void pop_back() {
+    if(empty())
+      throw container_is_empty{};
+    erase(size() - 1);
+  }
+  // all zero with no_stats.
+  container_stats stats() const {
+    return snapshot_stats();
+  }
+  void reset_stats() {
+    clear_stats();
+  }
+
+private:
+  Tp* address(size_t index) const {
+    return _data + (index < _gap_begin ? index : index + (_gap_end - _gap_begin));
+  }
+  // moves the gap to index, shifting the elements in between across it.
+  void move_gap(size_t index) {
+    if(_gap_begin == _gap_end) {
+      // an empty gap is anywhere already; shifting across it would move elements onto themselves.
+      _gap_begin = _gap_end = index;
+      return;
+    }
+    count_moves(index < _gap_begin ? _gap_begin - index : index - _gap_begin);
+    move_gap(index, std::is_trivially_copyable<Tp>());
+  }
+  void move_gap(size_t index, std::true_type) {
+    size_t gap_size = _gap_end - _gap_begin;
+    if(index < _gap_begin)
+      std::memmove(static_cast<void*>(_data + index + gap_size), _data + index, (_gap_begin - index) * sizeof(Tp));
+    else
+      std::memmove(static_cast<void*>(_data + _gap_begin), _data + _gap_end, (index - _gap_begin) * sizeof(Tp));
+    _gap_begin = index;
+    _gap_end = index + gap_size;
+  }
+  // the elements are only move-constructed into the raw slots of the gap and move-assigned
+  // over the moved-from elements beyond it, as vector::insert does.
+  // if a move throws, the gap stops where it got to, and every value is still in the buffer.
+  void move_gap(size_t index, std::false_type) {
+    size_t gap_begin = _gap_begin, gap_end = _gap_end, gap_size = gap_end - gap_begin;
+    if((index < gap_begin ? gap_begin - index : index - gap_begin) <= gap_size) {
+      relocate_across_gap(index);
+      return;
+    }
+    Tp *data = _data;
+    // the slot being filled, plus 1 when going from the back; the unwinding below relies on it.
+    size_t i;
+    try {
+      if(index < gap_begin) {
+        // [index, gap_begin) moves to [index + gap_size, gap_end), from the back.
+        for(i = gap_end; i > gap_begin; --i)
+          new(data + i - 1) Tp(std::move(data[i - 1 - gap_size]));
+        shift_back(data, index + gap_size, i, gap_size, std::is_trivially_move_assignable<Tp>());
+        for(size_t j = index; j < index + gap_size; ++j)
+          data[j].~Tp();
+      } else {
+        // [gap_end, index + gap_size) moves to [gap_begin, index), from the front.
+        for(i = gap_begin; i < gap_end; ++i)
+          new(data + i) Tp(std::move(data[i + gap_size]));
+        shift_front(data, i, index, gap_size, std::is_trivially_move_assignable<Tp>());
+        for(size_t j = index; j < index + gap_size; ++j)
+          data[j].~Tp();
+      }
+    } catch(...) {
+      // the moved-from elements the stopped gap covers are destroyed; its raw slots aren't.
+      if(index < gap_begin) {
+        for(size_t j = i - gap_size; j < i && j < gap_begin; ++j)
+          data[j].~Tp();
+        _gap_begin = i - gap_size;
+        _gap_end = i;
+      } else {
+        for(size_t j = i > gap_end ? i : gap_end; j < i + gap_size; ++j)
+          data[j].~Tp();
+        _gap_begin = i;
+        _gap_end = i + gap_size;
+      }
+      throw;
+    }
+    _gap_begin = index;
+    _gap_end = index + gap_size;
+  }
+  // when the gap is at least as wide as the shift, every element lands in a raw slot.
+  // each one is moved and its old slot destroyed in turn, which keeps the allocations
+  // of elements like Matrix recycled, and every step leaves a valid buffer.
+  void relocate_across_gap(size_t index) {
+    size_t gap_size = _gap_end - _gap_begin, i = _gap_begin;
+    Tp *data = _data;
+    try {
+      for(; i > index; --i) {
+        new(data + i - 1 + gap_size) Tp(std::move(data[i - 1]));
+        data[i - 1].~Tp();
+      }
+      for(; i < index; ++i) {
+        new(data + i) Tp(std::move(data[i + gap_size]));
+        data[i + gap_size].~Tp();
+      }
+    } catch(...) {
+      _gap_begin = i;
+      _gap_end = i + gap_size;
+      throw;
+    }
+    _gap_begin = i;
+    _gap_end = i + gap_size;
+  }
+
+  // data[j] = std::move(data[j - distance]) for j from i - 1 down to stop, leaving i at stop.
+  // if an assignment throws, i is one past the slot being assigned to, like a loop index.
+  // a trivial assignment copies bytes, so a memmove does the same; the compiler won't emit
+  // one by itself for a distance only known at run time.
+  static void shift_back(Tp *data, size_t stop, size_t &i, size_t distance, std::true_type) {
+    if(stop < i) std::memmove(static_cast<void*>(data + stop), data + stop - distance, (i - stop) * sizeof(Tp));
+    i = stop;
+  }
+  static void shift_back(Tp *data, size_t stop, size_t &i, size_t distance, std::false_type) {
+    for(; i > stop; --i)
+      data[i - 1] = std::move(data[i - 1 - distance]);
+  }
+  // data[j] = std::move(data[j + distance]) for j from i up to stop, leaving i at stop.
+  static void shift_front(Tp *data, size_t &i, size_t stop, size_t distance, std::true_type) {
+    if(i < stop) std::memmove(static_cast<void*>(data + i), data + i + distance, (stop - i) * sizeof(Tp));
+    i = stop;
+  }
+  static void shift_front(Tp *data, size_t &i, size_t stop, size_t distance, std::false_type) {
+    for(; i < stop; ++i)
+      data[i] = std::move(data[i + distance]);
+  }
+
+  // takes the buffer of other, which is left empty without a buffer.
+  void take(gap_buffer &other) {
+    _data = other._data;
+    _gap_begin = other._gap_begin;
+    _gap_end = other._gap_end;
+    _capacity = other._capacity;
+    other._data = nullptr;
+    other._gap_begin = other._gap_end = other._capacity = 0;
+  }
+  // the only place that gap_buffer gets or returns raw memory.
+  Tp* allocate(const size_t &capacity) {
+    count_allocation(capacity * sizeof(Tp));
+    return static_cast<Tp*>(operator new(capacity * sizeof(Tp)));
+  }
+  void deallocate(Tp *data) {
+    if(data == nullptr) return;
+    count_deallocation();
+    operator delete(data);
+  }
+
+  Tp *_data;
+  // the free slots are [_gap_begin, _gap_end).
+  size_t _gap_begin, _gap_end;
+  size_t _capacity;
+};
+
+}
+
+#endif
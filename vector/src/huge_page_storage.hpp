@@ -0,0 +1,98 @@
+#ifndef SJTU_HUGE_PAGE_STORAGE_HPP
+#define SJTU_HUGE_PAGE_STORAGE_HPP
+
+#include "vector.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include <sys/mman.h>
+
+namespace sjtu {
+
+namespace huge_page_detail {
+
+// the huge page size of x86-64 and most of aarch64 linux.
+static constexpr size_t kHugePage = size_t(2) << 20;
+
+inline size_t round_up(size_t bytes) {
+  if(bytes > SIZE_MAX - (kHugePage - 1))
+    throw std::bad_alloc();
+  return (bytes + kHugePage - 1) & ~(kHugePage - 1);
+}
+
+// anonymous memory of the given bytes, a multiple of kHugePage, aligned to kHugePage.
+// mmap only aligns to small pages, so one more huge page is mapped and the ends are trimmed.
+inline void* map_aligned(size_t bytes) {
+  void *raw = ::mmap(nullptr, bytes + kHugePage, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if(raw == MAP_FAILED)
+    throw std::bad_alloc();
+  std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(raw);
+  std::uintptr_t aligned = (begin + kHugePage - 1) & ~std::uintptr_t(kHugePage - 1);
+  if(aligned != begin) ::munmap(raw, aligned - begin);
+  ::munmap(reinterpret_cast<void*>(aligned + bytes), begin + kHugePage - aligned);
+  return reinterpret_cast<void*>(aligned);
+}
+
+inline void* map_transparent(size_t bytes) {
+  void *p = map_aligned(bytes);
+#ifdef MADV_HUGEPAGE
+  // a hint only; the kernel may still back the range with small pages.
+  ::madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+  return p;
+}
+
+}
+
+/**
+ * storage policies for vectors of many megabytes of data, which would otherwise take
+ * a TLB miss every 4 KB. a buffer of at least one huge page (2 MB) is mapped on its own,
+ * rounded up to whole huge pages; smaller ones come from aligned_heap_storage<64>.
+ * the elements start at a multiple of 64 bytes, as with aligned_heap_storage<64>.
+ * POSIX only; the huge pages themselves need linux.
+ */
+
+// hands the mapping to transparent huge pages with madvise(MADV_HUGEPAGE),
+// which takes effect when /sys/kernel/mm/transparent_hugepage/enabled is always or madvise.
+struct transparent_huge_page_storage {
+  static constexpr size_t data_alignment = 64;
+
+  static void* allocate(size_t bytes) {
+    if(bytes < huge_page_detail::kHugePage)
+      return aligned_heap_storage<64>::allocate(bytes);
+    return huge_page_detail::map_transparent(huge_page_detail::round_up(bytes));
+  }
+  static void deallocate(void *p, size_t bytes) {
+    if(bytes < huge_page_detail::kHugePage)
+      aligned_heap_storage<64>::deallocate(p, bytes);
+    else
+      ::munmap(p, huge_page_detail::round_up(bytes));
+  }
+};
+
+// maps from the pool of huge pages reserved in /proc/sys/vm/nr_hugepages (MAP_HUGETLB),
+// which are never split or swapped. when the pool is short, it falls back to
+// transparent_huge_page_storage.
+struct explicit_huge_page_storage {
+  static constexpr size_t data_alignment = 64;
+
+  static void* allocate(size_t bytes) {
+    if(bytes < huge_page_detail::kHugePage)
+      return aligned_heap_storage<64>::allocate(bytes);
+    size_t rounded = huge_page_detail::round_up(bytes);
+#ifdef MAP_HUGETLB
+    void *p = ::mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if(p != MAP_FAILED) return p;
+#endif
+    return huge_page_detail::map_transparent(rounded);
+  }
+  static void deallocate(void *p, size_t bytes) {
+    transparent_huge_page_storage::deallocate(p, bytes);
+  }
+};
+
+}
+
+#endif
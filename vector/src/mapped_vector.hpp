@@ -0,0 +1,136 @@
+#ifndef SJTU_MAPPED_VECTOR_HPP
+#define SJTU_MAPPED_VECTOR_HPP
+
+#include "exceptions.hpp"
+#include "vector.hpp"
+
+#include <cstddef>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sjtu {
+
+/**
+ * a read-only view of a file written by vector::save.
+ * the file is mapped into memory instead of being read, so opening it costs O(1),
+ * and the pages are loaded by the OS on first access.
+ * POSIX only.
+ */
+template <class Tp>
+class mapped_vector {
+  static_assert(std::is_trivially_copyable<Tp>::value, "only trivially copyable elements can be mapped");
+public:
+  typedef const Tp* iterator;
+  typedef const Tp* const_iterator;
+
+  // throw runtime_error if the file can't be mapped or holds another type.
+  explicit mapped_vector(const char *path): _map(nullptr), _map_size(0), _data(nullptr), _size(0) {
+    int fd = ::open(path, O_RDONLY);
+    if(fd < 0)
+      throw runtime_error{};
+    struct stat info;
+    if(::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(vector_file_header)) {
+      ::close(fd);
+      throw runtime_error{};
+    }
+    _map_size = info.st_size;
+    _map = ::mmap(nullptr, _map_size, PROT_READ, MAP_SHARED, fd, 0);
+    // the mapping stays valid after the descriptor is closed.
+    ::close(fd);
+    if(_map == MAP_FAILED)
+      throw runtime_error{};
+    const vector_file_header *header = static_cast<const vector_file_header*>(_map);
+    if(!header->matches(sizeof(Tp))
+      || header->count > (_map_size - sizeof(vector_file_header)) / sizeof(Tp)) {
+      ::munmap(_map, _map_size);
+      throw runtime_error{};
+    }
+    _size = header->count;
+    _data = reinterpret_cast<const Tp*>(static_cast<const char*>(_map) + sizeof(vector_file_header));
+    // a hint only; the data is read front to back most of the time.
+    ::madvise(_map, _map_size, MADV_SEQUENTIAL);
+  }
+  mapped_vector(const mapped_vector &) = delete;
+  mapped_vector(mapped_vector &&other) noexcept
+    : _map(other._map), _map_size(other._map_size), _data(other._data), _size(other._size) {
+    other._map = nullptr;
+    other._map_size = 0;
+    other._data = nullptr;
+    other._size = 0;
+  }
+  ~mapped_vector() {
+    if(_map != nullptr) ::munmap(_map, _map_size);
+  }
+  mapped_vector& operator=(const mapped_vector &) = delete;
+  mapped_vector& operator=(mapped_vector &&other) noexcept {
+    if(this == &other) return *this;
+    if(_map != nullptr) ::munmap(_map, _map_size);
+    _map = other._map;
+    _map_size = other._map_size;
+    _data = other._data;
+    _size = other._size;
+    other._map = nullptr;
+    other._map_size = 0;
+    other._data = nullptr;
+    other._size = 0;
+    return *this;
+  }
+
+  // throw index_out_of_bound if pos is not in [0, size)
+  const Tp& at(const size_t &pos) const {
+    if(pos >= _size)
+      throw index_out_of_bound{};
+    return _data[pos];
+  }
+  // throw index_out_of_bound if pos is not in [0, size)
+  const Tp& operator[](const size_t &pos) const {
+    return at(pos);
+  }
+  // throw container_is_empty if size is 0
+  const Tp& front() const {
+    if(empty())
+      throw container_is_empty{};
+    return _data[0];
+  }
+  // throw container_is_empty if size is 0
+  const Tp& back() const {
+    if(empty())
+      throw container_is_empty{};
+    return _data[_size - 1];
+  }
+  const Tp* data() const {
+    return _data;
+  }
+  const_iterator begin() const {
+    return _data;
+  }
+  const_iterator end() const {
+    return _data + _size;
+  }
+  const_iterator cbegin() const {
+    return begin();
+  }
+  const_iterator cend() const {
+    return end();
+  }
+  bool empty() const {
+    return _size == 0;
+  }
+  size_t size() const {
+    return _size;
+  }
+
+private:
+  void *_map;
+  size_t _map_size;
+  const Tp *_data;
+  size_t _size;
+};
+
+}
+
+#endif
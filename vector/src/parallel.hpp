@@ -0,0 +1,321 @@
+#ifndef SJTU_PARALLEL_HPP
+#define SJTU_PARALLEL_HPP
+
+#include "exceptions.hpp"
+#include "vector.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sjtu {
+
+/**
+ * a fork-join thread pool with work stealing.
+ * every worker has its own task queue: it runs its newest task first,
+ * and when it runs out, it steals the oldest task of another queue.
+ * tasks submitted from outside the pool go to one more shared queue.
+ * a thread waiting for a task_group runs tasks meanwhile instead of blocking,
+ * so tasks may fork and wait for more tasks, and a pool with 0 workers
+ * runs everything on the waiting thread.
+ */
+class thread_pool {
+public:
+  // the workers besides the calling thread; by default one per core.
+  explicit thread_pool(size_t workers = default_workers()): stopping_(false), queued_(0) {
+    for(size_t i = 0; i <= workers; ++i)
+      queues_.emplace_back(new task_queue);
+    try {
+      for(size_t i = 0; i < workers; ++i)
+        threads_.emplace_back(&thread_pool::work, this, i);
+    } catch(...) {
+      stop();
+      throw;
+    }
+  }
+  thread_pool(const thread_pool &) = delete;
+  thread_pool& operator=(const thread_pool &) = delete;
+  // the tasks left are dropped, so every task_group should be waited for first.
+  ~thread_pool() {
+    stop();
+  }
+
+  // how many threads work on a task_group: the workers and the waiting thread.
+  size_t concurrency() const {
+    return threads_.size() + 1;
+  }
+  // the pool shared by the algorithms below unless they are given one.
+  static thread_pool& instance() {
+    static thread_pool pool;
+    return pool;
+  }
+  static size_t default_workers() {
+    size_t cores = std::thread::hardware_concurrency();
+    return cores > 1 ? cores - 1 : 0;
+  }
+
+  // the tasks forked by one computation, which are all waited for at once.
+  class task_group {
+  public:
+    explicit task_group(thread_pool &pool): pool_(pool), pending_(0) {}
+    task_group(const task_group &) = delete;
+    task_group& operator=(const task_group &) = delete;
+    ~task_group() {
+      // a task may still refer to this group.
+      while(pending_.load() != 0)
+        if(!pool_.run_one()) std::this_thread::yield();
+    }
+
+    template<class F>
+    void run(F &&f) {
+      pending_.fetch_add(1);
+      try {
+        pool_.submit([this, f]() mutable {
+          try {
+            f();
+          } catch(...) {
+            std::lock_guard<std::mutex> lock(error_lock_);
+            if(!error_) error_ = std::current_exception();
+          }
+          pending_.fetch_sub(1);
+        });
+      } catch(...) {
+        pending_.fetch_sub(1);
+        throw;
+      }
+    }
+    // runs tasks until every task of the group is done.
+    // the first exception thrown by a task is rethrown here.
+    void wait() {
+      while(pending_.load() != 0)
+        if(!pool_.run_one()) std::this_thread::yield();
+      if(error_) {
+        std::exception_ptr error = error_;
+        error_ = nullptr;
+        std::rethrow_exception(error);
+      }
+    }
+
+  private:
+    thread_pool &pool_;
+    std::atomic<size_t> pending_;
+    std::mutex error_lock_;
+    std::exception_ptr error_;
+  };
+
+private:
+  struct task_queue {
+    std::mutex lock;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  // which queue of which pool the current thread owns; the shared queue for outsiders.
+  static const thread_pool*& current_pool() {
+    static thread_local const thread_pool *pool = nullptr;
+    return pool;
+  }
+  static size_t& current_index() {
+    static thread_local size_t index = 0;
+    return index;
+  }
+  size_t own_index() const {
+    return current_pool() == this ? current_index() : queues_.size() - 1;
+  }
+
+  void submit(std::function<void()> task) {
+    task_queue &queue = *queues_[own_index()];
+    {
+      std::lock_guard<std::mutex> lock(queue.lock);
+      queue.tasks.push_back(std::move(task));
+    }
+    {
+      // taken so that a worker going to sleep can't miss the task.
+      std::lock_guard<std::mutex> lock(sleep_lock_);
+      ++queued_;
+    }
+    wake_.notify_one();
+  }
+  // runs the newest task of its own queue, or else steals the oldest of another one.
+  bool run_one() {
+    size_t self = own_index(), count = queues_.size();
+    std::function<void()> task;
+    for(size_t i = 0; i < count && !task; ++i) {
+      task_queue &queue = *queues_[(self + i) % count];
+      std::lock_guard<std::mutex> lock(queue.lock);
+      if(queue.tasks.empty()) continue;
+      if(i == 0) {
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+      } else {
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+      }
+    }
+    if(!task) return false;
+    {
+      std::lock_guard<std::mutex> lock(sleep_lock_);
+      --queued_;
+    }
+    task();
+    return true;
+  }
+  void work(size_t index) {
+    current_pool() = this;
+    current_index() = index;
+    while(true) {
+      if(run_one()) continue;
+      std::unique_lock<std::mutex> lock(sleep_lock_);
+      wake_.wait(lock, [this] { return stopping_ || queued_ != 0; });
+      if(stopping_) return;
+    }
+  }
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(sleep_lock_);
+      stopping_ = true;
+    }
+    wake_.notify_all();
+    for(std::thread &thread : threads_)
+      thread.join();
+    threads_.clear();
+  }
+
+  std::vector<std::unique_ptr<task_queue>> queues_;
+  std::vector<std::thread> threads_;
+  std::mutex sleep_lock_;
+  std::condition_variable wake_;
+  bool stopping_;
+  size_t queued_;
+};
+
+namespace parallel_detail {
+
+// a range smaller than this is not split any further.
+static constexpr size_t kGrain = 1 << 12;
+static constexpr size_t kSortGrain = 1 << 14;
+
+// a few pieces per thread, so that stealing can even out uneven ones.
+inline size_t piece_count(const thread_pool &pool, size_t n) {
+  return std::min((n + kGrain - 1) / kGrain, pool.concurrency() * 4);
+}
+// piece i of n elements split into pieces parts as evenly as possible.
+inline size_t piece_begin(size_t n, size_t pieces, size_t i) {
+  return n / pieces * i + std::min(i, n % pieces);
+}
+
+// calls body(i) for every i in [0, pieces), each as a task.
+template<class Body>
+void for_pieces(thread_pool &pool, size_t pieces, const Body &body) {
+  if(pieces <= 1) {
+    if(pieces == 1) body(size_t(0));
+    return;
+  }
+  thread_pool::task_group group(pool);
+  for(size_t i = 0; i < pieces; ++i)
+    group.run([&body, i] { body(i); });
+  group.wait();
+}
+
+// calls body(begin, end) on pieces covering [0, n).
+template<class Body>
+void for_ranges(thread_pool &pool, size_t n, const Body &body) {
+  size_t pieces = piece_count(pool, n);
+  for_pieces(pool, pieces, [&](size_t i) {
+    body(piece_begin(n, pieces, i), piece_begin(n, pieces, i + 1));
+  });
+}
+
+// quicksort whose left parts become tasks. too deep a recursion falls back to std::sort,
+// which is O(nlogn) in the worst case.
+template<class Tp, class Compare>
+void sort_range(thread_pool::task_group &group, Tp *first, Tp *last, const Compare &comp, size_t depth) {
+  while(static_cast<size_t>(last - first) > kSortGrain && depth != 0) {
+    --depth;
+    Tp *mid = first + (last - first) / 2, *back = last - 1;
+    // the median of three.
+    const Tp *pivot_ptr = comp(*first, *mid)
+      ? (comp(*mid, *back) ? mid : (comp(*first, *back) ? back : first))
+      : (comp(*first, *back) ? first : (comp(*mid, *back) ? back : mid));
+    Tp pivot(*pivot_ptr);
+    // [first, lower) < pivot, [lower, upper) == pivot, [upper, last) > pivot.
+    Tp *lower = std::partition(first, last, [&](const Tp &x) { return comp(x, pivot); });
+    Tp *upper = std::partition(lower, last, [&](const Tp &x) { return !comp(pivot, x); });
+    group.run([&group, first, lower, &comp, depth] { sort_range(group, first, lower, comp, depth); });
+    first = upper;
+  }
+  std::sort(first, last, comp);
+}
+
+}
+
+/**
+ * bulk algorithms over the contiguous elements of a vector, split among the threads of a pool.
+ * they work on data() directly, so they skip the checks of vector::iterator.
+ * the functions are called concurrently on different elements, so they shouldn't share unsynchronized state.
+ */
+
+// sorts v by comp. it isn't stable.
+template<class Tp, class Storage, class Stats, class Compare = std::less<Tp>>
+void parallel_sort(vector<Tp, Storage, Stats> &v, const Compare &comp = Compare(), thread_pool &pool = thread_pool::instance()) {
+  size_t depth = 0;
+  for(size_t n = v.size(); n > 1; n >>= 1) depth += 2;
+  thread_pool::task_group group(pool);
+  parallel_detail::sort_range(group, v.data(), v.data() + v.size(), comp, depth);
+  group.wait();
+}
+
+// calls f on every element, in no particular order.
+template<class Tp, class Storage, class Stats, class F>
+void parallel_for_each(vector<Tp, Storage, Stats> &v, const F &f, thread_pool &pool = thread_pool::instance()) {
+  Tp *data = v.data();
+  parallel_detail::for_ranges(pool, v.size(), [data, &f](size_t begin, size_t end) {
+    for(size_t i = begin; i < end; ++i) f(data[i]);
+  });
+}
+
+// out[i] = f(in[i]) for every i. in and out may be the same vector.
+// throw index_out_of_bound if their sizes differ.
+template<class Tp, class InStorage, class InStats, class Up, class OutStorage, class OutStats, class F>
+void transform(const vector<Tp, InStorage, InStats> &in, vector<Up, OutStorage, OutStats> &out, const F &f, thread_pool &pool = thread_pool::instance()) {
+  if(in.size() != out.size())
+    throw index_out_of_bound{};
+  const Tp *src = in.data();
+  Up *dst = out.data();
+  parallel_detail::for_ranges(pool, in.size(), [src, dst, &f](size_t begin, size_t end) {
+    for(size_t i = begin; i < end; ++i) dst[i] = f(src[i]);
+  });
+}
+
+// folds the elements into init with op, which should be associative.
+// the elements are combined in order, but grouped differently from a serial loop.
+template<class Tp, class Storage, class Stats, class T, class BinaryOp = std::plus<T>>
+T reduce(const vector<Tp, Storage, Stats> &v, T init, const BinaryOp &op = BinaryOp(), thread_pool &pool = thread_pool::instance()) {
+  size_t n = v.size();
+  if(n == 0) return init;
+  const Tp *data = v.data();
+  // each piece is folded from its first element, and the sums are folded into init in order.
+  size_t pieces = parallel_detail::piece_count(pool, n);
+  std::vector<std::unique_ptr<T>> sums(pieces);
+  parallel_detail::for_pieces(pool, pieces, [&](size_t piece) {
+    size_t first = parallel_detail::piece_begin(n, pieces, piece);
+    size_t last = parallel_detail::piece_begin(n, pieces, piece + 1);
+    T sum(data[first]);
+    for(size_t i = first + 1; i < last; ++i) sum = op(sum, data[i]);
+    sums[piece].reset(new T(std::move(sum)));
+  });
+  for(size_t i = 0; i < pieces; ++i) init = op(init, *sums[i]);
+  return init;
+}
+
+}
+
+#endif
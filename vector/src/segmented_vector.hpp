@@ -0,0 +1,428 @@
+#ifndef SJTU_SEGMENTED_VECTOR_HPP
+#define SJTU_SEGMENTED_VECTOR_HPP
+
+#include "exceptions.hpp"
+#include "stats.hpp"
+
+#include <climits>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <utility>
+
+namespace sjtu {
+
+/**
+ * a vector whose elements never move once they are constructed.
+ * the elements live in segments of doubling sizes: segment k holds 16 * 2^k elements,
+ * so the first k segments hold 16 * (2^k - 1). growing allocates one more segment
+ * instead of moving everything into a larger buffer, so push_back takes O(1) in the worst case,
+ * needs no memory beyond the new segment, and keeps references to the elements valid.
+ * indexing finds the segment from the highest bit of the index, which is O(1).
+ * the elements aren't contiguous, so there is no data().
+ * insertion and erasure in the middle shift the elements after the position one slot,
+ * by assignment: references stay valid, but refer to the shifted values.
+ */
+template <class Tp, class Stats = no_stats>
+class segmented_vector : private Stats {
+  // the Stats policy is a dependent base, so its calls are brought in by name.
+  using Stats::count_allocation;
+  using Stats::count_deallocation;
+  using Stats::count_moves;
+  using Stats::snapshot_stats;
+  using Stats::clear_stats;
+public:
+  class const_iterator;
+  class iterator {
+    friend segmented_vector;
+    friend const_iterator;
+
+  public:
+    using differnce_type = std::ptrdiff_t;
+    using value_type = Tp;
+    using pointer = Tp*;
+    using reference = Tp&;
+    using iterator_category = std::output_iterator_tag;
+
+    iterator(): _container(nullptr), _index(0) {}
+    iterator(const iterator &) = default;
+    iterator& operator=(const iterator &) = default;
+    iterator operator+(const differnce_type &diff) const {
+      iterator res = *this;
+      return res += diff;
+    }
+    iterator operator-(const differnce_type &diff) const {
+      iterator res = *this;
+      return res -= diff;
+    }
+    // throw invalid_iterator if two containers are not same
+    differnce_type operator-(const iterator &other) const {
+      if(_container != other._container)
+        throw invalid_iterator{};
+      return static_cast<differnce_type>(_index) - static_cast<differnce_type>(other._index);
+    }
+    iterator& operator+=(const differnce_type &diff) {
+      if(diff < 0) return *this -= -diff;
+      if(_index + diff > _container->size())
+        throw index_out_of_bound{};
+      _index += diff;
+      return *this;
+    }
+    iterator& operator-=(const differnce_type &diff) {
+      if(diff < 0) return *this += -diff;
+      if(_index < static_cast<size_t>(diff))
+        throw index_out_of_bound{};
+      _index -= diff;
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator tmp = *this;
+      *this += 1;
+      return tmp;
+    }
+    iterator& operator++() {
+      return *this += 1;
+    }
+    iterator operator--(int) {
+      iterator tmp = *this;
+      *this -= 1;
+      return tmp;
+    }
+    iterator& operator--() {
+      return *this -= 1;
+    }
+    Tp& operator*() const {
+      return *_container->address(_index);
+    }
+    Tp* operator->() const {
+      return _container->address(_index);
+    }
+    bool operator==(const iterator &other) const {
+      return _container == other._container && _index == other._index;
+    }
+    bool operator==(const const_iterator &other) const {
+      return _container == other._container && _index == other._index;
+    }
+    bool operator!=(const iterator &other) const {
+      return !(*this == other);
+    }
+    bool operator!=(const const_iterator &other) const {
+      return !(*this == other);
+    }
+
+  private:
+    const segmented_vector *_container;
+    size_t _index;
+    iterator(const segmented_vector *container, const size_t &index): _container(container), _index(index) {}
+  };
+  class const_iterator {
+    friend segmented_vector;
+    friend iterator;
+
+  public:
+    using differnce_type = std::ptrdiff_t;
+    using value_type = Tp;
+    using pointer = const Tp*;
+    using reference = const Tp&;
+    using iterator_category = std::output_iterator_tag;
+
+    const_iterator(): _container(nullptr), _index(0) {}
+    const_iterator(const const_iterator &) = default;
+    const_iterator(const iterator &other): _container(other._container), _index(other._index) {}
+    const_iterator& operator=(const const_iterator &) = default;
+    const_iterator operator+(const differnce_type &diff) const {
+      const_iterator res = *this;
+      return res += diff;
+    }
+    const_iterator operator-(const differnce_type &diff) const {
+      const_iterator res = *this;
+      return res -= diff;
+    }
+    // throw invalid_iterator if two containers are not same
+    differnce_type operator-(const const_iterator &other) const {
+      if(_container != other._container)
+        throw invalid_iterator{};
+      return static_cast<differnce_type>(_index) - static_cast<differnce_type>(other._index);
+    }
+    const_iterator& operator+=(const differnce_type &diff) {
+      if(diff < 0) return *this -= -diff;
+      if(_index + diff > _container->size())
+        throw index_out_of_bound{};
+      _index += diff;
+      return *this;
+    }
+    const_iterator& operator-=(const differnce_type &diff) {
+      if(diff < 0) return *this += -diff;
+      if(_index < static_cast<size_t>(diff))
+        throw index_out_of_bound{};
+      _index -= diff;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator tmp = *this;
+      *this += 1;
+      return tmp;
+    }
+    const_iterator& operator++() {
+      return *this += 1;
+    }
+    const_iterator operator--(int) {
+      const_iterator tmp = *this;
+      *this -= 1;
+      return tmp;
+    }
+    const_iterator& operator--() {
+      return *this -= 1;
+    }
+    const Tp& operator*() const {
+      return *_container->address(_index);
+    }
+    const Tp* operator->() const {
+      return _container->address(_index);
+    }
+    bool operator==(const const_iterator &other) const {
+      return _container == other._container && _index == other._index;
+    }
+    bool operator==(const iterator &other) const {
+      return _container == other._container && _index == other._index;
+    }
+    bool operator!=(const const_iterator &other) const {
+      return !(*this == other);
+    }
+    bool operator!=(const iterator &other) const {
+      return !(*this == other);
+    }
+
+  private:
+    const segmented_vector *_container;
+    size_t _index;
+    const_iterator(const segmented_vector *container, const size_t &index): _container(container), _index(index) {}
+  };
+
+  segmented_vector(): _size(0), _segment_count(0) {}
+  // if a copy throws, the destructor cleans up the elements copied so far.
+  segmented_vector(const segmented_vector &other): segmented_vector() {
+    reserve(other._size);
+    for(; _size < other._size; ++_size)
+      new(address(_size)) Tp(*other.address(_size));
+  }
+  // O(1): the segments are handed over.
+  segmented_vector(segmented_vector &&other) noexcept: segmented_vector() {
+    take(other);
+  }
+  ~segmented_vector() {
+    clear();
+    release();
+  }
+  segmented_vector& operator=(const segmented_vector &other) {
+    if(this == &other) return *this;
+    clear();
+    reserve(other._size);
+    for(; _size < other._size; ++_size)
+      new(address(_size)) Tp(*other.address(_size));
+    return *this;
+  }
+  segmented_vector& operator=(segmented_vector &&other) noexcept {
+    if(this == &other) return *this;
+    clear();
+    release();
+    take(other);
+    return *this;
+  }
+
+  // throw index_out_of_bound if pos is not in [0, size)
+  Tp& at(const size_t &pos) {
+    if(pos >= _size)
+      throw index_out_of_bound{};
+    return *address(pos);
+  }
+  // throw index_out_of_bound if pos is not in [0, size)
+  const Tp& at(const size_t &pos) const {
+    if(pos >= _size)
+      throw index_out_of_bound{};
+    return *address(pos);
+  }
+  // throw index_out_of_bound if pos is not in [0, size)
+  Tp& operator[](const size_t &pos) {
+    return at(pos);
+  }
+  // throw index_out_of_bound if pos is not in [0, size)
+  const Tp& operator[](const size_t &pos) const {
+    return at(pos);
+  }
+  // throw container_is_empty if size is 0
+  const Tp& front() const {
+    if(empty())
+      throw container_is_empty{};
+    return *address(0);
+  }
+  // throw container_is_empty if size is 0
+  const Tp& back() const {
+    if(empty())
+      throw container_is_empty{};
+    return *address(_size - 1);
+  }
+  iterator begin() const {
+    return iterator{this, 0};
+  }
+  iterator end() const {
+    return iterator{this, _size};
+  }
+  const_iterator cbegin() const {
+    return const_iterator{this, 0};
+  }
+  const_iterator cend() const {
+    return const_iterator{this, _size};
+  }
+  bool empty() const {
+    return _size == 0;
+  }
+  size_t size() const {
+    return _size;
+  }
+  size_t capacity() const {
+    return segment_begin(_segment_count);
+  }
+  // destroys the elements but keeps the segments.
+  void clear() {
+    for(size_t i = 0; i < _size; ++i)
+      address(i)->~Tp();
+    _size = 0;
+  }
+  // allocates segments until capacity reaches the given one. nothing is moved.
+  void reserve(const size_t &capacity) {
+    while(this->capacity() < capacity)
+      add_segment();
+  }
+  // throw invalid_iterator if iter is not valid
+  // throw index_out_of_bound if iter has an index > size
+  iterator insert(const iterator &iter, const Tp &value) {
+    if(iter._container != this)
+      throw invalid_iterator{};
+    return insert(iter._index, value);
+  }
+  // throw index_out_of_bound if index > size
+  iterator insert(const size_t &index, const Tp &value) {
+    if(index > _size)
+      throw index_out_of_bound{};
+    if(index == _size) {
+      push_back(value);
+      return iterator{this, index};
+    }
+    // value may be an element of this vector, so it's copied before anything shifts.
+    Tp copy(value);
+    if(_size == capacity()) add_segment();
+    new(address(_size)) Tp(std::move(*address(_size - 1)));
+    ++_size;
+    for(size_t i = _size - 2; i > index; --i)
+      *address(i) = std::move(*address(i - 1));
+    count_moves(_size - 1 - index);
+    *address(index) = std::move(copy);
+    return iterator{this, index};
+  }
+  // throw invalid_iterator if iter is not valid
+  // throw index_out_of_bound if iter has an index >= size
+  iterator erase(const iterator &iter) {
+    if(iter._container != this)
+      throw invalid_iterator{};
+    return erase(iter._index);
+  }
+  // throw index_out_of_bound if index >= size
+  iterator erase(const size_t &index) {
+    if(index >= _size)
+      throw index_out_of_bound{};
+    for(size_t i = index; i + 1 < _size; ++i)
+      *address(i) = std::move(*address(i + 1));
+    count_moves(_size - 1 - index);
+    --_size;
+    address(_size)->~Tp();
+    return iterator{this, index};
+  }
+  // nothing moves when a segment is added, so value may be an element of this vector.
+  void push_back(const Tp &value) {
+    if(_size == capacity()) add_segment();
+    new(address(_size)) Tp(value);
+    ++_size;
+  }
+  void push_back(Tp &&value) {
+    if(_size == capacity()) add_segment();
+    new(address(_size)) Tp(std::move(value));
+    ++_size;
+  }
+  // throw container_is_empty if size == 0
+  void pop_back() {
+    if(empty())
+      throw container_is_empty{};
+    --_size;
+    address(_size)->~Tp();
+  }
+  // all zero with no_stats.
+  container_stats stats() const {
+    return snapshot_stats();
+  }
+  void reset_stats() {
+    clear_stats();
+  }
+
+private:
+  // the first segment holds 2^kFirstShift elements.
+  static constexpr size_t kFirstShift = 4;
+  // enough segments for any size_t index.
+  static constexpr size_t kMaxSegments = sizeof(size_t) * CHAR_BIT - kFirstShift;
+
+  static size_t floor_log2(size_t x) {
+#if defined(__GNUC__)
+    return sizeof(unsigned long long) * CHAR_BIT - 1 - __builtin_clzll(x);
+#else
+    size_t res = 0;
+    while(x >>= 1) ++res;
+    return res;
+#endif
+  }
+  // the index of the first element of segment k, which is also the capacity of the segments before it.
+  static size_t segment_begin(size_t k) {
+    return ((size_t(1) << k) - 1) << kFirstShift;
+  }
+  Tp* address(size_t index) const {
+    size_t k = floor_log2((index >> kFirstShift) + 1);
+    return _segments[k] + (index - segment_begin(k));
+  }
+  void add_segment() {
+    if(_segment_count == kMaxSegments)
+      throw runtime_error{};
+    _segments[_segment_count] = allocate(size_t(1) << (kFirstShift + _segment_count));
+    ++_segment_count;
+  }
+  // takes the segments of other, which is left empty without any segment.
+  void take(segmented_vector &other) {
+    for(size_t k = 0; k < other._segment_count; ++k)
+      _segments[k] = other._segments[k];
+    _size = other._size;
+    _segment_count = other._segment_count;
+    other._size = 0;
+    other._segment_count = 0;
+  }
+  // gives all segments back. the elements should be destroyed.
+  void release() {
+    for(size_t k = 0; k < _segment_count; ++k)
+      deallocate(_segments[k]);
+    _segment_count = 0;
+  }
+  // the only place that segmented_vector gets or returns raw memory.
+  Tp* allocate(const size_t &capacity) {
+    count_allocation(capacity * sizeof(Tp));
+    return static_cast<Tp*>(operator new(capacity * sizeof(Tp)));
+  }
+  void deallocate(Tp *data) {
+    count_deallocation();
+    operator delete(data);
+  }
+
+  Tp *_segments[kMaxSegments];
+  size_t _size;
+  size_t _segment_count;
+};
+
+}
+
+#endif
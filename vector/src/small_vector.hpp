@@ -0,0 +1,454 @@
+#ifndef SJTU_SMALL_VECTOR_HPP
+#define SJTU_SMALL_VECTOR_HPP
+
+#include "exceptions.hpp"
+#include "stats.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace sjtu {
+
+/**
+ * a vector keeping up to N elements inside the object itself.
+ * it only allocates once it grows past N, so a small_vector that stays small
+ * never touches the heap; after that it behaves like vector, growing by doubling.
+ * the elements are always contiguous in [data(), data() + size).
+ * unlike vector, it only has room at the back, so insertion and erasure
+ * shift the elements after the position.
+ * moving a small_vector whose elements are inline moves them one by one.
+ */
+template <class Tp, size_t N, class Stats = no_stats>
+class small_vector : private Stats {
+  // the Stats policy is a dependent base, so its calls are brought in by name.
+  using Stats::count_allocation;
+  using Stats::count_deallocation;
+  using Stats::count_reallocation;
+  using Stats::count_moves;
+  using Stats::snapshot_stats;
+  using Stats::clear_stats;
+  static_assert(N > 0, "small_vector needs an inline capacity of at least 1");
+public:
+  class const_iterator;
+  class iterator {
+    friend small_vector;
+    friend const_iterator;
+
+  public:
+    using differnce_type = std::ptrdiff_t;
+    using value_type = Tp;
+    using pointer = Tp*;
+    using reference = Tp&;
+    using iterator_category = std::output_iterator_tag;
+
+    iterator(): _container(nullptr), _index(0) {}
+    iterator(const iterator &) = default;
+    iterator& operator=(const iterator &) = default;
+    iterator operator+(const differnce_type &diff) const {
+      iterator res = *this;
+      return res += diff;
+    }
+    iterator operator-(const differnce_type &diff) const {
+      iterator res = *this;
+      return res -= diff;
+    }
+    // throw invalid_iterator if two containers are not same
+    differnce_type operator-(const iterator &other) const {
+      if(_container != other._container)
+        throw invalid_iterator{};
+      return static_cast<differnce_type>(_index) - static_cast<differnce_type>(other._index);
+    }
+    iterator& operator+=(const differnce_type &diff) {
+      if(diff < 0) return *this -= -diff;
+      if(_index + diff > _container->size())
+        throw index_out_of_bound{};
+      _index += diff;
+      return *this;
+    }
+    iterator& operator-=(const differnce_type &diff) {
+      if(diff < 0) return *this += -diff;
+      if(_index < static_cast<size_t>(diff))
+        throw index_out_of_bound{};
+      _index -= diff;
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator tmp = *this;
+      *this += 1;
+      return tmp;
+    }
+    iterator& operator++() {
+      return *this += 1;
+    }
+    iterator operator--(int) {
+      iterator tmp = *this;
+      *this -= 1;
+      return tmp;
+    }
+    iterator& operator--() {
+      return *this -= 1;
+    }
+    Tp& operator*() const {
+      return _container->_data[_index];
+    }
+    Tp* operator->() const {
+      return _container->_data + _index;
+    }
+    bool operator==(const iterator &other) const {
+      return _container == other._container && _index == other._index;
+    }
+    bool operator==(const const_iterator &other) const {
+      return _container == other._container && _index == other._index;
+    }
+    bool operator!=(const iterator &other) const {
+      return !(*this == other);
+    }
+    bool operator!=(const const_iterator &other) const {
+      return !(*this == other);
+    }
+
+  private:
+    const small_vector *_container;
+    size_t _index;
+    iterator(const small_vector *container, const size_t &index): _container(container), _index(index) {}
+  };
+  class const_iterator {
+    friend small_vector;
+    friend iterator;
+
+  public:
+    using differnce_type = std::ptrdiff_t;
+    using value_type = Tp;
+    using pointer = const Tp*;
+    using reference = const Tp&;
+    using iterator_category = std::output_iterator_tag;
+
+    const_iterator(): _container(nullptr), _index(0) {}
+    const_iterator(const const_iterator &) = default;
+    const_iterator(const iterator &other): _container(other._container), _index(other._index) {}
+    const_iterator& operator=(const const_iterator &) = default;
+    const_iterator operator+(const differnce_type &diff) const {
+      const_iterator res = *this;
+      return res += diff;
+    }
+    const_iterator operator-(const differnce_type &diff) const {
+      const_iterator res = *this;
+      return res -= diff;
+    }
+    // throw invalid_iterator if two containers are not same
+    differnce_type operator-(const const_iterator &other) const {
+      if(_container != other._container)
+        throw invalid_iterator{};
+      return static_cast<differnce_type>(_index) - static_cast<differnce_type>(other._index);
+    }
+    const_iterator& operator+=(const differnce_type &diff) {
+      if(diff < 0) return *this -= -diff;
+      if(_index + diff > _container->size())
+        throw index_out_of_bound{};
+      _index += diff;
+      return *this;
+    }
+    const_iterator& operator-=(const differnce_type &diff) {
+      if(diff < 0) return *this += -diff;
+      if(_index < static_cast<size_t>(diff))
+        throw index_out_of_bound{};
+      _index -= diff;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator tmp = *this;
+      *this += 1;
+      return tmp;
+    }
+    const_iterator& operator++() {
+      return *this += 1;
+    }
+    const_iterator operator--(int) {
+      const_iterator tmp = *this;
+      *this -= 1;
+      return tmp;
+    }
+    const_iterator& operator--() {
+      return *this -= 1;
+    }
+    const Tp& operator*() const {
+      return _container->_data[_index];
+    }
+    const Tp* operator->() const {
+      return _container->_data + _index;
+    }
+    bool operator==(const const_iterator &other) const {
+      return _container == other._container && _index == other._index;
+    }
+    bool operator==(const iterator &other) const {
+      return _container == other._container && _index == other._index;
+    }
+    bool operator!=(const const_iterator &other) const {
+      return !(*this == other);
+    }
+    bool operator!=(const iterator &other) const {
+      return !(*this == other);
+    }
+
+  private:
+    const small_vector *_container;
+    size_t _index;
+    const_iterator(const small_vector *container, const size_t &index): _container(container), _index(index) {}
+  };
+
+  small_vector(): _data(inline_data()), _size(0), _capacity(N) {}
+  small_vector(const small_vector &other): small_vector() {
+    reserve(other._size);
+    for(; _size < other._size; ++_size)
+      new(_data + _size) Tp(other._data[_size]);
+  }
+  small_vector(small_vector &&other) noexcept(std::is_nothrow_move_constructible<Tp>::value)
+    : small_vector() {
+    take(other);
+  }
+  ~small_vector() {
+    clear();
+    release();
+  }
+  small_vector& operator=(const small_vector &other) {
+    if(this == &other) return *this;
+    clear();
+    reserve(other._size);
+    for(; _size < other._size; ++_size)
+      new(_data + _size) Tp(other._data[_size]);
+    return *this;
+  }
+  small_vector& operator=(small_vector &&other) noexcept(std::is_nothrow_move_constructible<Tp>::value) {
+    if(this == &other) return *this;
+    clear();
+    release();
+    take(other);
+    return *this;
+  }
+
+  // throw index_out_of_bound if pos is not in [0, size)
+  Tp& at(const size_t &pos) {
+    if(pos >= _size)
+      throw index_out_of_bound{};
+    return _data[pos];
+  }
+  // throw index_out_of_bound if pos is not in [0, size)
+  const Tp& at(const size_t &pos) const {
+    if(pos >= _size)
+      throw index_out_of_bound{};
+    return _data[pos];
+  }
+  // throw index_out_of_bound if pos is not in [0, size)
+  Tp& operator[](const size_t &pos) {
+    return at(pos);
+  }
+  // throw index_out_of_bound if pos is not in [0, size)
+  const Tp& operator[](const size_t &pos) const {
+    return at(pos);
+  }
+  // throw container_is_empty if size is 0
+  const Tp& front() const {
+    if(empty())
+      throw container_is_empty{};
+    return _data[0];
+  }
+  // throw container_is_empty if size is 0
+  const Tp& back() const {
+    if(empty())
+      throw container_is_empty{};
+    return _data[_size - 1];
+  }
+  // the pointer is invalidated by any insertion or erasure.
+  Tp* data() {
+    return _data;
+  }
+  const Tp* data() const {
+    return _data;
+  }
+  iterator begin() const {
+    return iterator{this, 0};
+  }
+  iterator end() const {
+    return iterator{this, _size};
+  }
+  const_iterator cbegin() const {
+    return const_iterator{this, 0};
+  }
+  const_iterator cend() const {
+    return const_iterator{this, _size};
+  }
+  bool empty() const {
+    return _size == 0;
+  }
+  size_t size() const {
+    return _size;
+  }
+  size_t capacity() const {
+    return _capacity;
+  }
+  // whether the elements are still kept inside the object.
+  bool is_inline() const {
+    return _data == inline_data();
+  }
+  // destroys the elements but keeps the heap buffer, if any.
+  void clear() {
+    for(size_t i = 0; i < _size; ++i)
+      _data[i].~Tp();
+    _size = 0;
+  }
+  void reserve(const size_t &capacity) {
+    if(_capacity >= capacity) return;
+    Tp *new_data = allocate(capacity);
+    size_t i = 0;
+    try {
+      for(; i < _size; ++i)
+        new(new_data + i) Tp(std::move_if_noexcept(_data[i]));
+    } catch(...) {
+      for(size_t j = 0; j < i; ++j)
+        new_data[j].~Tp();
+      deallocate(new_data);
+      throw;
+    }
+    for(size_t j = 0; j < _size; ++j)
+      _data[j].~Tp();
+    count_reallocation();
+    count_moves(_size);
+    release();
+    _data = new_data;
+    _capacity = capacity;
+  }
+  // throw invalid_iterator if iter is not valid
+  // throw index_out_of_bound if iter has an index > size
+  iterator insert(const iterator &iter, const Tp &value) {
+    if(iter._container != this)
+      throw invalid_iterator{};
+    return insert(iter._index, value);
+  }
+  // throw index_out_of_bound if index > size
+  iterator insert(const size_t &index, const Tp &value) {
+    if(index > _size)
+      throw index_out_of_bound{};
+    if(index == _size) {
+      push_back(value);
+      return iterator{this, index};
+    }
+    // value may be an element of this vector, so it's copied before anything moves.
+    Tp copy(value);
+    if(_size == _capacity) grow();
+    new(_data + _size) Tp(std::move(_data[_size - 1]));
+    ++_size;
+    for(size_t i = _size - 2; i > index; --i)
+      _data[i] = std::move(_data[i - 1]);
+    count_moves(_size - 1 - index);
+    _data[index] = std::move(copy);
+    return iterator{this, index};
+  }
+  // throw invalid_iterator if iter is not valid
+  // throw index_out_of_bound if iter has an index >= size
+  iterator erase(const iterator &iter) {
+    if(iter._container != this)
+      throw invalid_iterator{};
+    return erase(iter._index);
+  }
+  // throw index_out_of_bound if index >= size
+  iterator erase(const size_t &index) {
+    if(index >= _size)
+      throw index_out_of_bound{};
+    for(size_t i = index; i + 1 < _size; ++i)
+      _data[i] = std::move(_data[i + 1]);
+    count_moves(_size - 1 - index);
+    --_size;
+    _data[_size].~Tp();
+    return iterator{this, index};
+  }
+  void push_back(const Tp &value) {
+    if(_size == _capacity) {
+      Tp copy(value);
+      grow();
+      new(_data + _size) Tp(std::move(copy));
+    } else {
+      new(_data + _size) Tp(value);
+    }
+    ++_size;
+  }
+  void push_back(Tp &&value) {
+    if(_size == _capacity) {
+      Tp copy(std::move(value));
+      grow();
+      new(_data + _size) Tp(std::move(copy));
+    } else {
+      new(_data + _size) Tp(std::move(value));
+    }
+    ++_size;
+  }
+  // throw container_is_empty if size == 0
+  void pop_back() {
+    if(empty())
+      throw container_is_empty{};
+    --_size;
+    _data[_size].~Tp();
+  }
+  // all zero with no_stats.
+  container_stats stats() const {
+    return snapshot_stats();
+  }
+  void reset_stats() {
+    clear_stats();
+  }
+
+private:
+  Tp* inline_data() {
+    return reinterpret_cast<Tp*>(&_storage);
+  }
+  const Tp* inline_data() const {
+    return reinterpret_cast<const Tp*>(&_storage);
+  }
+  void grow() {
+    reserve(_capacity * 2);
+  }
+  // takes the elements of other, which is left empty and inline.
+  // a heap buffer is stolen; inline elements are moved one by one.
+  void take(small_vector &other) {
+    if(!other.is_inline()) {
+      _data = other._data;
+      _size = other._size;
+      _capacity = other._capacity;
+      other._data = other.inline_data();
+      other._size = 0;
+      other._capacity = N;
+      return;
+    }
+    for(; _size < other._size; ++_size)
+      new(_data + _size) Tp(std::move(other._data[_size]));
+    count_moves(_size);
+    other.clear();
+  }
+  // gives the heap buffer back and returns to the inline storage. the elements should be destroyed.
+  void release() {
+    if(is_inline()) return;
+    deallocate(_data);
+    _data = inline_data();
+    _capacity = N;
+  }
+  // the only place that small_vector gets or returns raw memory.
+  Tp* allocate(const size_t &capacity) {
+    count_allocation(capacity * sizeof(Tp));
+    return static_cast<Tp*>(operator new(capacity * sizeof(Tp)));
+  }
+  void deallocate(Tp *data) {
+    count_deallocation();
+    operator delete(data);
+  }
+
+  typename std::aligned_storage<sizeof(Tp) * N, alignof(Tp)>::type _storage;
+  Tp *_data;
+  size_t _size;
+  size_t _capacity;
+};
+
+}
+
+#endif
@@ -2,17 +2,105 @@
 #define SJTU_VECTOR_HPP
 
 #include "exceptions.hpp"
+#include "stats.hpp"
 
 #include <climits>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 namespace sjtu {
-template <class Tp>
-class vector {
+
+/**
+ * the header of a file written by vector::save, followed by the elements.
+ * it is padded to 64 bytes, so that the elements in a mapped file are aligned.
+ * the file is in native byte order.
+ */
+struct vector_file_header {
+  static constexpr std::uint32_t kVersion = 1;
+
+  char magic[8];
+  std::uint32_t version, element_size;
+  std::uint64_t count;
+  char padding[40];
+
+  static vector_file_header make(size_t element_size, size_t count) {
+    vector_file_header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "SJTUVEC", 8);
+    header.version = kVersion;
+    header.element_size = element_size;
+    header.count = count;
+    return header;
+  }
+  bool matches(size_t element_size_) const {
+    return std::memcmp(magic, "SJTUVEC", 8) == 0 && version == kVersion
+      && element_size == element_size_;
+  }
+};
+static_assert(sizeof(vector_file_header) == 64, "vector_file_header should be 64 bytes");
+
+/**
+ * where a vector gets its buffers from. a storage policy has
+ *   static void* allocate(size_t bytes), which throws std::bad_alloc on failure,
+ *   static void deallocate(void *p, size_t bytes), given the bytes p was allocated with,
+ *   static constexpr size_t data_alignment, see below.
+ * the buffers are at least aligned to data_alignment, and vector places its first element
+ * at a multiple of data_alignment bytes whenever it lays the elements out anew,
+ * that is on reallocation and clear. inserting or erasing at the front moves it.
+ */
+
+// operator new and operator delete; the elements may start anywhere.
+struct heap_storage {
+  static constexpr size_t data_alignment = 1;
+
+  static void* allocate(size_t bytes) {
+    return operator new(bytes);
+  }
+  static void deallocate(void *p, size_t) {
+    operator delete(p);
+  }
+};
+
+// buffers aligned to Align bytes, e.g. 64 for a cache line or aligned SIMD loads.
+// the pointer operator new returned is kept just before the aligned one.
+template <size_t Align>
+struct aligned_heap_storage {
+  static_assert(Align != 0 && (Align & (Align - 1)) == 0, "the alignment should be a power of 2");
+  static constexpr size_t data_alignment = Align;
+
+  static void* allocate(size_t bytes) {
+    const size_t slack = Align - 1 + sizeof(void*);
+    if(bytes > SIZE_MAX - slack)
+      throw std::bad_alloc();
+    void *raw = operator new(bytes + slack);
+    std::uintptr_t aligned = (reinterpret_cast<std::uintptr_t>(raw) + slack) & ~std::uintptr_t(Align - 1);
+    reinterpret_cast<void**>(aligned)[-1] = raw;
+    return reinterpret_cast<void*>(aligned);
+  }
+  static void deallocate(void *p, size_t) {
+    operator delete(static_cast<void**>(p)[-1]);
+  }
+};
+
+template <class Tp, class Storage = heap_storage, class Stats = no_stats>
+class vector : private Stats {
+  // the Stats policy is a dependent base, so its calls are brought in by name.
+  using Stats::count_allocation;
+  using Stats::count_deallocation;
+  using Stats::count_reallocation;
+  using Stats::count_moves;
+  using Stats::snapshot_stats;
+  using Stats::clear_stats;
 public:
   class const_iterator;
   class iterator {
-    friend vector<Tp>;
+    friend vector<Tp, Storage, Stats>;
     friend const_iterator;
 
   public:
@@ -43,12 +131,12 @@ public:
     bool operator!=(const const_iterator &) const;
 
   private:
-    const vector<Tp> *_container;
+    const vector<Tp, Storage, Stats> *_container;
     size_t _index;
-    iterator(const vector<Tp> *container, const size_t &index);
+    iterator(const vector<Tp, Storage, Stats> *container, const size_t &index);
   };
   class const_iterator {
-    friend vector<Tp>;
+    friend vector<Tp, Storage, Stats>;
     friend iterator;
 
   public:
@@ -80,9 +168,9 @@ public:
     bool operator!=(const iterator &) const;
 
   private:
-    const vector<Tp> *_container;
+    const vector<Tp, Storage, Stats> *_container;
     size_t _index;
-    const_iterator(const vector<Tp> *container, const size_t &index);
+    const_iterator(const vector<Tp, Storage, Stats> *container, const size_t &index);
   };
 
   vector();
@@ -103,6 +191,10 @@ public:
   const Tp& front() const;
   // throw container_is_empty if size is 0
   const Tp& back() const;
+  // the elements are contiguous in [data(), data() + size).
+  // the pointer is invalidated by any insertion or erasure.
+  Tp* data();
+  const Tp* data() const;
   iterator begin() const;
   iterator end() const;
   const_iterator cbegin() const;
@@ -110,7 +202,20 @@ public:
   bool empty() const;
   size_t size() const;
   void clear();
+  // if copying an element throws, the vector is left unchanged.
   void reserve(const size_t &capacity);
+  // keeps the first n elements, or appends value-initialized elements until there are n.
+  // if constructing an element throws, the vector is left unchanged.
+  void resize(const size_t &n);
+  // keeps the first n elements, or appends copies of value until there are n.
+  // value may be an element of this vector.
+  void resize(const size_t &n, const Tp &value);
+  // like resize(n), but the new elements are left uninitialized, to be written through data().
+  // only for trivial types, for which that is their default initialization.
+  void resize_uninitialized(const size_t &n);
+  // appends copies of src[0, n), with a single memcpy if Tp is trivially copyable.
+  // src may point into this vector. if a copy throws, the vector is left unchanged.
+  void append(const Tp *src, const size_t &n);
   // throw invalid_iterator if iter is not valid
   // throw index_out_of_bound if iter has an index > size
   iterator insert(const iterator &iter, const Tp &value);
@@ -127,8 +232,41 @@ public:
   void push_back(Tp &&);
   // throw container_is_empty if size == 0
   void pop_back();
+  // all zero with no_stats.
+  container_stats stats() const;
+  void reset_stats();
+  // Tp should be trivially copyable. the file can be mapped by mapped_vector.
+  // throw runtime_error if the file can't be written.
+  void save(const char *path) const;
+  // replaces the content with the file written by save().
+  // throw runtime_error if the file can't be read or holds another type; the vector is unchanged then.
+  void load(const char *path);
 
 private:
+  // moves the elements into a new buffer of the given capacity, starting at new_left.
+  void relocate(const size_t &capacity, const size_t &new_left);
+  // makes room for count more elements after the last one.
+  void reserve_back(const size_t &count);
+  // constructs copies of value after the last element, or none if one throws.
+  void fill_back(const size_t &count, const Tp &value);
+  void destroy_from(const size_t &n);
+  // move-constructs the element at from into the raw slot to, and destroys it at from.
+  void move_slot(const size_t &to, const size_t &from);
+  // makes the elements copies of src[0, n), which fit from _left on.
+  void assign_over(const Tp *src, const size_t &n, std::true_type);
+  void assign_over(const Tp *src, const size_t &n, std::false_type);
+  void append(const Tp *src, const size_t &n, std::true_type);
+  void append(const Tp *src, const size_t &n, std::false_type);
+  // the distance between indices of elements at multiples of Storage::data_alignment bytes.
+  static size_t stride();
+  // rounds index down so that an element there is at a multiple of Storage::data_alignment bytes.
+  static size_t aligned_index(const size_t &index);
+  // where size elements start in a buffer of the given capacity: aligned, near the middle,
+  // and not at 0 unless only the alignment could have put them there.
+  static size_t front_index(const size_t &capacity, const size_t &size);
+  Tp* allocate(const size_t &capacity);
+  void deallocate(Tp *data, const size_t &capacity);
+
   Tp *_data;
   size_t _left, _right;
   size_t _capacity;
@@ -136,50 +274,50 @@ private:
 
 // vector::iterator
 
-template <class Tp>
-vector<Tp>::iterator::iterator()
+template <class Tp, class Storage, class Stats>
+vector<Tp, Storage, Stats>::iterator::iterator()
   : _container(nullptr), _index(0) {}
 
-template <class Tp>
-vector<Tp>::iterator::iterator(const vector<Tp> *container, const size_t &index)
+template <class Tp, class Storage, class Stats>
+vector<Tp, Storage, Stats>::iterator::iterator(const vector<Tp, Storage, Stats> *container, const size_t &index)
   : _container(container), _index(index) {}
 
-template <class Tp>
-vector<Tp>::iterator::iterator(const iterator &) = default;
+template <class Tp, class Storage, class Stats>
+vector<Tp, Storage, Stats>::iterator::iterator(const iterator &) = default;
 
-template <class Tp>
-typename vector<Tp>::iterator&
-  vector<Tp>::iterator::operator=(const iterator &) = default;
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::iterator&
+  vector<Tp, Storage, Stats>::iterator::operator=(const iterator &) = default;
 
-template <class Tp>
-typename vector<Tp>::iterator
-  vector<Tp>::iterator::operator+(const differnce_type &diff) const {
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::iterator
+  vector<Tp, Storage, Stats>::iterator::operator+(const differnce_type &diff) const {
   if(diff < 0) return *this - (-diff);
   if(_index + diff > _container->size())
     throw index_out_of_bound{};
   return iterator{_container, _index + diff};
 }
 
-template <class Tp>
-typename vector<Tp>::iterator
-  vector<Tp>::iterator::operator-(const differnce_type &diff) const {
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::iterator
+  vector<Tp, Storage, Stats>::iterator::operator-(const differnce_type &diff) const {
   if(diff < 0) return *this + (-diff);
   if(_index < diff)
     throw index_out_of_bound{};
   return {_container, _index - diff};
 }
 
-template <class Tp>
-typename vector<Tp>::iterator::differnce_type
-  vector<Tp>::iterator::operator-(const iterator &other) const {
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::iterator::differnce_type
+  vector<Tp, Storage, Stats>::iterator::operator-(const iterator &other) const {
   if(_container != other._container)
     throw invalid_iterator{};
   return static_cast<differnce_type>(_index) - static_cast<differnce_type>(other._index);
 }
 
-template <class Tp>
-typename vector<Tp>::iterator&
-  vector<Tp>::iterator::operator+=(const differnce_type &diff) {
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::iterator&
+  vector<Tp, Storage, Stats>::iterator::operator+=(const differnce_type &diff) {
   if(diff < 0) return *this -= -diff;
   if(_index + diff > _container->size())
     throw index_out_of_bound{};
@@ -187,9 +325,9 @@ typename vector<Tp>::iterator&
   return *this;
 }
 
-template <class Tp>
-typename vector<Tp>::iterator&
-  vector<Tp>::iterator::operator-=(const differnce_type &diff) {
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::iterator&
+  vector<Tp, Storage, Stats>::iterator::operator-=(const differnce_type &diff) {
   if(diff < 0) return *this += -diff;
   if(_index < diff)
     throw index_out_of_bound{};
@@ -197,61 +335,61 @@ typename vector<Tp>::iterator&
   return *this;
 }
 
-template <class Tp>
-typename vector<Tp>::iterator&
-  vector<Tp>::iterator::operator++() {
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::iterator&
+  vector<Tp, Storage, Stats>::iterator::operator++() {
   return *this += 1;
 }
 
-template <class Tp>
-typename vector<Tp>::iterator
-  vector<Tp>::iterator::operator++(int) {
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::iterator
+  vector<Tp, Storage, Stats>::iterator::operator++(int) {
   iterator tmp = *this;
   *this += 1;
   return tmp;
 }
 
-template <class Tp>
-typename vector<Tp>::iterator&
-  vector<Tp>::iterator::operator--() {
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::iterator&
+  vector<Tp, Storage, Stats>::iterator::operator--() {
   return *this -= 1;
 }
 
-template <class Tp>
-typename vector<Tp>::iterator
-  vector<Tp>::iterator::operator--(int) {
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::iterator
+  vector<Tp, Storage, Stats>::iterator::operator--(int) {
   iterator tmp = *this;
   *this -= 1;
   return tmp;
 }
 
-template <class Tp>
-bool vector<Tp>::iterator::operator==(const iterator &other) const {
+template <class Tp, class Storage, class Stats>
+bool vector<Tp, Storage, Stats>::iterator::operator==(const iterator &other) const {
   return _container == other._container && _index == other._index;
 }
 
-template <class Tp>
-bool vector<Tp>::iterator::operator==(const const_iterator &other) const {
+template <class Tp, class Storage, class Stats>
+bool vector<Tp, Storage, Stats>::iterator::operator==(const const_iterator &other) const {
   return _container == other._container && _index == other._index;
 }
 
-template <class Tp>
-bool vector<Tp>::iterator::operator!=(const iterator &other) const {
+template <class Tp, class Storage, class Stats>
+bool vector<Tp, Storage, Stats>::iterator::operator!=(const iterator &other) const {
   return _container != other._container || _index != other._index;
 }
 
-template <class Tp>
-bool vector<Tp>::iterator::operator!=(const const_iterator &other) const {
+template <class Tp, class Storage, class Stats>
+bool vector<Tp, Storage, Stats>::iterator::operator!=(const const_iterator &other) const {
   return _container != other._container || _index != other._index;
 }
 
-template <class Tp>
-Tp& vector<Tp>::iterator::operator*() const {
+template <class Tp, class Storage, class Stats>
+Tp& vector<Tp, Storage, Stats>::iterator::operator*() const {
   return _container->_data[_container->_left + _index];
 }
 
-template <class Tp>
-Tp* vector<Tp>::iterator::operator->() const {
+template <class Tp, class Storage, class Stats>
+Tp* vector<Tp, Storage, Stats>::iterator::operator->() const {
   return _container->_data + _container->_left + _index;
 }
 
@@ -259,54 +397,54 @@ Tp* vector<Tp>::iterator::operator->() const {
 
 // vector::const_iterator
 
-template <class Tp>
-vector<Tp>::const_iterator::const_iterator()
+template <class Tp, class Storage, class Stats>
+vector<Tp, Storage, Stats>::const_iterator::const_iterator()
   : _container(nullptr), _index(0) {}
 
-template <class Tp>
-vector<Tp>::const_iterator::const_iterator(const vector<Tp> *container, const size_t &index)
+template <class Tp, class Storage, class Stats>
+vector<Tp, Storage, Stats>::const_iterator::const_iterator(const vector<Tp, Storage, Stats> *container, const size_t &index)
   : _container(container), _index(index) {}
 
-template <class Tp>
-vector<Tp>::const_iterator::const_iterator(const const_iterator &) = default;
+template <class Tp, class Storage, class Stats>
+vector<Tp, Storage, Stats>::const_iterator::const_iterator(const const_iterator &) = default;
 
-template <class Tp>
-vector<Tp>::const_iterator::const_iterator(const iterator &other)
+template <class Tp, class Storage, class Stats>
+vector<Tp, Storage, Stats>::const_iterator::const_iterator(const iterator &other)
   : _container(other._container), _index(other._index) {}
 
-template <class Tp>
-typename vector<Tp>::const_iterator&
-  vector<Tp>::const_iterator::operator=(const const_iterator &) = default;
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::const_iterator&
+  vector<Tp, Storage, Stats>::const_iterator::operator=(const const_iterator &) = default;
 
-template <class Tp>
-typename vector<Tp>::const_iterator
-  vector<Tp>::const_iterator::operator+(const differnce_type &diff) const {
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::const_iterator
+  vector<Tp, Storage, Stats>::const_iterator::operator+(const differnce_type &diff) const {
   if(diff < 0) return *this - (-diff);
   if(_index + diff > _container->size())
     throw index_out_of_bound{};
   return {_container, _index + diff};
 }
 
-template <class Tp>
-typename vector<Tp>::const_iterator
-  vector<Tp>::const_iterator::operator-(const differnce_type &diff) const {
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::const_iterator
+  vector<Tp, Storage, Stats>::const_iterator::operator-(const differnce_type &diff) const {
   if(diff < 0) return *this + (-diff);
   if(_index < diff)
     throw index_out_of_bound{};
   return {_container, _index - diff};
 }
 
-template <class Tp>
-typename vector<Tp>::const_iterator::differnce_type
-  vector<Tp>::const_iterator::operator-(const const_iterator &other) const {
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::const_iterator::differnce_type
+  vector<Tp, Storage, Stats>::const_iterator::operator-(const const_iterator &other) const {
   if(_container != other._container)
     throw invalid_iterator{};
   return static_cast<differnce_type>(_index) - static_cast<differnce_type>(other._index);
 }
 
-template <class Tp>
-typename vector<Tp>::const_iterator&
-  vector<Tp>::const_iterator::operator+=(const differnce_type &diff) {
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::const_iterator&
+  vector<Tp, Storage, Stats>::const_iterator::operator+=(const differnce_type &diff) {
   if(diff < 0) return *this -= -diff;
   if(_index + diff > _container->size())
     throw index_out_of_bound{};
@@ -314,9 +452,9 @@ typename vector<Tp>::const_iterator&
   return *this;
 }
 
-template <class Tp>
-typename vector<Tp>::const_iterator&
-  vector<Tp>::const_iterator::operator-=(const differnce_type &diff) {
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::const_iterator&
+  vector<Tp, Storage, Stats>::const_iterator::operator-=(const differnce_type &diff) {
   if(diff < 0) return *this += -diff;
   if(_index < diff)
     throw index_out_of_bound{};
@@ -324,61 +462,61 @@ typename vector<Tp>::const_iterator&
   return *this;
 }
 
-template <class Tp>
-typename vector<Tp>::const_iterator&
-  vector<Tp>::const_iterator::operator++() {
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::const_iterator&
+  vector<Tp, Storage, Stats>::const_iterator::operator++() {
   return *this += 1;
 }
 
-template <class Tp>
-typename vector<Tp>::const_iterator
-  vector<Tp>::const_iterator::operator++(int) {
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::const_iterator
+  vector<Tp, Storage, Stats>::const_iterator::operator++(int) {
   iterator tmp = *this;
   *this += 1;
   return tmp;
 }
 
-template <class Tp>
-typename vector<Tp>::const_iterator&
-  vector<Tp>::const_iterator::operator--() {
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::const_iterator&
+  vector<Tp, Storage, Stats>::const_iterator::operator--() {
   return *this -= 1;
 }
 
-template <class Tp>
-typename vector<Tp>::const_iterator
-  vector<Tp>::const_iterator::operator--(int) {
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::const_iterator
+  vector<Tp, Storage, Stats>::const_iterator::operator--(int) {
   iterator tmp = *this;
   *this -= 1;
   return tmp;
 }
 
-template <class Tp>
-bool vector<Tp>::const_iterator::operator==(const const_iterator &other) const {
+template <class Tp, class Storage, class Stats>
+bool vector<Tp, Storage, Stats>::const_iterator::operator==(const const_iterator &other) const {
   return _container == other._container && _index == other._index;
 }
 
-template <class Tp>
-bool vector<Tp>::const_iterator::operator==(const iterator &other) const {
+template <class Tp, class Storage, class Stats>
+bool vector<Tp, Storage, Stats>::const_iterator::operator==(const iterator &other) const {
   return _container == other._container && _index == other._index;
 }
 
-template <class Tp>
-bool vector<Tp>::const_iterator::operator!=(const const_iterator &other) const {
+template <class Tp, class Storage, class Stats>
+bool vector<Tp, Storage, Stats>::const_iterator::operator!=(const const_iterator &other) const {
   return _container != other._container || _index != other._index;
 }
 
-template <class Tp>
-bool vector<Tp>::const_iterator::operator!=(const iterator &other) const {
+template <class Tp, class Storage, class Stats>
+bool vector<Tp, Storage, Stats>::const_iterator::operator!=(const iterator &other) const {
   return _container != other._container || _index != other._index;
 }
 
-template <class Tp>
-const Tp& vector<Tp>::const_iterator::operator*() const {
+template <class Tp, class Storage, class Stats>
+const Tp& vector<Tp, Storage, Stats>::const_iterator::operator*() const {
   return _container->_data[_container->_left + _index];
 }
 
-template <class Tp>
-const Tp* vector<Tp>::const_iterator::operator->() const {
+template <class Tp, class Storage, class Stats>
+const Tp* vector<Tp, Storage, Stats>::const_iterator::operator->() const {
   return _container->_data + _container->_left + _index;
 }
 
@@ -387,23 +525,23 @@ const Tp* vector<Tp>::const_iterator::operator->() const {
 
 // vector
 
-template <class Tp>
-vector<Tp>::vector()
+template <class Tp, class Storage, class Stats>
+vector<Tp, Storage, Stats>::vector()
   : _data(nullptr), _left(0), _right(0), _capacity(0) {}
 
-template <class Tp>
-vector<Tp>::vector(const vector &other): vector() {
+template <class Tp, class Storage, class Stats>
+vector<Tp, Storage, Stats>::vector(const vector &other): vector() {
   if(other.empty()) return;
-  _left = other._left;
-  _right = other._right;
   _capacity = other._capacity;
-  _data = static_cast<Tp*>(operator new(_capacity * sizeof(Tp)));
-  for(size_t i = _left; i < _right; ++i)
-    new(_data + i) Tp(other._data[i]);
+  _data = allocate(_capacity);
+  // if a copy throws, the destructor cleans up the elements in [_left, _right).
+  _left = _right = other._left;
+  for(; _right < other._right; ++_right)
+    new(_data + _right) Tp(other._data[_right]);
 }
 
-template <class Tp>
-vector<Tp>::vector(vector &&other) noexcept: vector() {
+template <class Tp, class Storage, class Stats>
+vector<Tp, Storage, Stats>::vector(vector &&other) noexcept: vector() {
   if(other.empty()) return;
   _left = other._left;
   _right = other._right;
@@ -415,33 +553,72 @@ vector<Tp>::vector(vector &&other) noexcept: vector() {
   other._data = nullptr;
 }
 
-template <class Tp>
-vector<Tp>::~vector() {
+template <class Tp, class Storage, class Stats>
+vector<Tp, Storage, Stats>::~vector() {
   clear();
-  operator delete(_data);
+  deallocate(_data, _capacity);
   _data = nullptr;
   _left = 0;
   _right = 0;
   _capacity = 0;
 }
 
-template <class Tp>
-vector<Tp>& vector<Tp>::operator=(const vector &other) {
+// the buffer is kept if the elements of other fit in it; trivially copyable elements
+// are then copied over with one memcpy, the others are destroyed and copy-constructed.
+// only a new buffer gives the strong guarantee.
+template <class Tp, class Storage, class Stats>
+vector<Tp, Storage, Stats>& vector<Tp, Storage, Stats>::operator=(const vector &other) {
   if(this == &other) return *this;
-  clear();
-  reserve(other._capacity);
-  for(size_t i = _left; i < other._right; ++i)
-    new(_data + i) Tp(other._data[i]);
-  _left = other._left;
-  _right = other._right;
+  size_t n = other.size();
+  if(n > _capacity) {
+    // the old elements are only let go once all the copies are made.
+    Tp *data = allocate(n);
+    size_t i = 0;
+    try {
+      for(; i < n; ++i)
+        new(data + i) Tp(other._data[other._left + i]);
+    } catch(...) {
+      for(size_t j = 0; j < i; ++j)
+        data[j].~Tp();
+      deallocate(data, n);
+      throw;
+    }
+    clear();
+    deallocate(_data, _capacity);
+    _data = data;
+    _left = 0;
+    _right = _capacity = n;
+    return *this;
+  }
+  if(_left + n > _capacity) {
+    // they only fit from further to the front.
+    clear();
+    _left = _right = aligned_index((_capacity - n) / 2);
+  }
+  assign_over(other._data + other._left, n, std::is_trivially_copyable<Tp>());
   return *this;
 }
 
-template <class Tp>
-vector<Tp>& vector<Tp>::operator=(vector &&other) {
-  if(this == other) return *this;
+template <class Tp, class Storage, class Stats>
+void vector<Tp, Storage, Stats>::assign_over(const Tp *src, const size_t &n, std::true_type) {
+  if(n != 0) std::memcpy(static_cast<void*>(_data + _left), src, n * sizeof(Tp));
+  _right = _left + n;
+}
+
+template <class Tp, class Storage, class Stats>
+void vector<Tp, Storage, Stats>::assign_over(const Tp *src, const size_t &n, std::false_type) {
+  // rebuilt rather than assigned over, so that Tp needs no copy assignment.
+  destroy_from(0);
+  // _right only covers the elements constructed so far, in case a copy throws.
+  for(; _right < _left + n; ++_right)
+    new(_data + _right) Tp(src[_right - _left]);
+}
+
+template <class Tp, class Storage, class Stats>
+vector<Tp, Storage, Stats>& vector<Tp, Storage, Stats>::operator=(vector &&other) {
+  if(this == &other) return *this;
   clear();
-  operator delete(_data);
+  deallocate(_data, _capacity);
   _data = other._data;
   _left = other._left;
   _right = other._right;
@@ -453,180 +630,472 @@ vector<Tp>& vector<Tp>::operator=(vector &&other) {
   return *this;
 }
 
-template <class Tp>
-Tp& vector<Tp>::at(const size_t &pos) {
+template <class Tp, class Storage, class Stats>
+Tp& vector<Tp, Storage, Stats>::at(const size_t &pos) {
   if(pos >= size())
     throw index_out_of_bound{};
   return _data[_left + pos];
 }
 
-template <class Tp>
-const Tp& vector<Tp>::at(const size_t &pos) const {
+template <class Tp, class Storage, class Stats>
+const Tp& vector<Tp, Storage, Stats>::at(const size_t &pos) const {
   if(pos >= size())
     throw index_out_of_bound{};
   return _data[_left + pos];
 }
 
-template <class Tp>
-Tp& vector<Tp>::operator[](const size_t &pos) {
+template <class Tp, class Storage, class Stats>
+Tp& vector<Tp, Storage, Stats>::operator[](const size_t &pos) {
   if(pos >= size())
     throw index_out_of_bound{};
   return _data[_left + pos];
 }
 
-template <class Tp>
-const Tp& vector<Tp>::operator[](const size_t &pos) const {
+template <class Tp, class Storage, class Stats>
+const Tp& vector<Tp, Storage, Stats>::operator[](const size_t &pos) const {
   if(pos >= size())
     throw index_out_of_bound{};
   return _data[_left + pos];
 }
 
-template <class Tp>
-const Tp& vector<Tp>::front() const {
+template <class Tp, class Storage, class Stats>
+const Tp& vector<Tp, Storage, Stats>::front() const {
   if(empty())
     throw container_is_empty{};
   return _data[_left];
 }
 
-template <class Tp>
-const Tp& vector<Tp>::back() const {
+template <class Tp, class Storage, class Stats>
+const Tp& vector<Tp, Storage, Stats>::back() const {
   if(empty())
     throw container_is_empty{};
   return _data[_right - 1];
 }
 
-template <class Tp>
-typename vector<Tp>::iterator
-  vector<Tp>::begin() const {
+template <class Tp, class Storage, class Stats>
+Tp* vector<Tp, Storage, Stats>::data() {
+  return _data + _left;
+}
+
+template <class Tp, class Storage, class Stats>
+const Tp* vector<Tp, Storage, Stats>::data() const {
+  return _data + _left;
+}
+
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::iterator
+  vector<Tp, Storage, Stats>::begin() const {
   return iterator{this, 0};
 }
 
-template <class Tp>
-typename vector<Tp>::iterator
-  vector<Tp>::end() const {
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::iterator
+  vector<Tp, Storage, Stats>::end() const {
   return iterator{this, size()};
 }
 
-template <class Tp>
-typename vector<Tp>::const_iterator
-  vector<Tp>::cbegin() const {
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::const_iterator
+  vector<Tp, Storage, Stats>::cbegin() const {
   return const_iterator{this, 0};
 }
 
-template <class Tp>
-typename vector<Tp>::const_iterator
-  vector<Tp>::cend() const {
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::const_iterator
+  vector<Tp, Storage, Stats>::cend() const {
   return const_iterator{this, size()};
 }
 
-template <class Tp>
-typename vector<Tp>::iterator
-  vector<Tp>::insert(const iterator &iter, const Tp &value) {
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::iterator
+  vector<Tp, Storage, Stats>::insert(const iterator &iter, const Tp &value) {
   if(iter._container != this)
     throw invalid_iterator{};
   return insert(iter._index, value);
 }
 
-template <class Tp>
-typename vector<Tp>::iterator
-  vector<Tp>::insert(const size_t &index, const Tp &value) {
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::iterator
+  vector<Tp, Storage, Stats>::insert(const size_t &index, const Tp &value) {
   if(index > size())
     throw index_out_of_bound{};
+  // value may be an element of this vector, so it's copied before anything moves.
+  Tp copy(value);
+  // the elements are shifted one by one into the free slot next to them, so they are
+  // only ever move-constructed. the free slot, or hole, ends up at index.
+  // if a move throws, the elements beyond the hole are dropped, so that the rest stays contiguous.
   if(index > size() / 2) {
     if(_right == _capacity)
       reserve((_capacity + 1) * 2);
+    size_t hole = _right;
+    try {
+      for(; hole > _left + index; --hole) move_slot(hole, hole - 1);
+      new (_data + hole) Tp(std::move(copy));
+    } catch(...) {
+      for(size_t i = hole + 1; i <= _right; ++i) _data[i].~Tp();
+      _right = hole;
+      throw;
+    }
+    count_moves(size() - index);
     ++_right;
-    for(size_t i = _right - 1; i > _left + index; --i)
-      new (_data + i) Tp(std::move(_data[i - 1]));
   } else {
-    if(_left == 0)
-      reserve((_capacity + 1) * 2);
+    if(_left == 0) {
+      // room for a whole stride, so that the aligned first element can't be at 0 again.
+      size_t capacity = (_capacity + 1) * 2;
+      if(capacity < size() + 2 * stride()) capacity = size() + 2 * stride();
+      reserve(capacity);
+    }
+    size_t hole = _left - 1;
+    try {
+      for(; hole < _left - 1 + index; ++hole) move_slot(hole, hole + 1);
+      new (_data + hole) Tp(std::move(copy));
+    } catch(...) {
+      for(size_t i = _left - 1; i < hole; ++i) _data[i].~Tp();
+      _left = hole + 1;
+      throw;
+    }
+    count_moves(index);
     --_left;
-    for(size_t i = _left; i < _left + index; ++i)
-      new(_data + i) Tp(std::move(_data[i + 1]));
   }
-  new (_data + _left + index) Tp(value);
   return iterator{this, index};
 }
 
-template <class Tp>
-typename vector<Tp>::iterator vector<Tp>::erase(const iterator &iter) {
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::iterator vector<Tp, Storage, Stats>::erase(const iterator &iter) {
   if(iter._container != this)
     throw invalid_iterator{};
   return erase(iter._index);
 }
 
-template <class Tp>
-typename vector<Tp>::iterator vector<Tp>::erase(const size_t &index) {
+template <class Tp, class Storage, class Stats>
+typename vector<Tp, Storage, Stats>::iterator vector<Tp, Storage, Stats>::erase(const size_t &index) {
   if(index >= size())
     throw index_out_of_bound{};
-  _data[index].~Tp();
+  // the erased element leaves a hole, which the shorter side is shifted into, as in insert.
+  size_t hole = _left + index;
+  _data[hole].~Tp();
   if(index > size() / 2) {
-    for(size_t i = _left + index; i < _right - 1; ++i)
-      new (_data + i) Tp(std::move(_data[i + 1]));
+    count_moves(size() - 1 - index);
+    try {
+      for(; hole < _right - 1; ++hole) move_slot(hole, hole + 1);
+    } catch(...) {
+      for(size_t i = hole + 1; i < _right; ++i) _data[i].~Tp();
+      _right = hole;
+      throw;
+    }
     --_right;
   } else {
-    for(size_t i = _left + index; i > _left; --i)
-      new (_data + i) Tp(std::move(_data[i - 1]));
+    count_moves(index);
+    try {
+      for(; hole > _left; --hole) move_slot(hole, hole - 1);
+    } catch(...) {
+      for(size_t i = _left; i < hole; ++i) _data[i].~Tp();
+      _left = hole + 1;
+      throw;
+    }
     ++_left;
   }
   return {this, index};
 }
 
-template <class Tp>
-void vector<Tp>::push_back(const Tp &value) {
-  if(_right == _capacity) reserve((_capacity + 1) * 2);
-  new (_data + _right) Tp(value);
+// value may be an element of this vector, so it's taken out before a reallocation.
+template <class Tp, class Storage, class Stats>
+void vector<Tp, Storage, Stats>::push_back(const Tp &value) {
+  if(_right == _capacity) {
+    Tp copy(value);
+    reserve((_capacity + 1) * 2);
+    new (_data + _right) Tp(std::move(copy));
+  } else {
+    new (_data + _right) Tp(value);
+  }
   ++_right;
 }
 
-template <class Tp>
-void vector<Tp>::push_back(Tp &&value) {
-  if(_right == _capacity) reserve((_capacity + 1) * 2);
-  new (_data + _right) Tp(value);
+template <class Tp, class Storage, class Stats>
+void vector<Tp, Storage, Stats>::push_back(Tp &&value) {
+  if(_right == _capacity) {
+    Tp copy(std::move(value));
+    reserve((_capacity + 1) * 2);
+    new (_data + _right) Tp(std::move(copy));
+  } else {
+    new (_data + _right) Tp(std::move(value));
+  }
   ++_right;
 }
 
-template <class Tp>
-void vector<Tp>::pop_back() {
+template <class Tp, class Storage, class Stats>
+void vector<Tp, Storage, Stats>::pop_back() {
   if(empty())
     throw container_is_empty{};
   --_right;
   _data[_right].~Tp();
 }
 
-template <class Tp>
-bool vector<Tp>::empty() const {
+template <class Tp, class Storage, class Stats>
+bool vector<Tp, Storage, Stats>::empty() const {
   return _right - _left == 0;
 }
 
-template <class Tp>
-size_t vector<Tp>::size() const {
+template <class Tp, class Storage, class Stats>
+size_t vector<Tp, Storage, Stats>::size() const {
   return _right - _left;
 }
 
-template <class Tp>
-void vector<Tp>::clear() {
+template <class Tp, class Storage, class Stats>
+void vector<Tp, Storage, Stats>::clear() {
   for(size_t i = _left; i < _right; ++i)
     _data[i].~Tp();
-  _left = _right = _capacity / 2;
+  _left = _right = front_index(_capacity, 0);
 }
 
-template <class Tp>
-void vector<Tp>::reserve(const size_t &capacity) {
+template <class Tp, class Storage, class Stats>
+void vector<Tp, Storage, Stats>::reserve(const size_t &capacity) {
   if(_capacity >= capacity) return;
-  Tp *new_data = static_cast<Tp*>(operator new(capacity * sizeof(Tp)));
+  relocate(capacity, front_index(capacity, size()));
+}
+
+template <class Tp, class Storage, class Stats>
+void vector<Tp, Storage, Stats>::resize(const size_t &n) {
+  if(n <= size()) {
+    destroy_from(n);
+    return;
+  }
+  reserve_back(n - size());
+  size_t i = _right;
+  try {
+    for(; i < _left + n; ++i)
+      new (_data + i) Tp();
+  } catch(...) {
+    for(size_t j = _right; j < i; ++j)
+      _data[j].~Tp();
+    throw;
+  }
+  _right = _left + n;
+}
+
+// value may be an element of this vector, so it's copied before a reallocation.
+template <class Tp, class Storage, class Stats>
+void vector<Tp, Storage, Stats>::resize(const size_t &n, const Tp &value) {
+  if(n <= size()) {
+    destroy_from(n);
+    return;
+  }
+  size_t count = n - size();
+  if(_capacity - _right < count) {
+    Tp copy(value);
+    reserve_back(count);
+    fill_back(count, copy);
+  } else {
+    fill_back(count, value);
+  }
+}
+
+template <class Tp, class Storage, class Stats>
+void vector<Tp, Storage, Stats>::resize_uninitialized(const size_t &n) {
+  static_assert(std::is_trivial<Tp>::value, "only trivial elements can be left uninitialized");
+  if(n <= size()) {
+    _right = _left + n;
+    return;
+  }
+  reserve_back(n - size());
+  _right = _left + n;
+}
+
+template <class Tp, class Storage, class Stats>
+void vector<Tp, Storage, Stats>::append(const Tp *src, const size_t &n) {
+  if(n == 0) return;
+  if(_capacity - _right < n) {
+    // a source inside this vector moves with the elements.
+    std::less<const Tp*> before;
+    bool inside = !before(src, _data + _left) && before(src, _data + _right);
+    size_t offset = inside ? src - (_data + _left) : 0;
+    reserve_back(n);
+    if(inside) src = _data + _left + offset;
+  }
+  append(src, n, std::is_trivially_copyable<Tp>());
+}
+
+template <class Tp, class Storage, class Stats>
+void vector<Tp, Storage, Stats>::append(const Tp *src, const size_t &n, std::true_type) {
+  std::memcpy(static_cast<void*>(_data + _right), src, n * sizeof(Tp));
+  _right += n;
+}
+
+template <class Tp, class Storage, class Stats>
+void vector<Tp, Storage, Stats>::append(const Tp *src, const size_t &n, std::false_type) {
+  size_t i = 0;
+  try {
+    for(; i < n; ++i)
+      new (_data + _right + i) Tp(src[i]);
+  } catch(...) {
+    for(size_t j = 0; j < i; ++j)
+      _data[_right + j].~Tp();
+    throw;
+  }
+  _right += n;
+}
+
+template <class Tp, class Storage, class Stats>
+void vector<Tp, Storage, Stats>::fill_back(const size_t &count, const Tp &value) {
+  size_t i = 0;
+  try {
+    for(; i < count; ++i)
+      new (_data + _right + i) Tp(value);
+  } catch(...) {
+    for(size_t j = 0; j < i; ++j)
+      _data[_right + j].~Tp();
+    throw;
+  }
+  _right += count;
+}
+
+template <class Tp, class Storage, class Stats>
+void vector<Tp, Storage, Stats>::destroy_from(const size_t &n) {
+  for(size_t i = _left + n; i < _right; ++i)
+    _data[i].~Tp();
+  _right = _left + n;
+}
+
+template <class Tp, class Storage, class Stats>
+void vector<Tp, Storage, Stats>::move_slot(const size_t &to, const size_t &from) {
+  new (_data + to) Tp(std::move(_data[from]));
+  _data[from].~Tp();
+}
+
+// grows as push_back does, or to just enough room if that's more.
+// the room before the first element is kept as far as it fits.
+template <class Tp, class Storage, class Stats>
+void vector<Tp, Storage, Stats>::reserve_back(const size_t &count) {
+  if(_capacity - _right >= count) return;
+  size_t needed = size() + count, capacity = (_capacity + 1) * 2;
+  if(capacity < needed) capacity = needed;
+  relocate(capacity, aligned_index(_left < capacity - needed ? _left : capacity - needed));
+}
+
+template <class Tp, class Storage, class Stats>
+void vector<Tp, Storage, Stats>::relocate(const size_t &capacity, const size_t &new_left) {
+  Tp *new_data = allocate(capacity);
   size_t old_size = size();
-  size_t new_left = capacity / 2 - old_size / 2;
-  for(size_t i = 0; i < old_size; ++i)
-    new (new_data + new_left + i) Tp(std::move(_data[_left + i]));
-  operator delete(_data);
+  // elements are only moved if that can't throw; otherwise they are copied,
+  // so that the vector is untouched if a copy throws.
+  size_t i = 0;
+  try {
+    for(; i < old_size; ++i)
+      new (new_data + new_left + i) Tp(std::move_if_noexcept(_data[_left + i]));
+  } catch(...) {
+    for(size_t j = 0; j < i; ++j)
+      new_data[new_left + j].~Tp();
+    deallocate(new_data, capacity);
+    throw;
+  }
+  for(size_t j = _left; j < _right; ++j)
+    _data[j].~Tp();
+  if(_data != nullptr) {
+    count_reallocation();
+    count_moves(old_size);
+  }
+  deallocate(_data, _capacity);
   _left = new_left;
   _right = new_left + old_size;
   _data = new_data;
   _capacity = capacity;
 }
 
+template <class Tp, class Storage, class Stats>
+container_stats vector<Tp, Storage, Stats>::stats() const {
+  return snapshot_stats();
+}
+
+template <class Tp, class Storage, class Stats>
+void vector<Tp, Storage, Stats>::reset_stats() {
+  clear_stats();
+}
+
+template <class Tp, class Storage, class Stats>
+void vector<Tp, Storage, Stats>::save(const char *path) const {
+  static_assert(std::is_trivially_copyable<Tp>::value, "only trivially copyable elements can be saved");
+  std::FILE *file = std::fopen(path, "wb");
+  if(file == nullptr)
+    throw runtime_error{};
+  vector_file_header header = vector_file_header::make(sizeof(Tp), size());
+  bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1
+    && (empty() || std::fwrite(_data + _left, sizeof(Tp), size(), file) == size());
+  if(std::fclose(file) != 0 || !ok)
+    throw runtime_error{};
+}
+
+template <class Tp, class Storage, class Stats>
+void vector<Tp, Storage, Stats>::load(const char *path) {
+  static_assert(std::is_trivially_copyable<Tp>::value, "only trivially copyable elements can be loaded");
+  std::FILE *file = std::fopen(path, "rb");
+  if(file == nullptr)
+    throw runtime_error{};
+  vector_file_header header;
+  if(std::fread(&header, sizeof(header), 1, file) != 1 || !header.matches(sizeof(Tp))) {
+    std::fclose(file);
+    throw runtime_error{};
+  }
+  // the count is checked against the file size before anything is allocated,
+  // so a corrupt or truncated header can't ask for a huge or wrapped-around buffer.
+  long file_size = -1;
+  if(std::fseek(file, 0, SEEK_END) == 0) file_size = std::ftell(file);
+  if(file_size < static_cast<long>(sizeof(header))
+    || header.count > (static_cast<std::uint64_t>(file_size) - sizeof(header)) / sizeof(Tp)
+    || std::fseek(file, sizeof(header), SEEK_SET) != 0) {
+    std::fclose(file);
+    throw runtime_error{};
+  }
+  size_t count = header.count;
+  Tp *new_data = (count == 0) ? nullptr : allocate(count);
+  if(count != 0 && std::fread(new_data, sizeof(Tp), count, file) != count) {
+    deallocate(new_data, count);
+    std::fclose(file);
+    throw runtime_error{};
+  }
+  std::fclose(file);
+  clear();
+  deallocate(_data, _capacity);
+  _data = new_data;
+  _left = 0;
+  _right = _capacity = count;
+}
+
+// the offsets of aligned elements are the multiples of the least common multiple
+// of sizeof(Tp) and the alignment, which is a power of 2.
+template <class Tp, class Storage, class Stats>
+size_t vector<Tp, Storage, Stats>::stride() {
+  size_t common = Storage::data_alignment;
+  while(sizeof(Tp) % common != 0) common /= 2;
+  return Storage::data_alignment / common;
+}
+
+template <class Tp, class Storage, class Stats>
+size_t vector<Tp, Storage, Stats>::aligned_index(const size_t &index) {
+  return index - index % stride();
+}
+
+template <class Tp, class Storage, class Stats>
+size_t vector<Tp, Storage, Stats>::front_index(const size_t &capacity, const size_t &size) {
+  size_t middle = capacity / 2 - size / 2, index = aligned_index(middle);
+  // the room left after the elements is kept non-empty too, as push_back relies on it.
+  if(index == 0 && middle != 0 && stride() + size < capacity) index = stride();
+  return index;
+}
+
+// the only place that vector gets or returns raw memory.
+template <class Tp, class Storage, class Stats>
+Tp* vector<Tp, Storage, Stats>::allocate(const size_t &capacity) {
+  count_allocation(capacity * sizeof(Tp));
+  return static_cast<Tp*>(Storage::allocate(capacity * sizeof(Tp)));
+}
+
+template <class Tp, class Storage, class Stats>
+void vector<Tp, Storage, Stats>::deallocate(Tp *data, const size_t &capacity) {
+  if(data == nullptr) return;
+  count_deallocation();
+  Storage::deallocate(data, capacity * sizeof(Tp));
+}
+
 }
 
 #endif